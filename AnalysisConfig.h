@@ -0,0 +1,99 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <vector>
+
+// 每个实例可选的 STFT 分析设置：FFT 点数 / overlap / 窗函数 / 是否先重采样到固定采样率
+// 实时分析 (AnalysisPlan) 和 capture 后的整段分析 (AnalysisWorker) 用同一份配置
+struct AnalysisConfig
+{
+    enum class Window : int
+    {
+        Hann = 0,
+        BlackmanHarris,
+        Kaiser
+    };
+
+    static constexpr int kMinFftOrder = 9;       // 512
+    static constexpr int kMaxFftOrder = 14;      // 16384
+    static constexpr float kMinOverlap = 0.5f;
+    static constexpr float kMaxOverlap = 0.875f;
+    static constexpr float kKaiserBeta = 8.0f;   // 旁瓣约 -60 dB
+
+    // 打开 resampleToCanonicalRate 时分析统一在这个采样率上做，特征值不随 session 采样率变。
+    // CPU 不是和 48k 完全一样：分析部分相同，另加降采样本身的开销。
+    // AnalysisPlanBench 实测（默认配置，立体声）96k 多约 0.7 ms/s，192k 多约 1.7 ms/s，
+    // 仍比原生速率分析省得多（192k 约 13 ms/s 对 33 ms/s）
+    static constexpr double kCanonicalSampleRate = 48000.0;
+
+    // 默认值就是原来写死的 2048 点 / hop 512 / Hann
+    int fftOrder = 11;
+    float overlap = 0.75f;
+    Window window = Window::Hann;
+    bool resampleToCanonicalRate = false;
+
+    int getFftSize() const noexcept { return 1 << fftOrder; }
+
+    int getHopSize() const noexcept
+    {
+        return juce::jlimit (1, getFftSize(), juce::roundToInt ((float) getFftSize() * (1.0f - overlap)));
+    }
+
+    // 实际做分析的采样率
+    double getAnalysisSampleRate (double hostSampleRate) const noexcept
+    {
+        return resampleToCanonicalRate ? kCanonicalSampleRate : hostSampleRate;
+    }
+
+    // 裁到支持的范围 (从 state / UI 来的值都先过一遍)
+    AnalysisConfig withValidatedRanges() const noexcept
+    {
+        auto c = *this;
+        c.fftOrder = juce::jlimit (kMinFftOrder, kMaxFftOrder, fftOrder);
+        c.overlap = juce::jlimit (kMinOverlap, kMaxOverlap, overlap);
+
+        if (c.window != Window::BlackmanHarris && c.window != Window::Kaiser)
+            c.window = Window::Hann;
+
+        return c;
+    }
+
+    // 填窗表 (normalise：各种窗的相干增益都归一化，能量比例类特征不受窗类型影响)
+    void fillWindowTable (float* table) const
+    {
+        using WF = juce::dsp::WindowingFunction<float>;
+
+        const auto method = window == Window::BlackmanHarris ? WF::blackmanHarris
+                          : window == Window::Kaiser         ? WF::kaiser
+                                                             : WF::hann;
+
+        WF::fillWindowingTables (table, (size_t) getFftSize(), method, true, kKaiserBeta);
+    }
+
+    // 窗的等效噪声带宽 (bin 数)：N * sum (w^2) / sum (w)^2，Hann 约 1.5
+    // 正弦波的功率散在这么宽的 bin 上，按频段求功率和时除以它 (非音频线程，会分配)
+    float getEquivalentNoiseBins() const
+    {
+        std::vector<float> table ((size_t) getFftSize());
+        fillWindowTable (table.data());
+
+        double sum = 0.0, sumSquares = 0.0;
+
+        for (auto w : table)
+        {
+            sum += w;
+            sumSquares += (double) w * w;
+        }
+
+        return (float) ((double) getFftSize() * sumSquares / (sum * sum));
+    }
+
+    bool operator== (const AnalysisConfig& other) const noexcept
+    {
+        return fftOrder == other.fftOrder && getHopSize() == other.getHopSize() && window == other.window
+                && resampleToCanonicalRate == other.resampleToCanonicalRate;
+    }
+
+    bool operator!= (const AnalysisConfig& other) const noexcept { return ! operator== (other); }
+};
@@ -0,0 +1,165 @@
+#include "AnalysisPlan.h"
+#include "SpectralKernels.h"
+
+AnalysisPlan::AnalysisPlan (const AnalysisConfig& newConfig, double newSampleRate)
+    : config (newConfig.withValidatedRanges()),
+      sampleRate (newSampleRate),
+      analysisSampleRate (config.getAnalysisSampleRate (newSampleRate)),
+      fft (config.fftOrder)
+{
+    const int fftSize = config.getFftSize();
+    const int numBins = fftSize / 2 + 1;
+
+    framer.prepare (config, 2);
+    featureExtractor.prepare (fftSize, analysisSampleRate);
+    packedFrame.assign ((size_t) fftSize * 2, 0.0f);
+    packedSpectrum.assign ((size_t) fftSize * 2, 0.0f);
+    frameBuffer.assign ((size_t) fftSize * 2, 0.0f);
+
+    for (auto& stream : sideStreams)
+    {
+        stream.bins.assign ((size_t) numBins * 2, 0.0f);
+        stream.mags.assign ((size_t) numBins, 0.0f);
+        stream.cumulativeMags.assign ((size_t) numBins + 1, 0.0);
+    }
+
+    for (size_t ch = 0; ch < resamplers.size(); ++ch)
+    {
+        resamplers[ch].prepare (sampleRate, analysisSampleRate);
+        resampleBuffers[ch].assign ((size_t) resamplers[ch].getMaxOutputSamples (kResampleBlockSize), 0.0f);
+    }
+
+    FeatureExtractor::buildLogBands (fftSize, analysisSampleRate, envelopeBands.data(), kEnvelopeBands);
+    stereoCoherence.prepare (envelopeBands, analysisSampleRate / (double) config.getHopSize(), kWidthTimeConstantSeconds);
+    onsetDetector.prepare (fftSize / 2, fftSize, analysisSampleRate / (double) config.getHopSize(), kOnsetWindowSeconds);
+    decayAnalyser.prepare (analysisSampleRate / (double) config.getHopSize());
+    multirate.prepare (config, analysisSampleRate);
+    lowBandMid.assign ((size_t) kResampleBlockSize, 0.0f);
+    filterbank.prepare (multirate.getFrequencies(), multirate.getNumBins(), analysisSampleRate);
+    displaySpectrum.prepare (multirate.getFrequencies(), multirate.getNumBins(), config.getEquivalentNoiseBins(),
+                             analysisSampleRate / (double) config.getHopSize());
+}
+
+void AnalysisPlan::reset()
+{
+    framer.reset();
+    featureExtractor.reset();
+    std::fill (frameBuffer.begin(), frameBuffer.end(), 0.0f);
+
+    for (auto& r : resamplers)
+        r.reset();
+
+    multirate.reset();
+    displaySpectrum.reset();
+    stereoCoherence.reset();
+    onsetDetector.reset();
+    decayAnalyser.reset();
+
+    for (auto& stream : sideStreams)
+    {
+        std::fill (stream.mags.begin(), stream.mags.end(), 0.0f);
+        std::fill (stream.cumulativeMags.begin(), stream.cumulativeMags.end(), 0.0);
+    }
+}
+
+void AnalysisPlan::getEnvelope (std::array<float, kEnvelopeBands>& envOut) const noexcept
+{
+    featureExtractor.getBandMeanMagnitudes (envelopeBands.data(), envOut.data(), kEnvelopeBands);
+
+    // 换算到 2048 点的电平，换 FFT 点数时包络不跟着变
+    const float scale = (float) FeatureExtractor::kReferenceFftSize / (float) config.getFftSize();
+
+    for (auto& e : envOut)
+        e *= scale;
+}
+
+void AnalysisPlan::splitPackedSpectrum() noexcept
+{
+    // Mid / Side 只是 L / R 的线性组合，拆出 L / R 之后直接在频域里算
+    const int fftSize = config.getFftSize();
+    const int nyquistBin = fftSize / 2;
+    const int numFloats = (nyquistBin + 1) * 2;
+
+    float* mid   = frameBuffer.data();
+    float* left  = sideStreams[0].bins.data();
+    float* right = sideStreams[1].bins.data();
+    float* side  = sideStreams[2].bins.data();
+
+    StftFramer::splitPackedSpectrum (packedSpectrum.data(), fftSize, left, right);
+
+    juce::FloatVectorOperations::add (mid, left, right, numFloats);
+    juce::FloatVectorOperations::multiply (mid, 0.5f, numFloats);
+    juce::FloatVectorOperations::subtract (side, left, right, numFloats);
+    juce::FloatVectorOperations::multiply (side, 0.5f, numFloats);
+
+    for (auto& stream : sideStreams)
+    {
+        SpectralKernels::magnitude (stream.bins.data() + 2, stream.mags.data() + 1, nyquistBin);
+        SpectralKernels::prefixSum (stream.mags.data(), stream.cumulativeMags.data(), nyquistBin + 1);
+    }
+
+    // 互谱直接用拆出来的 L / R
+    stereoCoherence.processFrame (left, right);
+}
+
+void AnalysisPlan::measureOnsets (TimbreProfile& profile) noexcept
+{
+    onsetDetector.processFrame (featureExtractor.getMagnitudeSpectrum() + 1);
+
+    profile.motion = onsetDetector.getMotion();
+    profile.bite *= onsetDetector.getBiteWeight();
+}
+
+void AnalysisPlan::measureDecay (TimbreProfile& profile) noexcept
+{
+    AnalysisSnapshot::EnvelopeArray energies;
+    featureExtractor.getBandEnergies (envelopeBands.data(), energies.data(), kEnvelopeBands);
+    decayAnalyser.processFrame (energies.data());
+
+    profile.space = decayAnalyser.hasEstimate() ? decayAnalyser.getSpace()
+                                                : juce::jlimit (0.0f, 1.0f, profile.air * 0.5f + (1.0f - profile.motion) * 0.3f + 0.1f);
+}
+
+void AnalysisPlan::getStreamEnvelopes (AnalysisSnapshot::StreamEnvelopes& envOut) const noexcept
+{
+    getSideStreamEnvelope (sideStreams[0], envOut[(size_t) Stream::Left]);
+    getSideStreamEnvelope (sideStreams[1], envOut[(size_t) Stream::Right]);
+    getEnvelope (envOut[(size_t) Stream::Mid]);
+    getSideStreamEnvelope (sideStreams[2], envOut[(size_t) Stream::Side]);
+}
+
+void AnalysisPlan::getSideStreamEnvelope (const SideStream& stream, AnalysisSnapshot::EnvelopeArray& envOut) const noexcept
+{
+    // 和 getEnvelope 同样的频段和电平换算
+    const float scale = (float) FeatureExtractor::kReferenceFftSize / (float) config.getFftSize();
+
+    for (size_t b = 0; b < (size_t) kEnvelopeBands; ++b)
+    {
+        const auto& band = envelopeBands[b];
+        const double sum = stream.cumulativeMags[(size_t) band.endBin + 1] - stream.cumulativeMags[(size_t) band.startBin];
+
+        envOut[b] = (float) (sum / (double) (band.endBin - band.startBin + 1)) * scale;
+    }
+}
+
+void AnalysisPlan::getFilterbankEnvelope (AnalysisSnapshot::BandArray& bandsOut) const noexcept
+{
+    // 每个 band 是加权平均功率的开方，和单个 bin 的 magnitude 同一量纲；
+    // 合并谱已经换算到 2048 点电平，这里不用再缩放
+    filterbank.process (multirate.getPowerSpectrum(), bandsOut);
+}
+
+void AnalysisPlan::processLowBand (const float* left, const float* right, int numSamples) noexcept
+{
+    if (! multirate.isActive())
+        return;
+
+    for (int offset = 0; offset < numSamples; offset += kResampleBlockSize)
+    {
+        const int n = juce::jmin (kResampleBlockSize, numSamples - offset);
+
+        juce::FloatVectorOperations::add (lowBandMid.data(), left + offset, right + offset, n);
+        juce::FloatVectorOperations::multiply (lowBandMid.data(), 0.5f, n);
+        multirate.process (lowBandMid.data(), n);
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "AnalysisConfig.h"
+#include "AnalysisSnapshot.h"
+#include "DecayAnalyser.h"
+#include "DisplaySpectrum.h"
+#include "ErbFilterbank.h"
+#include "FeatureExtractor.h"
+#include "MultirateSpectrum.h"
+#include "OnsetDetector.h"
+#include "PolyphaseResampler.h"
+#include "StereoCoherence.h"
+#include "StftFramer.h"
+
+// 一套完整的实时 STFT 分析资源：FFT plan、分帧器 (含窗表)、帧 buffer、特征提取器、
+// 包络频段映射、ERB 滤波器组权重，以及可选的重采样器。在消息线程上按 AnalysisConfig 整套建好，音频线程只做指针交换，
+// 换配置时不在音频线程上分配任何东西。
+//
+// 输入是一对 L/R：两路实信号打包成一个复数帧 (re = L, im = R) 只做一次复数 FFT，
+// 再按共轭对称拆回 L / R 的频谱，Mid / Side 直接在频域里由 L / R 线性组合得到。
+// 音色特征 (FeatureExtractor) 跑在 Mid 上；L / R / Side 只出 8 段包络。
+// 拆出来的 L / R 频谱顺便喂给 StereoCoherence，每个 band 的相关 / 相干度和 width 都从互谱来。
+// Mid 的 magnitude 谱再喂给 OnsetDetector (Motion / Bite) 和 DecayAnalyser (Space)。
+// Mid 的时域信号另外走一路 MultirateSpectrum (抽取后的小 FFT)，1 kHz 以下的 bin 更细，ERB 滤波器组用合并后的谱，
+// 给 UI 的 1/24 倍频程显示谱 (DisplaySpectrum) 也从合并谱算。
+class AnalysisPlan
+{
+public:
+    static constexpr int kEnvelopeBands = AnalysisSnapshot::kEnvelopeBands;
+    using Stream = AnalysisSnapshot::Stream;
+
+    // 非音频线程：分配全部资源
+    AnalysisPlan (const AnalysisConfig& config, double sampleRate);
+
+    bool matches (const AnalysisConfig& otherConfig, double otherSampleRate) const noexcept
+    {
+        return config == otherConfig && sampleRate == otherSampleRate;
+    }
+
+    const AnalysisConfig& getConfig() const noexcept { return config; }
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    // FFT / 特征 / 频段实际所在的采样率 (打开重采样时是 kCanonicalSampleRate)
+    double getAnalysisSampleRate() const noexcept { return analysisSampleRate; }
+    int getFftSize() const noexcept { return config.getFftSize(); }
+
+    // 不在音频线程使用时才能调用 (复用 cache 里的 plan 前清掉旧帧)
+    void reset();
+
+    // 音频线程：整块推进分帧器，每出一帧做一次打包 FFT + 拆分 + 特征提取，然后调用 onFrame (Mid 的 profile)
+    // 打开重采样时先按 kResampleBlockSize 分段转到分析采样率，再喂给分帧器
+    template <typename FrameCallback>
+    void process (const float* left, const float* right, int numSamples, FrameCallback&& onFrame)
+    {
+        auto onFrameReady = [this, &onFrame]
+        {
+            fft.perform (reinterpret_cast<const juce::dsp::Complex<float>*> (packedFrame.data()),
+                         reinterpret_cast<juce::dsp::Complex<float>*> (packedSpectrum.data()), false);
+            splitPackedSpectrum();
+
+            auto profile = featureExtractor.processFrame (frameBuffer.data());
+            multirate.merge (featureExtractor.getPowerSpectrum());
+            displaySpectrum.processFrame (multirate.getPowerSpectrum());
+            measureOnsets (profile);
+            measureDecay (profile);
+            onFrame (profile);
+        };
+
+        if (resamplers[0].isPassThrough())
+        {
+            processLowBand (left, right, numSamples);
+            framer.processPair (left, right, numSamples, packedFrame.data(), onFrameReady);
+            return;
+        }
+
+        for (int offset = 0; offset < numSamples; offset += kResampleBlockSize)
+        {
+            const int n = juce::jmin (kResampleBlockSize, numSamples - offset);
+            const int numResampled = resamplers[0].process (left + offset, n, resampleBuffers[0].data());
+            resamplers[1].process (right + offset, n, resampleBuffers[1].data());
+
+            processLowBand (resampleBuffers[0].data(), resampleBuffers[1].data(), numResampled);
+            framer.processPair (resampleBuffers[0].data(), resampleBuffers[1].data(), numResampled,
+                                packedFrame.data(), onFrameReady);
+        }
+    }
+
+    // ---- 以下都读最近一帧的结果 (O(1) 频段查询) ----
+    // log 间隔的 kEnvelopeBands 个频段，每段的平均 magnitude
+    void getEnvelope (std::array<float, kEnvelopeBands>& envOut) const noexcept;
+
+    // 同样的 8 段包络，L / R / Mid / Side 各一组
+    void getStreamEnvelopes (AnalysisSnapshot::StreamEnvelopes& envOut) const noexcept;
+
+    // 平滑后的互谱：每个 band 的 L/R 相关系数、相干度，以及整体 width (0..1)
+    void getStereoCorrelations (AnalysisSnapshot::EnvelopeArray& out) const noexcept { stereoCoherence.getCorrelations (out); }
+    void getStereoCoherences (AnalysisSnapshot::EnvelopeArray& out) const noexcept   { stereoCoherence.getCoherences (out); }
+    float getStereoWidth() const noexcept                                            { return stereoCoherence.getWidth(); }
+
+    // 每个包络 band 测到的衰减时间 (EDT，秒)，没测到的为 0
+    void getDecayTimes (AnalysisSnapshot::EnvelopeArray& secondsOut) const noexcept { decayAnalyser.getDecayTimes (secondsOut); }
+
+    // 最近的音头时间 (秒，plan reset 起算)，以及最近 kOnsetWindowSeconds 的音头密度 (个/秒)
+    int getOnsetTimes (std::array<float, OnsetDetector::kMaxOnsets>& timesOut) const noexcept { return onsetDetector.getOnsetTimes (timesOut); }
+    float getOnsetDensity() const noexcept { return onsetDetector.getOnsetDensity(); }
+
+    // 多速率合并谱 (1 kHz 以下来自抽取后的低频段)，已经换算到 kReferenceFftSize 的电平
+    const MultirateSpectrum& getMultirateSpectrum() const noexcept { return multirate; }
+
+    // 96 个 ERB band 的 RMS magnitude，电平和显示谱一致 (算在多速率合并谱上)
+    void getFilterbankEnvelope (AnalysisSnapshot::BandArray& bandsOut) const noexcept;
+    const AnalysisSnapshot::BandArray& getFilterbankCentres() const noexcept { return filterbank.getCentreFrequencies(); }
+
+    // 给 UI 的 1/24 倍频程 dB 显示谱 (level + peak-hold)，换 FFT 点数 / 采样率时点的位置和 dB 刻度不变
+    const DisplaySpectrum& getDisplaySpectrum() const noexcept { return displaySpectrum; }
+
+    // 实时分析的时间尺度 (ReferenceTrack 逐格的 profile 也用这两个，才能和 current 直接比)
+    static constexpr double kWidthTimeConstantSeconds = 0.3;   // 互谱平滑，和 host block 大小无关
+    static constexpr double kOnsetWindowSeconds = 3.0;         // Motion / Bite 看最近这么长的音头
+
+private:
+    static constexpr int kResampleBlockSize = 512;
+
+    // L / R / Side 各自的频谱 (Mid 在 frameBuffer 里，由 featureExtractor 处理)
+    struct SideStream
+    {
+        std::vector<float> bins;          // interleaved re/im，bin 0..nyquist
+        std::vector<float> mags;          // bin 0 恒为 0
+        std::vector<double> cumulativeMags;
+    };
+
+    void splitPackedSpectrum() noexcept;
+
+    // Mid = (L + R) / 2 按 kResampleBlockSize 分段推给 MultirateSpectrum
+    void processLowBand (const float* left, const float* right, int numSamples) noexcept;
+
+    // Mid 的 magnitude 谱喂给 OnsetDetector：Motion = 音头密度，Bite 按音头力度加权
+    void measureOnsets (TimbreProfile& profile) noexcept;
+
+    // Mid 的 band 能量喂给 DecayAnalyser；测到过衰减之后 Space 用测量值，否则按 Air / Motion 估
+    void measureDecay (TimbreProfile& profile) noexcept;
+    void getSideStreamEnvelope (const SideStream& stream, AnalysisSnapshot::EnvelopeArray& envOut) const noexcept;
+
+    const AnalysisConfig config;
+    const double sampleRate;
+    const double analysisSampleRate;
+
+    juce::dsp::FFT fft;
+    StftFramer framer;
+    FeatureExtractor featureExtractor;
+    std::vector<float> packedFrame;      // 加窗后的 L + iR，fftSize 个复数
+    std::vector<float> packedSpectrum;   // 它的复数 FFT
+    std::vector<float> frameBuffer;      // Mid 的频谱，和 real-only FFT 的输出布局一样
+    std::array<SideStream, 3> sideStreams;   // Left / Right / Side
+
+    std::array<PolyphaseResampler, 2> resamplers;   // host 采样率 -> 分析采样率，相同时直通
+    std::array<std::vector<float>, 2> resampleBuffers;
+
+    MultirateSpectrum multirate;
+    std::vector<float> lowBandMid;       // kResampleBlockSize 个 sample 的时域 Mid
+
+    std::array<FeatureExtractor::BandRange, kEnvelopeBands> envelopeBands;
+    ErbFilterbank filterbank;
+    DisplaySpectrum displaySpectrum;
+    StereoCoherence stereoCoherence;
+    OnsetDetector onsetDetector;
+    DecayAnalyser decayAnalyser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisPlan)
+};
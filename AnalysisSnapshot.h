@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "LoudnessMeter.h"
+#include "OnsetDetector.h"
+#include "TimbreProfile.h"
+
+// processor -> UI 的一份完整状态
+// 由音频线程整份填好后经 TripleBuffer 发布，UI 拿到的总是同一时刻的一致拷贝。
+struct AnalysisSnapshot
+{
+    static constexpr int kEnvelopeBands = 8;
+    static constexpr int kFilterbankBands = 96;   // ERB 滤波器组
+
+    // 频谱 / 包络的电平都按 kSpectrumFftSize 点标定，不管实际分析用多少点；
+    // 满幅正弦波的 magnitude 是 kSpectrumFullScale (窗的相干增益归一化过)
+    static constexpr int kSpectrumFftSize = 2048;
+    static constexpr float kSpectrumFullScale = (float) kSpectrumFftSize / 2.0f;
+
+    // 显示用频谱：kSpectrumMinHz 起每 1/kSpectrumPointsPerOctave 倍频程一个点 (到 20 kHz 附近)，
+    // 值是 dBFS (满幅正弦波 = 0 dB)，点 i 的频率见 getSpectrumPointHz
+    static constexpr int kSpectrumPointsPerOctave = 24;
+    static constexpr int kSpectrumPoints = 240;             // log2 (20k / 20) * 24 = 239.2
+    static constexpr float kSpectrumMinHz = 20.0f;
+    static constexpr float kSpectrumFloorDb = -100.0f;      // 静音 / 超出 nyquist 的点
+    using SpectrumArray = std::array<float, kSpectrumPoints>;
+    using BandArray = std::array<float, kFilterbankBands>;
+
+    // 同一次 STFT 里同时分析的四路：L / R 来自输入 (多声道先下混成一对)，Mid / Side 在频域里算
+    enum class Stream : int
+    {
+        Left = 0,
+        Right,
+        Mid,        // (L + R) / 2，音色特征和 currentEnvelope 用这一路
+        Side        // (L - R) / 2
+    };
+
+    static constexpr int kNumStreams = 4;
+    using EnvelopeArray = std::array<float, kEnvelopeBands>;
+    using StreamEnvelopes = std::array<EnvelopeArray, kNumStreams>;
+    using OnsetArray = std::array<float, OnsetDetector::kMaxOnsets>;
+
+    static float getSpectrumPointHz (int index) noexcept
+    {
+        return kSpectrumMinHz * std::exp2 ((float) index / (float) kSpectrumPointsPerOctave);
+    }
+
+    enum class Status : int
+    {
+        Idle = 0,
+        WaitingForCapture,   // 已请求，等音频线程在 block 边界开始
+        Capturing,
+        Analysing,
+        TargetReady,
+        Stopped,             // 上一次 capture 被中途停止
+        Importing,           // worker 正在读 reference 文件并分析
+        Aligning             // 正在录一段对齐用的 capture (不替换 target)
+    };
+
+    enum class Error : int
+    {
+        None = 0,
+        RingOverflow,        // worker 来不及取数据，capture ring 写满，丢了一部分音频
+        CaptureTooShort,     // 录到的数据不够一个分析帧
+        NoInput,             // capture 期间没有输入通道
+        ImportFailed,        // reference 文件打不开 / 格式不支持 / 读到一半出错
+        AlignmentFailed,     // capture 在 reference 里找不到
+        NoTransport          // 对齐要在 host 播放时录 (开始录的那一刻不知道 host 时间)
+    };
+
+    uint32_t version = 0;              // 每次 publish 加一
+
+    SpectrumArray spectrum {};         // 当前 level (dB，带下降弹道)
+    SpectrumArray spectrumPeaks {};    // peak-hold (dB)
+    SpectrumArray targetSpectrum {};   // capture 整段的长时平均谱 (Welch)
+    SpectrumArray targetSpectrumLow {}, targetSpectrumMedian {}, targetSpectrumHigh {};   // 逐帧电平的 10 / 50 / 90 百分位
+    std::array<float, kEnvelopeBands> currentEnvelope {}; // 8 个 log band 的平均 magnitude (Mid)
+    StreamEnvelopes streamEnvelopes {};                    // 按 Stream 索引，同样的 8 个 band
+
+    // 同样 8 个 band 的 L/R 相关系数 (-1..1) 和相干度 (0..1)，由平滑后的互谱算出
+    EnvelopeArray bandCorrelation {};
+    EnvelopeArray bandCoherence {};
+
+    // 同样 8 个 band 测到的衰减时间 (EDT，秒)，没测到的为 0；Space 由它得出
+    EnvelopeArray bandDecaySeconds {};
+
+    // Mid 上检测到的音头：最近的音头时间 (秒，分析开始起算，从旧到新) 和最近 3 秒的密度 (个/秒)
+    OnsetArray onsetTimes {};
+    int numOnsets = 0;
+    float onsetDensity = 0.0f;
+    float targetOnsetDensity = 0.0f;   // capture 整段
+
+    // 96 个 ERB band 的 RMS magnitude (和 spectrum 同一电平)，比逐 bin 频谱平滑
+    BandArray currentBands {};
+    BandArray targetBands {};
+    BandArray bandCentreHz {};
+
+    TimbreProfile current;
+    TimbreProfile target;              // 跟随 reference 时是播放位置那一格，否则是整段
+
+    // 导入的 reference 正跟着 host 播放位置走 (target / targetSpectrum / diff 都是这一格的)
+    bool followingReference = false;
+    float referenceSeconds = 0.0f;     // 对应 reference 里的时间
+
+    // 对齐过：reference 时间 = host 时间 + referenceOffsetSeconds (再按 referenceDrift 随时间伸缩)
+    bool referenceAligned = false;
+    float referenceOffsetSeconds = 0.0f;
+    float referenceDrift = 0.0f;
+
+    // BS.1770 响度 / true-peak / crest factor：current 是实时输入，target 是 capture 整段
+    LoudnessMeter::Reading currentLoudness;
+    LoudnessMeter::Reading targetLoudness;
+    std::array<float, 8> diff {};      // target - current (没有 target 时为 0)
+
+    bool targetReady = false;
+    Status status = Status::Idle;
+    float captureProgress = 0.0f;      // 0..1 (导入时是文件读到的位置)
+    Error error = Error::None;
+};
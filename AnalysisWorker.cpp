@@ -0,0 +1,461 @@
+#include "AnalysisWorker.h"
+
+AnalysisWorker::AnalysisWorker()
+    : juce::Thread ("Timbre Analysis Worker"),
+      importBuffer (2, kImportBlockSize)
+{
+    formatManager.registerFormat (new juce::WavAudioFormat(), true);
+    formatManager.registerFormat (new juce::AiffAudioFormat(), false);
+    formatManager.registerFormat (new juce::FlacAudioFormat(), false);
+
+    setAnalysisConfig (AnalysisConfig{});
+
+    startThread();
+}
+
+AnalysisWorker::~AnalysisWorker()
+{
+    stopThread (2000);
+}
+
+void AnalysisWorker::prepare (double sampleRate)
+{
+    const juce::ScopedLock sl (captureLock);
+
+    // worker 每 10ms drain 一次，ring 留 1 秒余量足够
+    for (size_t ch = 0; ch < 2; ++ch)
+    {
+        captureRings[ch].prepare (juce::nextPowerOfTwo ((int) sampleRate));
+        drainBuffers[ch].assign ((size_t) kDrainBlockSize, 0.0f);
+    }
+
+    captureSampleRate = sampleRate;
+    captureEnvelope.prepare (captureSampleRate, ReferenceAligner::kMaxExcerptSeconds);
+    maxCaptureSamples.store ((int) (kMaxCaptureSeconds * sampleRate), std::memory_order_relaxed);
+
+    // 正在导入时 targetAnalyser 归 worker (按文件采样率在跑，不拿锁)：不碰它，
+    // 导入结束时 finishImport 会按新的 captureSampleRate 重建
+    if (getCaptureState() == CaptureState::Importing)
+        return;
+
+    targetAnalyser.prepare (analysisConfig, captureSampleRate);
+    analyserRunning = false;
+    configPending = false;
+
+    captureProgress.store (0.0f, std::memory_order_relaxed);
+    captureState.store (CaptureState::Idle, std::memory_order_release);
+}
+
+void AnalysisWorker::setAnalysisConfig (const AnalysisConfig& newConfig)
+{
+    const juce::ScopedLock sl (captureLock);
+
+    analysisConfig = newConfig.withValidatedRanges();
+
+    if (analyserRunning || getCaptureState() == CaptureState::Importing)
+        configPending = true;
+    else
+        targetAnalyser.prepare (analysisConfig, captureSampleRate);
+}
+
+bool AnalysisWorker::startCapture (int numSamples)
+{
+    // 拿着锁：检查 Idle 和写 alignmentRequested 之间不会有别的命令插进来 (音频线程不会离开 Idle)
+    const juce::ScopedLock sl (captureLock);
+
+    const int maxSamples = maxCaptureSamples.load (std::memory_order_relaxed);
+    if (maxSamples <= 0 || getCaptureState() != CaptureState::Idle)
+        return false;
+
+    alignmentRequested.store (false, std::memory_order_relaxed);
+    requestedCaptureSamples.store (juce::jlimit (1, maxSamples, numSamples), std::memory_order_relaxed);
+    captureError.store (AnalysisSnapshot::Error::None, std::memory_order_relaxed);
+    captureProgress.store (0.0f, std::memory_order_relaxed);
+
+    auto expected = CaptureState::Idle;
+    return captureState.compare_exchange_strong (expected, CaptureState::StartRequested,
+                                                 std::memory_order_acq_rel);
+}
+
+bool AnalysisWorker::startAlignment (int numSamples)
+{
+    const juce::ScopedLock sl (captureLock);
+
+    const int maxSamples = juce::jmin (maxCaptureSamples.load (std::memory_order_relaxed),
+                                       (int) (ReferenceAligner::kMaxExcerptSeconds * captureSampleRate));
+
+    if (maxSamples <= 0 || ! hasReference() || getCaptureState() != CaptureState::Idle)
+        return false;
+
+    alignmentRequested.store (true, std::memory_order_relaxed);
+    requestedCaptureSamples.store (juce::jlimit (1, maxSamples, numSamples), std::memory_order_relaxed);
+    captureError.store (AnalysisSnapshot::Error::None, std::memory_order_relaxed);
+    captureProgress.store (0.0f, std::memory_order_relaxed);
+
+    auto expected = CaptureState::Idle;
+    return captureState.compare_exchange_strong (expected, CaptureState::StartRequested,
+                                                 std::memory_order_acq_rel);
+}
+
+void AnalysisWorker::stopCapture()
+{
+    // 还没开始就直接撤销；正在录就交给音频线程在 block 边界停下
+    auto expected = CaptureState::StartRequested;
+    if (captureState.compare_exchange_strong (expected, CaptureState::Idle, std::memory_order_acq_rel))
+        return;
+
+    expected = CaptureState::Capturing;
+    captureState.compare_exchange_strong (expected, CaptureState::StopRequested, std::memory_order_acq_rel);
+}
+
+bool AnalysisWorker::importFile (const juce::File& file)
+{
+    const juce::ScopedLock sl (captureLock);
+
+    // 拿着锁时 Idle 不会被别人改掉；先写好 importSource 再 release 状态，
+    // worker 看到 Importing 时 (不拿锁) 读到的就是这个文件
+    if (getCaptureState() != CaptureState::Idle)
+        return false;
+
+    importSource = file;
+    importReader.reset();
+    captureError.store (AnalysisSnapshot::Error::None, std::memory_order_relaxed);
+    captureProgress.store (0.0f, std::memory_order_relaxed);
+    captureState.store (CaptureState::Importing, std::memory_order_release);
+
+    notify();
+    return true;
+}
+
+bool AnalysisWorker::canImportFile (const juce::File& file) const
+{
+    return formatManager.findFormatForFileExtension (file.getFileExtension()) != nullptr;
+}
+
+AnalysisWorker::CaptureState AnalysisWorker::processCaptureBlock (const float* const* channels, int numChannels, int numSamples,
+                                                                   const ChannelFold& fold, double hostSeconds) noexcept
+{
+    auto state = captureState.load (std::memory_order_acquire);
+
+    // 命令只在 block 边界生效
+    if (state == CaptureState::StartRequested)
+    {
+        captureTargetSamples = requestedCaptureSamples.load (std::memory_order_relaxed);
+        captureWrittenSamples = 0;
+        captureHasStereoImage.store (fold.hasStereoImage(), std::memory_order_relaxed);
+        captureStartHostSeconds.store (hostSeconds, std::memory_order_relaxed);
+
+        if (captureState.compare_exchange_strong (state, CaptureState::Capturing, std::memory_order_acq_rel))
+            state = CaptureState::Capturing;
+    }
+    else if (state == CaptureState::StopRequested)
+    {
+        if (captureState.compare_exchange_strong (state, CaptureState::Aborted, std::memory_order_acq_rel))
+            state = CaptureState::Aborted;
+
+        return state;
+    }
+
+    if (state != CaptureState::Capturing)
+        return state;
+
+    if (numChannels <= 0)
+    {
+        // 没有输入可录：报错并放弃这次 capture
+        captureError.store (AnalysisSnapshot::Error::NoInput, std::memory_order_relaxed);
+
+        if (captureState.compare_exchange_strong (state, CaptureState::Aborted, std::memory_order_acq_rel))
+            state = CaptureState::Aborted;
+
+        return state;
+    }
+
+    const int toCopy = juce::jmin (numSamples, captureTargetSamples - captureWrittenSamples);
+
+    if (toCopy > 0)
+    {
+        for (int offset = 0; offset < toCopy; offset += ChannelFold::kBlockSize)
+        {
+            const int n = juce::jmin (ChannelFold::kBlockSize, toCopy - offset);
+            fold.process (channels, numChannels, offset, n, captureLeftBuffer.data(), captureRightBuffer.data());
+
+            // 两个 ring 只写同样多的 sample，L/R 始终对齐
+            const int numToPush = juce::jmin (n, captureRings[0].getFreeSpace(), captureRings[1].getFreeSpace());
+
+            captureRings[0].push (captureLeftBuffer.data(), numToPush);
+            captureRings[1].push (captureRightBuffer.data(), numToPush);
+
+            if (numToPush < n)
+                captureError.store (AnalysisSnapshot::Error::RingOverflow, std::memory_order_relaxed);
+        }
+
+        captureWrittenSamples += toCopy;
+        captureProgress.store ((float) captureWrittenSamples / (float) captureTargetSamples,
+                               std::memory_order_relaxed);
+    }
+
+    if (captureWrittenSamples >= captureTargetSamples)
+    {
+        // 写完最后一段数据后再 release 状态，worker 看到 Finished 时 ring 里就是全部数据
+        if (captureState.compare_exchange_strong (state, CaptureState::Finished, std::memory_order_acq_rel))
+            state = CaptureState::Finished;
+    }
+
+    return state;
+}
+
+void AnalysisWorker::run()
+{
+    while (! threadShouldExit())
+    {
+        if (getCaptureState() == CaptureState::Importing)
+        {
+            // 导入不拿 captureLock：Importing 期间只有 worker 能改状态，
+            // prepare / setAnalysisConfig 看到 Importing 也不碰 targetAnalyser
+            serviceImport();
+        }
+        else
+        {
+            const juce::ScopedLock sl (captureLock);
+            serviceCapture();
+        }
+
+        if (alignmentPending)
+        {
+            alignmentPending = false;
+            finishAlignment();
+
+            // 对齐期间 prepare 可能已经把状态复位、UI 又发了新命令：只从 Finished 回到 Idle
+            auto expected = CaptureState::Finished;
+            captureState.compare_exchange_strong (expected, CaptureState::Idle, std::memory_order_acq_rel);
+        }
+
+        // 导入时一片接一片地读，不等 (不占锁，UI 命令不会被挡住)；
+        // 其它时候音频线程不能 notify (会加锁)，这里用短间隔轮询
+        if (getCaptureState() != CaptureState::Importing)
+            wait (10);
+    }
+}
+
+void AnalysisWorker::serviceCapture()
+{
+    // 先读状态再 drain：如果已经是 Finished/Aborted，drain 完 ring 就一定空了
+    const auto state = captureState.load (std::memory_order_acquire);
+
+    if (state == CaptureState::Idle || state == CaptureState::StartRequested)
+        return;
+
+    const bool aligning = isAligning();
+
+    // 第一次看到这次 capture：清掉上一次的累加器 (音频线程在切到 Capturing 之前写好了 stereo 标志)
+    if (! analyserRunning)
+    {
+        if (aligning)
+        {
+            // 对齐用的 capture 最长 kMaxExcerptSeconds，原始 Mid 留着做采样级细化
+            captureEnvelope.reset();
+            alignmentAudio.resize ((size_t) getRequestedCaptureSamples());
+            alignmentSamples = 0;
+        }
+        else
+        {
+            targetAnalyser.reset (captureHasStereoImage.load (std::memory_order_relaxed));
+        }
+
+        analyserRunning = true;
+    }
+
+    // 生产者先写 L 再写 R：每次只取两边都已经到了的部分，取出来马上分析掉
+    for (;;)
+    {
+        const int n = juce::jmin (kDrainBlockSize, captureRings[0].getNumReady(), captureRings[1].getNumReady());
+
+        if (n <= 0)
+            break;
+
+        for (size_t ch = 0; ch < 2; ++ch)
+            captureRings[ch].pop (drainBuffers[ch].data(), n);
+
+        if (state == CaptureState::Aborted)
+            continue;
+
+        if (aligning)
+        {
+            captureEnvelope.process (drainBuffers[0].data(), drainBuffers[1].data(), n);
+
+            const int numToStore = juce::jmin (n, (int) alignmentAudio.size() - alignmentSamples);
+            for (int i = 0; i < numToStore; ++i)
+                alignmentAudio[(size_t) (alignmentSamples + i)] = 0.5f * (drainBuffers[0][(size_t) i] + drainBuffers[1][(size_t) i]);
+
+            alignmentSamples += numToStore;
+        }
+        else
+        {
+            targetAnalyser.process (drainBuffers[0].data(), drainBuffers[1].data(), n);
+        }
+    }
+
+    if (state == CaptureState::Finished && aligning)
+    {
+        // 只拷数据，对齐本身在 run() 里放开锁之后做；状态保持 Finished 直到对齐完
+        alignmentEnvelope.assign (captureEnvelope.getValues(), captureEnvelope.getValues() + captureEnvelope.getNumValues());
+        alignmentSampleRate = captureSampleRate;
+        alignmentPending = true;
+    }
+    else if (state == CaptureState::Finished)
+    {
+        if (targetAnalyser.getNumFrames() == 0)
+        {
+            // 一帧都凑不满，分析结果会全是 0，不发布
+            captureError.store (AnalysisSnapshot::Error::CaptureTooShort, std::memory_order_relaxed);
+        }
+        else
+        {
+            // capture 成了新的 target：之前导入的 reference 不再对应，不能再对齐
+            referenceAvailable.store (false, std::memory_order_relaxed);
+            aligner.clearReference();
+
+            if (onTrackReady != nullptr)
+                onTrackReady (nullptr);
+
+            if (onProfileReady != nullptr)
+                onProfileReady (targetAnalyser.getResult());
+        }
+    }
+
+    if (state == CaptureState::Finished || state == CaptureState::Aborted)
+    {
+        analyserRunning = false;
+
+        if (configPending)
+        {
+            targetAnalyser.prepare (analysisConfig, captureSampleRate);
+            configPending = false;
+        }
+
+        if (! alignmentPending)
+            captureState.store (CaptureState::Idle, std::memory_order_release);
+    }
+}
+
+void AnalysisWorker::serviceImport()
+{
+    if (importReader == nullptr)
+    {
+        importReader.reset (formatManager.createReaderFor (importSource));
+
+        if (importReader == nullptr || importReader->lengthInSamples <= 0 || importReader->sampleRate <= 0.0)
+        {
+            captureError.store (AnalysisSnapshot::Error::ImportFailed, std::memory_order_relaxed);
+            finishImport();
+            return;
+        }
+
+        AnalysisConfig config;
+        {
+            const juce::ScopedLock sl (captureLock);
+            config = analysisConfig;
+        }
+
+        // 分析器按文件自己的采样率重建 (worker 线程，可以分配)；多声道文件只取前两个声道
+        targetAnalyser.prepare (config, importReader->sampleRate);
+        targetAnalyser.reset (importReader->numChannels > 1);
+
+        // 逐格特征轨 (6 分钟的歌不到 1 MB)，分析的同时写进去
+        importTrack = std::make_unique<ReferenceTrack> ((double) importReader->lengthInSamples / importReader->sampleRate);
+        targetAnalyser.setTrack (importTrack.get());
+        referenceEnvelope.prepare (importReader->sampleRate, (double) importReader->lengthInSamples / importReader->sampleRate);
+        importPosition = 0;
+    }
+
+    const auto length = importReader->lengthInSamples;
+
+    for (int block = 0; block < kImportBlocksPerSlice && importPosition < length && ! threadShouldExit(); ++block)
+    {
+        const int n = (int) juce::jmin ((juce::int64) kImportBlockSize, length - importPosition);
+
+        // 单声道文件会把唯一的声道同时读进 L / R
+        if (! importReader->read (&importBuffer, 0, n, importPosition, true, true))
+        {
+            captureError.store (AnalysisSnapshot::Error::ImportFailed, std::memory_order_relaxed);
+            finishImport();
+            return;
+        }
+
+        targetAnalyser.process (importBuffer.getReadPointer (0), importBuffer.getReadPointer (1), n);
+        referenceEnvelope.process (importBuffer.getReadPointer (0), importBuffer.getReadPointer (1), n);
+        importPosition += n;
+    }
+
+    captureProgress.store ((float) ((double) importPosition / (double) length), std::memory_order_relaxed);
+
+    if (importPosition < length)
+        return;
+
+    if (targetAnalyser.getNumFrames() == 0)
+    {
+        captureError.store (AnalysisSnapshot::Error::CaptureTooShort, std::memory_order_relaxed);
+    }
+    else
+    {
+        importTrack->finalise();
+
+        // 之后的对齐都对着这个文件
+        aligner.setReference (referenceEnvelope.getValues(), referenceEnvelope.getNumValues());
+        referenceFile = importSource;
+        referenceAvailable.store (true, std::memory_order_relaxed);
+
+        if (onTrackReady != nullptr)
+            onTrackReady (std::move (importTrack));
+
+        if (onProfileReady != nullptr)
+            onProfileReady (targetAnalyser.getResult());
+    }
+
+    finishImport();
+}
+
+void AnalysisWorker::finishImport()
+{
+    importReader.reset();
+    targetAnalyser.setTrack (nullptr);
+    importTrack.reset();   // 失败 / 太短时没交出去的
+
+    // 换回 capture 的采样率 (导入期间改过的配置 / prepare 换的采样率也在这里生效)
+    const juce::ScopedLock sl (captureLock);
+
+    targetAnalyser.prepare (analysisConfig, captureSampleRate);
+    configPending = false;
+
+    captureState.store (CaptureState::Idle, std::memory_order_release);
+}
+
+void AnalysisWorker::finishAlignment()
+{
+    // 不拿 captureLock：只用 worker 私有的 aligner / alignmentEnvelope / alignmentAudio / referenceFile
+    // 开始录的那一刻 host 没在播放：对上了也换算不到 host 时间轴
+    const double hostStart = captureStartHostSeconds.load (std::memory_order_relaxed);
+
+    if (hostStart < 0.0)
+    {
+        captureError.store (AnalysisSnapshot::Error::NoTransport, std::memory_order_relaxed);
+        return;
+    }
+
+    ReferenceMapping mapping;
+    mapping.hostStartSeconds = hostStart;
+    mapping.alignment = aligner.alignEnvelope (alignmentEnvelope.data(), (int) alignmentEnvelope.size());
+
+    if (mapping.alignment.found)
+    {
+        // 采样级细化只读 reference 里的两小段；文件读不了就停在包络的精度
+        if (std::unique_ptr<juce::AudioFormatReader> reader { formatManager.createReaderFor (referenceFile) })
+            aligner.refine (mapping.alignment, alignmentAudio.data(), alignmentSamples, alignmentSampleRate,
+                            alignmentEnvelope.data(), (int) alignmentEnvelope.size(), *reader);
+    }
+
+    if (! mapping.alignment.found)
+        captureError.store (AnalysisSnapshot::Error::AlignmentFailed, std::memory_order_relaxed);
+    else if (onAlignmentReady != nullptr)
+        onAlignmentReady (mapping);
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "AnalysisConfig.h"
+#include "AnalysisSnapshot.h"
+#include "CaptureRing.h"
+#include "ChannelFold.h"
+#include "OnsetEnvelope.h"
+#include "ReferenceAligner.h"
+#include "ReferenceTrack.h"
+#include "TargetAnalyser.h"
+
+// 后台分析线程：capture 的数据 (下混后的 L/R 两路) 经 SPSC ring 从音频线程流过来，
+// worker 每次 drain 出来就直接喂给 TargetAnalyser 逐帧累加，不保存整段音频：
+// 录多长内存都一样，录完之后只剩 ring 里最后一小段要算，结果几乎立刻就有。
+// FFT plan / window / scratch buffer 全部预分配，和实时分析用同一份 AnalysisConfig。
+// 拖进来的 reference 文件 (WAV / AIFF / FLAC) 也在这里分析：AudioFormatReader 一次读 kImportBlockSize
+// 个 sample 喂给同一个 TargetAnalyser，6 分钟的歌也只占一块固定大小的 buffer；音频线程只看到状态变化。
+// 有 reference 时还可以录一段对齐用的 capture：走同一个 ring，但不替换 target，
+// 只算音头包络 (OnsetEnvelope) 和 reference 对齐 (ReferenceAligner)，结果换算到 host 时间轴上发出去。
+class AnalysisWorker final : private juce::Thread
+{
+public:
+    // capture 状态机：UI 发命令，音频线程在 block 边界接手
+    enum class CaptureState : int
+    {
+        Idle = 0,
+        StartRequested,   // UI -> 音频线程
+        Capturing,        // 音频线程正在写 ring
+        StopRequested,    // UI -> 音频线程
+        Finished,         // 录满了，worker 正在 drain + 分析
+        Aborted,          // 被中途停止，worker 丢弃数据后回到 Idle
+        Importing         // UI -> worker：正在读文件分析，音频线程不碰 ring
+    };
+
+    // 流式分析不保存音频，这里只是进度 / sample 计数的上限
+    static constexpr double kMaxCaptureSeconds = 600.0;
+
+    // 一次 capture 的分析结果：音色 + 整段响度 + 音头
+    using CaptureResult = TargetAnalyser::Result;
+
+    // 对齐结果换到 host 时间轴：reference 时间 = offsetSeconds + (host 时间 - hostStartSeconds) x (1 + drift)
+    struct ReferenceMapping
+    {
+        double hostStartSeconds = 0.0;
+        ReferenceAligner::Alignment alignment;
+    };
+
+    AnalysisWorker();
+    ~AnalysisWorker() override;
+
+    // 分析完成后在 worker 线程上回调 (用来原子地发布 target profile)
+    std::function<void (const CaptureResult&)> onProfileReady;
+
+    // 同样在 worker 线程上、紧挨着 onProfileReady 之前回调：导入的文件带一条按时间索引的 ReferenceTrack，
+    // capture 的结果没有时间轴，传 nullptr (旧的 track 跟着作废)
+    std::function<void (std::unique_ptr<ReferenceTrack>)> onTrackReady;
+
+    // 对齐完成 (worker 线程)
+    std::function<void (const ReferenceMapping&)> onAlignmentReady;
+
+    // 消息线程 (prepareToPlay)：按采样率预分配 ring 和分析资源
+    void prepare (double sampleRate);
+
+    // 非音频线程：按新的 FFT 点数 / overlap / 窗重建分析资源
+    // (正在 capture 时先记下来，这一次 capture 结束后再换，不会把分析到一半的累加器清掉)
+    void setAnalysisConfig (const AnalysisConfig& config);
+
+    // ---- UI 线程：命令 ----
+    // 不在 Idle 状态时返回 false (上一次 capture 还没结束)
+    bool startCapture (int numSamples);
+    void stopCapture();
+
+    // 录一段 (最长 ReferenceAligner::kMaxExcerptSeconds) 和导入的 reference 对齐，target 不变。
+    // 没有 reference 或者不在 Idle 状态时返回 false
+    bool startAlignment (int numSamples);
+    bool hasReference() const noexcept { return referenceAvailable.load (std::memory_order_relaxed); }
+
+    // 从文件导入 target：只记下文件就返回，打开 / 解码 / 分析全在 worker 上。
+    // 不在 Idle 状态时返回 false；文件读不了时 captureError = ImportFailed
+    bool importFile (const juce::File& file);
+
+    // 能导入的格式 (按扩展名)
+    bool canImportFile (const juce::File& file) const;
+
+    // ---- 音频线程：每个 block 调用一次，不分配、不加锁 ----
+    // 录的是所有输入声道按 fold 下混后的 L/R，和实时分析的输入是同一对
+    // hostSeconds：这个 block 开头的 host 播放位置 (没在播放时 < 0)，对齐结果按开始录的那一刻换算
+    CaptureState processCaptureBlock (const float* const* channels, int numChannels, int numSamples,
+                                      const ChannelFold& fold, double hostSeconds) noexcept;
+
+    CaptureState getCaptureState() const noexcept { return captureState.load (std::memory_order_acquire); }
+    float getCaptureProgress() const noexcept     { return captureProgress.load (std::memory_order_relaxed); }
+    int getMaxCaptureSamples() const noexcept     { return maxCaptureSamples.load (std::memory_order_relaxed); }
+    int getRequestedCaptureSamples() const noexcept { return requestedCaptureSamples.load (std::memory_order_relaxed); }
+    bool isAligning() const noexcept                { return alignmentRequested.load (std::memory_order_relaxed); }
+
+    // 上一次 capture 的错误码 (startCapture 时清零)
+    AnalysisSnapshot::Error getCaptureError() const noexcept { return captureError.load (std::memory_order_relaxed); }
+
+    // 是否正在分析 (UI 用来显示 "Analysing...")
+    bool isBusy() const noexcept
+    {
+        const auto state = getCaptureState();
+        return state == CaptureState::Finished || state == CaptureState::Importing;
+    }
+
+private:
+    static constexpr int kDrainBlockSize = 4096;
+    static constexpr int kImportBlockSize = 8192;
+    static constexpr int kImportBlocksPerSlice = 8;   // 每读这么多块更新一次进度、看一次线程要不要退出
+
+    void run() override;
+    void serviceCapture();
+    void serviceImport();
+    void finishImport();
+    void finishAlignment();
+
+    // ---- capture 共享状态 ----
+    std::atomic<CaptureState> captureState { CaptureState::Idle };
+    std::atomic<int> requestedCaptureSamples { 0 };
+    std::atomic<int> maxCaptureSamples { 0 };
+    std::atomic<float> captureProgress { 0.0f };
+    std::atomic<AnalysisSnapshot::Error> captureError { AnalysisSnapshot::Error::None };
+    std::atomic<bool> captureHasStereoImage { false };   // mono 输入时 width 固定 0.5
+    std::atomic<bool> alignmentRequested { false };      // 这一次 capture 是对齐用的
+    std::atomic<double> captureStartHostSeconds { -1.0 };
+    std::atomic<bool> referenceAvailable { false };
+
+    // 音频线程私有
+    int captureTargetSamples = 0;
+    int captureWrittenSamples = 0;
+    std::array<float, ChannelFold::kBlockSize> captureLeftBuffer {}, captureRightBuffer {};
+
+    // worker 私有 (prepare / setAnalysisConfig 时由 captureLock 保护；
+    // 例外是 Importing 期间的 targetAnalyser，归 worker 独占，不拿锁)
+    juce::CriticalSection captureLock;
+    std::array<CaptureRing, 2> captureRings;              // L / R
+    std::array<std::vector<float>, 2> drainBuffers;       // 每次最多从 ring 取 kDrainBlockSize 个
+    double captureSampleRate = 44100.0;
+
+    AnalysisConfig analysisConfig;
+    bool analyserRunning = false;     // 这一次 capture 的累加已经开始
+    bool configPending = false;       // capture 期间换了配置，结束后再 prepare
+    TargetAnalyser targetAnalyser;
+
+    // 文件导入 (importFile 拿着 captureLock 写 importSource，之后只有 worker 碰)
+    juce::AudioFormatManager formatManager;
+    juce::File importSource;
+    std::unique_ptr<juce::AudioFormatReader> importReader;
+    std::unique_ptr<ReferenceTrack> importTrack;          // 按文件时长一次分配，成功后交出去
+    juce::AudioBuffer<float> importBuffer;                // 2 x kImportBlockSize，构造时分配
+    juce::int64 importPosition = 0;
+
+    // 对齐：reference 的包络在导入时算好，文件留着给采样级细化按需读
+    OnsetEnvelope referenceEnvelope;
+    juce::File referenceFile;
+    ReferenceAligner aligner;
+    OnsetEnvelope captureEnvelope;                        // prepare 时按最长片段分配
+    std::vector<float> alignmentAudio;                    // 对齐 capture 的 Mid，开始录时按长度分配
+    int alignmentSamples = 0;
+
+    // 对齐要读文件、做 FFT 和 NCC，几十 ms：拿着 captureLock 把包络和采样率拷出来，
+    // 放开锁再算，UI 命令和 prepare 不用等。下面这几个只有 worker 碰
+    std::vector<float> alignmentEnvelope;
+    double alignmentSampleRate = 44100.0;
+    bool alignmentPending = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisWorker)
+};
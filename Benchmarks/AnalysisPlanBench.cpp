@@ -0,0 +1,75 @@
+// 整个 AnalysisPlan (默认配置，立体声) 每秒音频的 CPU 时间：host 采样率 48k / 96k / 192k，
+// 重采样到 48k 开 / 关各跑一遍。另外单独测 host -> 48k 的重采样器，看它在里面占多少
+#include "../AnalysisPlan.h"
+#include "BenchmarkTimer.h"
+
+#include <vector>
+
+int main()
+{
+    constexpr double kSeconds = 5.0;
+    constexpr int kBlockSize = 512;
+    constexpr int kRuns = 5;
+    const double hostRates[] = { 48000.0, 96000.0, 192000.0 };
+
+    std::printf ("AnalysisPlan, default config (2048 points, 75%% overlap), stereo, %d-sample blocks\n", kBlockSize);
+    std::printf ("%8s %10s %18s %22s\n", "host", "resample", "plan (ms / s)", "resampler (ms / s)");
+
+    for (double hostRate : hostRates)
+    {
+        const int numSamples = (int) (hostRate * kSeconds);
+
+        juce::Random random (1);
+        std::vector<float> left ((size_t) numSamples), right ((size_t) numSamples);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            left[(size_t) i] = random.nextFloat() - 0.5f;
+            right[(size_t) i] = 0.5f * left[(size_t) i] + 0.5f * (random.nextFloat() - 0.5f);
+        }
+
+        for (bool resample : { false, true })
+        {
+            AnalysisConfig config;
+            config.resampleToCanonicalRate = resample;
+
+            AnalysisPlan plan (config, hostRate);
+            float sink = 0.0f;
+
+            const double planSeconds = timeBestOf (kRuns, [&]
+            {
+                plan.reset();
+
+                for (int offset = 0; offset < numSamples; offset += kBlockSize)
+                    plan.process (left.data() + offset, right.data() + offset, juce::jmin (kBlockSize, numSamples - offset),
+                                  [&sink] (const TimbreProfile& p) { sink += p.bright; });
+            });
+            keepAlive (sink);
+
+            // 只有重采样器：两个声道
+            double resamplerSeconds = 0.0;
+
+            if (resample && hostRate != AnalysisConfig::kCanonicalSampleRate)
+            {
+                PolyphaseResampler resampler;
+                resampler.prepare (hostRate, AnalysisConfig::kCanonicalSampleRate);
+                std::vector<float> out ((size_t) resampler.getMaxOutputSamples (kBlockSize));
+
+                resamplerSeconds = timeBestOf (kRuns, [&]
+                {
+                    resampler.reset();
+
+                    for (const auto* channel : { left.data(), right.data() })
+                        for (int offset = 0; offset < numSamples; offset += kBlockSize)
+                            resampler.process (channel + offset, juce::jmin (kBlockSize, numSamples - offset), out.data());
+
+                    keepAlive (out[0]);
+                });
+            }
+
+            std::printf ("%8.0f %10s %18.2f %22.2f\n", hostRate, resample ? "on" : "off",
+                         1000.0 * planSeconds / kSeconds, 1000.0 * resamplerSeconds / kSeconds);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <algorithm>
+#include <cstdio>
+
+// benchmark 共用：跑 numRuns 轮，每轮调用 fn 一次，返回最快一轮的秒数 (排除调度 / 缓存冷启动的干扰)
+template <typename Fn>
+double timeBestOf (int numRuns, Fn&& fn)
+{
+    double best = 1.0e30;
+
+    for (int run = 0; run < numRuns; ++run)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        fn();
+        const auto end = juce::Time::getHighResolutionTicks();
+        best = std::min (best, juce::Time::highResolutionTicksToSeconds (end - start));
+    }
+
+    return best;
+}
+
+// 结果写进 volatile，编译器不能把被测的循环整个优化掉
+inline void keepAlive (float value) noexcept
+{
+    static volatile float sink = 0.0f;
+    sink = sink + value;
+}
@@ -0,0 +1,70 @@
+// ErbFilterbank 每帧的开销和分析 plan 每帧做的 FFT (L/R 打包成一个 fftSize 点的复数 FFT) 对比
+// 目标：filterbank < 5% FFT。filterbank 建在 plan 实际用的网格上 (MultirateSpectrum 合并后的谱)
+#include "../ErbFilterbank.h"
+#include "../MultirateSpectrum.h"
+#include "BenchmarkTimer.h"
+
+#include <array>
+#include <vector>
+
+int main()
+{
+    constexpr double kSampleRate = 48000.0;
+    constexpr int kCallsPerRun = 2000;
+    constexpr int kRuns = 7;
+
+    juce::Random random (1);
+
+    std::printf ("ERB filterbank (%d bands) vs juce::dsp::FFT per frame, %.0f Hz\n", ErbFilterbank::kNumBands, kSampleRate);
+    std::printf ("%8s %8s %14s %16s %8s\n", "fft", "bins", "FFT (us)", "filterbank (us)", "ratio");
+
+    for (int order = AnalysisConfig::kMinFftOrder; order <= AnalysisConfig::kMaxFftOrder; ++order)
+    {
+        AnalysisConfig config;
+        config.fftOrder = order;
+
+        const int fftSize = config.getFftSize();
+
+        MultirateSpectrum multirate;
+        multirate.prepare (config, kSampleRate);
+
+        const int numBins = multirate.getNumBins();
+
+        juce::dsp::FFT fft (order);
+        std::vector<juce::dsp::Complex<float>> packedFrame ((size_t) fftSize), packedSpectrum ((size_t) fftSize);
+        for (auto& z : packedFrame)
+            z = { random.nextFloat() - 0.5f, random.nextFloat() - 0.5f };
+
+        ErbFilterbank filterbank;
+        filterbank.prepare (multirate.getFrequencies(), numBins, kSampleRate);
+
+        std::vector<float> power ((size_t) numBins);
+        for (auto& p : power)
+            p = random.nextFloat();
+
+        std::array<float, ErbFilterbank::kNumBands> bands {};
+
+        const double fftSeconds = timeBestOf (kRuns, [&]
+        {
+            for (int i = 0; i < kCallsPerRun; ++i)
+            {
+                fft.perform (packedFrame.data(), packedSpectrum.data(), false);
+                keepAlive (packedSpectrum[1].real());
+            }
+        }) / kCallsPerRun;
+
+        const double filterbankSeconds = timeBestOf (kRuns, [&]
+        {
+            for (int i = 0; i < kCallsPerRun; ++i)
+            {
+                filterbank.process (power.data(), bands);
+                keepAlive (bands[40]);
+            }
+        }) / kCallsPerRun;
+
+        std::printf ("%8d %8d %14.2f %16.2f %7.1f%%\n", fftSize, numBins, fftSeconds * 1.0e6, filterbankSeconds * 1.0e6,
+                     100.0 * filterbankSeconds / fftSeconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+// FeatureExtractor::processFrame 每帧的开销，FFT 点数 512 .. 16384
+// per-bin 的工作都在 SpectralKernels 里，每个 bin 的开销应该和点数无关
+// (定长特化和通用版本的对比在 0bab4e0 这个版本的同名 benchmark 里，特化去掉之前)
+#include "../AnalysisConfig.h"
+#include "../FeatureExtractor.h"
+#include "BenchmarkTimer.h"
+
+#include <vector>
+
+int main()
+{
+    constexpr double kSampleRate = 48000.0;
+    constexpr int kCallsPerRun = 2000;
+    constexpr int kRuns = 7;
+
+    juce::Random random (1);
+
+    std::printf ("FeatureExtractor::processFrame, %.0f Hz\n", kSampleRate);
+    std::printf ("%8s %14s %12s\n", "fft", "frame (us)", "ns / bin");
+
+    for (int order = AnalysisConfig::kMinFftOrder; order <= AnalysisConfig::kMaxFftOrder; ++order)
+    {
+        const int fftSize = 1 << order;
+
+        FeatureExtractor extractor;
+        extractor.prepare (fftSize, kSampleRate);
+
+        // real-only FFT 的输出布局：bin 0..nyquist 的 re/im
+        std::vector<float> fftData ((size_t) fftSize + 2);
+        for (auto& x : fftData)
+            x = random.nextFloat() - 0.5f;
+
+        const double seconds = timeBestOf (kRuns, [&]
+        {
+            for (int i = 0; i < kCallsPerRun; ++i)
+                keepAlive (extractor.processFrame (fftData.data()).noise);
+        }) / kCallsPerRun;
+
+        std::printf ("%8d %14.2f %12.3f\n", fftSize, seconds * 1.0e6, seconds * 1.0e9 / (fftSize / 2));
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+// StftFramer 和原来逐 sample 的 fifo (pushSampleForEnvelope，baseline 40498bf) 的单声道吞吐量对比
+// 只比分帧 + 加窗，不做 FFT；每一帧的回调只读一个值
+#include "../StftFramer.h"
+#include "BenchmarkTimer.h"
+
+#include <array>
+#include <vector>
+
+namespace
+{
+    // baseline 的 fifo：每个 sample 调一次，满一帧时拷出来加窗，然后把 fifo 左移一个 hop
+    class LegacyFifo
+    {
+    public:
+        static constexpr int kFFTSize = 2048;
+        static constexpr int kHop = 512;
+
+        template <typename FrameCallback>
+        void pushSample (float s, FrameCallback&& onFrame)
+        {
+            fifo[(size_t) fifoIndex++] = s;
+
+            if (fifoIndex >= kFFTSize)
+            {
+                for (int i = 0; i < kFFTSize; ++i)
+                    fftBuffer[(size_t) i] = fifo[(size_t) i];
+
+                window.multiplyWithWindowingTable (fftBuffer.data(), kFFTSize);
+                onFrame (fftBuffer.data());
+
+                const int remain = kFFTSize - kHop;
+                for (int i = 0; i < remain; ++i)
+                    fifo[(size_t) i] = fifo[(size_t) (i + kHop)];
+
+                fifoIndex = remain;
+            }
+        }
+
+    private:
+        juce::dsp::WindowingFunction<float> window { (size_t) kFFTSize, juce::dsp::WindowingFunction<float>::hann };
+        std::array<float, kFFTSize> fifo {};
+        int fifoIndex = 0;
+        std::array<float, kFFTSize * 2> fftBuffer {};
+    };
+}
+
+int main()
+{
+    constexpr int kSeconds = 10;
+    constexpr int kSampleRate = 48000;
+    constexpr int kNumSamples = kSeconds * kSampleRate;
+    constexpr int kRuns = 5;
+
+    std::vector<float> input ((size_t) kNumSamples);
+    juce::Random random (1);
+    for (auto& x : input)
+        x = random.nextFloat() * 2.0f - 1.0f;
+
+    AnalysisConfig config;   // 2048 点，75% overlap (hop 512)，和 baseline 一样
+    std::vector<float> frame ((size_t) (2 * config.getFftSize()));
+
+    std::printf ("STFT framing, mono, %d s at %d Hz, %d-point frames, hop %d\n",
+                 kSeconds, kSampleRate, config.getFftSize(), config.getHopSize());
+    std::printf ("%10s %16s %16s %9s\n", "block", "legacy (ns/smp)", "framer (ns/smp)", "speed-up");
+
+    for (int blockSize : { 32, 128, 512, 4096 })
+    {
+        const double legacySeconds = timeBestOf (kRuns, [&]
+        {
+            LegacyFifo legacy;
+            for (int start = 0; start + blockSize <= kNumSamples; start += blockSize)
+                for (int i = 0; i < blockSize; ++i)
+                    legacy.pushSample (input[(size_t) (start + i)], [] (const float* f) { keepAlive (f[100]); });
+        });
+
+        const double framerSeconds = timeBestOf (kRuns, [&]
+        {
+            StftFramer framer;
+            framer.prepare (config);
+            for (int start = 0; start + blockSize <= kNumSamples; start += blockSize)
+                framer.process (input.data() + start, blockSize, frame.data(), [&] { keepAlive (frame[100]); });
+        });
+
+        std::printf ("%10d %16.3f %16.3f %8.1fx\n", blockSize,
+                     legacySeconds * 1.0e9 / kNumSamples, framerSeconds * 1.0e9 / kNumSamples, legacySeconds / framerSeconds);
+    }
+
+    return 0;
+}
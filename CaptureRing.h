@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <vector>
+
+// 单生产者/单消费者 (SPSC) 无锁 ring buffer
+// 生产者 = 音频线程，消费者 = AnalysisWorker。
+// 内存只在 prepare() 里分配 (音频线程和消费者都不在访问时调用)。
+class CaptureRing
+{
+public:
+    void prepare (int capacity)
+    {
+        storage.assign ((size_t) capacity, 0.0f);
+        fifo.setTotalSize (capacity);
+        fifo.reset();
+    }
+
+    // 生产者：写不下的部分直接丢弃，返回实际写入的数量
+    int push (const float* data, int numSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            std::copy (data, data + size1, storage.begin() + start1);
+        if (size2 > 0)
+            std::copy (data + size1, data + size1 + size2, storage.begin() + start2);
+
+        fifo.finishedWrite (size1 + size2);
+        return size1 + size2;
+    }
+
+    // 消费者：最多读 maxSamples 个，返回实际读出的数量
+    int pop (float* dest, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (maxSamples, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            std::copy (storage.begin() + start1, storage.begin() + start1 + size1, dest);
+        if (size2 > 0)
+            std::copy (storage.begin() + start2, storage.begin() + start2 + size2, dest + size1);
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    // 消费者：丢掉当前所有数据
+    void discardAll() noexcept
+    {
+        fifo.finishedRead (fifo.getNumReady());
+    }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+    int getFreeSpace() const noexcept { return fifo.getFreeSpace(); }
+
+private:
+    juce::AbstractFifo fifo { 1 };
+    std::vector<float> storage;
+};
@@ -0,0 +1,75 @@
+#include "ChannelFold.h"
+
+void ChannelFold::prepare (const juce::AudioChannelSet& layout)
+{
+    constexpr float kMinus3dB = 0.70710678f;
+
+    leftGains.fill (0.0f);
+    rightGains.fill (0.0f);
+
+    const int numChannels = juce::jmin (kMaxChannels, layout.size());
+
+    if (numChannels <= 1)
+    {
+        leftGains[0] = rightGains[0] = 1.0f;
+    }
+    else
+    {
+        for (int c = 0; c < numChannels; ++c)
+        {
+            using CT = juce::AudioChannelSet::ChannelType;
+            auto& l = leftGains[(size_t) c];
+            auto& r = rightGains[(size_t) c];
+
+            switch (layout.getTypeOfChannel (c))
+            {
+                case CT::left:               l = 1.0f; break;
+                case CT::right:              r = 1.0f; break;
+                case CT::centre:             l = r = kMinus3dB; break;
+                case CT::LFE:                break;
+                case CT::leftSurround:
+                case CT::leftSurroundSide:
+                case CT::leftSurroundRear:   l = kMinus3dB; break;
+                case CT::rightSurround:
+                case CT::rightSurroundSide:
+                case CT::rightSurroundRear:  r = kMinus3dB; break;
+                default:                     l = r = kMinus3dB; break;   // 其它 (surround、top 等) 两边各一半
+            }
+        }
+    }
+
+    stereoImage = leftGains != rightGains;
+}
+
+void ChannelFold::process (const float* const* channels, int numChannels, int startSample, int numSamples,
+                           float* leftOut, float* rightOut) const noexcept
+{
+    jassert (numSamples <= kBlockSize);
+
+    mix (leftGains, channels, numChannels, startSample, numSamples, leftOut);
+    mix (rightGains, channels, numChannels, startSample, numSamples, rightOut);
+}
+
+void ChannelFold::mix (const std::array<float, kMaxChannels>& gains, const float* const* channels, int numChannels,
+                       int startSample, int numSamples, float* out) noexcept
+{
+    bool written = false;
+
+    for (int c = 0; c < juce::jmin (numChannels, kMaxChannels); ++c)
+    {
+        const float g = gains[(size_t) c];
+
+        if (g == 0.0f)
+            continue;
+
+        if (written)
+            juce::FloatVectorOperations::addWithMultiply (out, channels[c] + startSample, g, numSamples);
+        else
+            juce::FloatVectorOperations::copyWithMultiply (out, channels[c] + startSample, g, numSamples);
+
+        written = true;
+    }
+
+    if (! written)
+        juce::FloatVectorOperations::clear (out, numSamples);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <array>
+
+// 任意输入声道布局 -> 一对 L/R 分析流
+// mono 两边都是同一个声道 (Side 为 0)；stereo 原样；5.1 / 7.1 按 ITU-R BS.775 下混：
+// centre 和 surround 以 -3 dB 叠到对应一侧，LFE 不参与音色分析。
+// 增益表在 prepare 时按布局算好，音频线程只做向量乘加。
+class ChannelFold
+{
+public:
+    static constexpr int kMaxChannels = 8;   // 7.1
+    static constexpr int kBlockSize = 512;   // 调用方一次最多折叠多少 sample (scratch buffer 大小)
+
+    // 非音频线程 (prepareToPlay)
+    void prepare (const juce::AudioChannelSet& layout);
+
+    // 有没有真正的立体声像 (mono 输入时 L == R，width 没有意义)
+    bool hasStereoImage() const noexcept { return stereoImage; }
+
+    // 音频线程：channels[c] + startSample 开始的 numSamples (<= kBlockSize) 个 sample
+    void process (const float* const* channels, int numChannels, int startSample, int numSamples,
+                  float* leftOut, float* rightOut) const noexcept;
+
+private:
+    static void mix (const std::array<float, kMaxChannels>& gains, const float* const* channels, int numChannels,
+                     int startSample, int numSamples, float* out) noexcept;
+
+    std::array<float, kMaxChannels> leftGains {};
+    std::array<float, kMaxChannels> rightGains {};
+    bool stereoImage = false;
+};
@@ -0,0 +1,186 @@
+#include "DecayAnalyser.h"
+
+void DecayAnalyser::prepare (double framesPerSecond)
+{
+    jassert (framesPerSecond > 0.0);
+
+    frameSeconds = 1.0 / framesPerSecond;
+    floorRiseDbPerFrame = (float) (kFloorRiseDbPerSecond * frameSeconds);
+
+    // 一段 kDecaySegmentSeconds 秒；帧数放不下就几帧合成一个点
+    const double framesPerSegment = kDecaySegmentSeconds * framesPerSecond;
+    framesPerPoint = juce::jmax (1, (int) std::ceil (framesPerSegment / kMaxDecayPoints));
+    pointSeconds = framesPerPoint * frameSeconds;
+    maxPoints = juce::jlimit (kMinDecayPoints, kMaxDecayPoints, juce::roundToInt (kDecaySegmentSeconds / pointSeconds));
+
+    reset();
+}
+
+void DecayAnalyser::reset()
+{
+    for (auto& band : bands)
+        band = {};
+}
+
+void DecayAnalyser::processFrame (const float* bandEnergies) noexcept
+{
+    for (size_t b = 0; b < (size_t) kNumBands; ++b)
+    {
+        auto& band = bands[b];
+        const float energy = bandEnergies[b];
+        const float db = 10.0f * std::log10 (energy + 1e-12f);
+
+        if (! band.hasPrevious)
+        {
+            band.hasPrevious = true;
+            band.previousEnergy = energy;
+            band.previousDb = band.floorDb = db;
+            continue;
+        }
+
+        // 噪声底：往下立即跟，往上慢慢爬
+        band.floorDb = db < band.floorDb ? db : band.floorDb + floorRiseDbPerFrame;
+
+        if (band.decaying)
+        {
+            if (db > band.previousDb + kOnsetRiseDb)
+            {
+                // 新的音头打断了这一段
+                finishSegment (band);
+            }
+            else
+            {
+                addToSegment (band, energy);
+
+                if (db < band.floorDb + kEndAboveFloorDb || band.length == maxPoints)
+                    finishSegment (band);
+            }
+        }
+        else if (band.rising && db < band.previousDb && band.previousDb > band.floorDb + kMinPeakAboveFloorDb)
+        {
+            // 上一帧是峰：从峰开始记
+            band.decaying = true;
+            band.total = 0.0;
+            band.pendingEnergy = 0.0;
+            band.pendingFrames = 0;
+            band.length = 0;
+            addToSegment (band, band.previousEnergy);
+            addToSegment (band, energy);
+        }
+
+        band.rising = db >= band.previousDb;
+        band.previousEnergy = energy;
+        band.previousDb = db;
+    }
+}
+
+void DecayAnalyser::addToSegment (Band& band, float energy) noexcept
+{
+    band.pendingEnergy += energy;
+
+    if (++band.pendingFrames < framesPerPoint || band.length >= maxPoints)
+        return;
+
+    band.prefix[(size_t) band.length++] = band.total;
+    band.total += band.pendingEnergy;
+    band.pendingEnergy = 0.0;
+    band.pendingFrames = 0;
+}
+
+void DecayAnalyser::finishSegment (Band& band) noexcept
+{
+    // 没凑满的尾巴也算一个点
+    if (band.pendingFrames > 0 && band.length < maxPoints)
+    {
+        band.prefix[(size_t) band.length++] = band.total;
+        band.total += band.pendingEnergy;
+    }
+
+    const int length = band.length;
+    const double total = band.total;
+    band.decaying = false;
+    band.length = 0;
+    band.pendingEnergy = 0.0;
+    band.pendingFrames = 0;
+
+    if (length < kMinDecayPoints || total <= 0.0)
+        return;
+
+    // Schroeder 反向积分 S[i] = sum (e[j]), j >= i = total - prefix[i]
+    // 0 .. -10 dB 这一段做最小二乘直线拟合 (x = 点，y = dB)
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    int n = 0;
+    bool reachedEnd = false;
+
+    for (int i = 0; i < length; ++i)
+    {
+        const double y = 10.0 * std::log10 ((total - band.prefix[(size_t) i]) / total + 1e-30);
+
+        if (y < -10.0)
+        {
+            reachedEnd = true;
+            break;
+        }
+
+        sumX += i;
+        sumY += y;
+        sumXX += (double) i * i;
+        sumXY += (double) i * y;
+        ++n;
+    }
+
+    // 动态范围不够 10 dB (比如被新的音头打断) 的段不可信
+    if (! reachedEnd || n < 3)
+        return;
+
+    const double denom = n * sumXX - sumX * sumX;
+    if (denom <= 0.0)
+        return;
+
+    const double slopeDbPerPoint = (n * sumXY - sumX * sumY) / denom;
+    if (slopeDbPerPoint >= 0.0)
+        return;
+
+    const float seconds = (float) juce::jlimit (0.02, 20.0, -60.0 / slopeDbPerPoint * pointSeconds);
+
+    band.decaySeconds = band.numEstimates == 0 ? seconds
+                                               : band.decaySeconds + 0.2f * (seconds - band.decaySeconds);
+    ++band.numEstimates;
+}
+
+bool DecayAnalyser::hasEstimate() const noexcept
+{
+    for (const auto& band : bands)
+        if (band.numEstimates > 0)
+            return true;
+
+    return false;
+}
+
+void DecayAnalyser::getDecayTimes (AnalysisSnapshot::EnvelopeArray& secondsOut) const noexcept
+{
+    for (size_t b = 0; b < (size_t) kNumBands; ++b)
+        secondsOut[b] = bands[b].numEstimates > 0 ? bands[b].decaySeconds : 0.0f;
+}
+
+float DecayAnalyser::getSpace() const noexcept
+{
+    // 对数平均：几个 band 里一个特别长的尾巴不会把结果拉满
+    float sumLog = 0.0f;
+    int count = 0;
+
+    for (const auto& band : bands)
+    {
+        if (band.numEstimates > 0)
+        {
+            sumLog += std::log (band.decaySeconds);
+            ++count;
+        }
+    }
+
+    if (count == 0)
+        return 0.0f;
+
+    const float meanLog = sumLog / (float) count;
+    return juce::jlimit (0.0f, 1.0f, (meanLog - std::log (0.2f)) / (std::log (4.0f) - std::log (0.2f)));
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+
+#include "AnalysisSnapshot.h"
+
+// 流式的混响尾巴 / 衰减时间估计，给 Space 维度用
+// 每帧输入 kNumBands 个频段的能量 (STFT 帧率)，每个 band 独立地：
+//   1. 跟踪噪声底 (慢速上升的最小值)
+//   2. 能量过峰开始下降、且峰比噪声底高 kMinPeakAboveFloorDb 时，开始记录一段衰减
+//   3. 掉到噪声底附近、重新上升 (新的音头) 或记满 kDecaySegmentSeconds 时结束这一段，
+//      取 Schroeder 反向积分 0 .. -10 dB 线性回归的斜率换算成 60 dB 衰减时间 (EDT)
+// 段长按秒算，不按帧：帧率高时 (小 FFT / 高 overlap / 原生高采样率) 几帧合成一个点，
+// 所以不管 STFT 配置如何，一段都是 kDecaySegmentSeconds 秒、最多 kMaxDecayPoints 个点。
+// 反向积分随帧累加：记的是从峰开始的能量前缀和，任意点的 S[i] = 总能量 - 前缀和，
+// 结束一段时只剩一遍拟合 (到 -10 dB 就停)。每帧 O(1)，内存定长，实时和 capture 都能跑。
+class DecayAnalyser
+{
+public:
+    static constexpr int kNumBands = AnalysisSnapshot::kEnvelopeBands;
+    static constexpr double kDecaySegmentSeconds = 3.0;
+    static constexpr int kMaxDecayPoints = 512;   // 默认配置 (约 94 帧 / 秒) 下一帧一个点
+
+    // 非音频线程 (不分配)
+    void prepare (double framesPerSecond);
+    void reset();
+
+    // 每帧：各 band 的能量 (功率和，线性)
+    void processFrame (const float* bandEnergies) noexcept;
+
+    // 至少有一个 band 测到过衰减
+    bool hasEstimate() const noexcept;
+
+    // 每个 band 平滑后的 EDT (秒)，没测到的为 0
+    void getDecayTimes (AnalysisSnapshot::EnvelopeArray& secondsOut) const noexcept;
+
+    // 测到的 band 的平均衰减时间映射到 0..1 (0.2 秒 -> 0，4 秒 -> 1，对数刻度)
+    float getSpace() const noexcept;
+
+private:
+    static constexpr float kMinPeakAboveFloorDb = 20.0f;   // 峰要比噪声底高这么多才算一次衰减
+    static constexpr float kOnsetRiseDb = 6.0f;            // 衰减过程中回升超过这个值 = 新的音头
+    static constexpr float kEndAboveFloorDb = 3.0f;        // 掉到噪声底 + 3 dB 就结束
+    static constexpr float kFloorRiseDbPerSecond = 3.0f;
+    static constexpr int kMinDecayPoints = 6;
+
+    struct Band
+    {
+        std::array<double, kMaxDecayPoints> prefix {};   // prefix[i] = 这一段前 i 个点的能量和
+        double total = 0.0;
+        double pendingEnergy = 0.0;   // 还没凑满 framesPerPoint 的帧
+        int pendingFrames = 0;
+        int length = 0;               // 已经记下的点数
+        bool decaying = false;
+        bool rising = false;
+
+        bool hasPrevious = false;
+        float previousEnergy = 0.0f;
+        float previousDb = 0.0f;
+        float floorDb = 0.0f;
+
+        float decaySeconds = 0.0f;   // 平滑后的估计
+        int numEstimates = 0;
+    };
+
+    void addToSegment (Band& band, float energy) noexcept;
+    void finishSegment (Band& band) noexcept;
+
+    std::array<Band, kNumBands> bands;
+    double frameSeconds = 512.0 / 48000.0;
+    double pointSeconds = 512.0 / 48000.0;
+    int framesPerPoint = 1;
+    int maxPoints = kMaxDecayPoints;
+    float floorRiseDbPerFrame = 0.0f;
+};
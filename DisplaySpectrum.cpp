@@ -0,0 +1,107 @@
+#include "DisplaySpectrum.h"
+#include "SpectralKernels.h"
+
+#include <algorithm>
+
+void DisplaySpectrum::prepare (const float* binFrequencies, int numBins, float newEquivalentNoiseBins, double framesPerSecond)
+{
+    jassert (numBins > 2 && newEquivalentNoiseBins >= 1.0f && framesPerSecond > 0.0);
+
+    equivalentNoiseBins = newEquivalentNoiseBins;
+
+    const int lastBin = numBins - 1;
+    const float* const binsEnd = binFrequencies + numBins;
+    const float halfWidth = std::exp2 (0.5f / (float) AnalysisSnapshot::kSpectrumPointsPerOctave);
+
+    for (int i = 0; i < kNumPoints; ++i)
+    {
+        const float centre = AnalysisSnapshot::getSpectrumPointHz (i);
+        auto& point = points[(size_t) i];
+
+        if (centre > binFrequencies[lastBin])
+        {
+            point = {};
+            continue;
+        }
+
+        // [centre / halfWidth, centre * halfWidth] 里的 bin (DC 不算)
+        const int first = juce::jmax (1, (int) (std::lower_bound (binFrequencies, binsEnd, centre / halfWidth) - binFrequencies));
+        const int last = juce::jmin (lastBin, (int) (std::upper_bound (binFrequencies, binsEnd, centre * halfWidth) - binFrequencies) - 1);
+
+        if (last >= first)
+        {
+            point = { first, last - first + 1, 0.0f };
+            continue;
+        }
+
+        // 点宽比 bin 间隔还窄：中心两侧的 bin 插值 (最低的 bin 以下就用 bin 1，DC 恒为 0)
+        const int below = juce::jlimit (1, lastBin - 1, (int) (std::upper_bound (binFrequencies, binsEnd, centre) - binFrequencies) - 1);
+        const float lo = binFrequencies[below];
+        const float hi = binFrequencies[below + 1];
+
+        point = { below, 0, juce::jlimit (0.0f, 1.0f, (centre - lo) / (hi - lo)) };
+    }
+
+    releasePerFrame = kReleaseDbPerSecond / (float) framesPerSecond;
+    peakDecayPerFrame = kPeakDecayDbPerSecond / (float) framesPerSecond;
+    peakHoldFrames = juce::jmax (1, (int) std::ceil (kPeakHoldSeconds * framesPerSecond));
+
+    reset();
+}
+
+void DisplaySpectrum::reset()
+{
+    levelsDb.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    peaksDb.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    holdRemaining.fill (0);
+}
+
+void DisplaySpectrum::computeLevels (const float* powerSpectrum, PointArray& levelsDbOut) const noexcept
+{
+    constexpr float floorDb = AnalysisSnapshot::kSpectrumFloorDb;
+    constexpr float fullScalePower = AnalysisSnapshot::kSpectrumFullScale * AnalysisSnapshot::kSpectrumFullScale;
+
+    for (size_t i = 0; i < (size_t) kNumPoints; ++i)
+    {
+        const auto& point = points[i];
+        float db = floorDb;
+
+        if (point.numBins >= 0)
+        {
+            // 只有一个 bin 时就是这个 bin 本身 (和插值的点接得上)
+            const float power = point.numBins > 0
+                ? SpectralKernels::sum (powerSpectrum + point.firstBin, point.numBins) / juce::jmin ((float) point.numBins, equivalentNoiseBins)
+                : powerSpectrum[point.firstBin] + point.fraction * (powerSpectrum[point.firstBin + 1] - powerSpectrum[point.firstBin]);
+
+            db = power > 0.0f ? juce::jmax (floorDb, 10.0f * std::log10 (power / fullScalePower)) : floorDb;
+        }
+
+        levelsDbOut[i] = db;
+    }
+}
+
+void DisplaySpectrum::processFrame (const float* powerSpectrum) noexcept
+{
+    computeLevels (powerSpectrum, frameDb);
+
+    for (size_t i = 0; i < (size_t) kNumPoints; ++i)
+    {
+        const float db = frameDb[i];
+
+        levelsDb[i] = juce::jmax (db, levelsDb[i] - releasePerFrame);
+
+        if (db >= peaksDb[i])
+        {
+            peaksDb[i] = db;
+            holdRemaining[i] = peakHoldFrames;
+        }
+        else if (holdRemaining[i] > 0)
+        {
+            --holdRemaining[i];
+        }
+        else
+        {
+            peaksDb[i] = juce::jmax (db, peaksDb[i] - peakDecayPerFrame);
+        }
+    }
+}
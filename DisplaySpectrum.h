@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+
+#include "AnalysisSnapshot.h"
+
+// 给 UI 的 log 频率显示谱 (AnalysisSnapshot::kSpectrumPoints 个点，1/24 倍频程，dB)
+//   - 每个点是中心 ±半个点宽 (1/48 倍频程) 里的频段功率 (bin 功率和除以窗的等效噪声带宽，
+//     正弦波的读数和 FFT 点数无关)；点比 bin 还密的地方 (低频) 在相邻两个 bin 之间按功率线性插值
+//   - 输入是任意单调的 bin 网格 (MultirateSpectrum 的合并谱)，每个点用哪些 bin 在 prepare 时算好，
+//     每帧只有一次求和 + 一次 log10
+//   - 弹道：level 立即上升、按 kReleaseDbPerSecond 下降；peak 保持 kPeakHoldSeconds 后按 kPeakDecayDbPerSecond 下降
+// UI 只按点的下标画折线，画图的开销和 FFT 点数、采样率都无关。
+class DisplaySpectrum
+{
+public:
+    static constexpr int kNumPoints = AnalysisSnapshot::kSpectrumPoints;
+    using PointArray = AnalysisSnapshot::SpectrumArray;
+
+    // 非音频线程 (不分配)：binFrequencies 单调递增，下标 0 是 DC
+    // equivalentNoiseBins 见 AnalysisConfig::getEquivalentNoiseBins
+    void prepare (const float* binFrequencies, int numBins, float equivalentNoiseBins, double framesPerSecond);
+    void reset();
+
+    // 每帧：powerSpectrum 和 prepare 时的网格一一对应，电平按 kSpectrumFftSize 点标定，输出 dBFS
+    void processFrame (const float* powerSpectrum) noexcept;
+
+    // 同样的点映射，不带弹道 (target 的长时平均 / 每帧统计用)
+    void computeLevels (const float* powerSpectrum, PointArray& levelsDbOut) const noexcept;
+
+    const PointArray& getLevels() const noexcept { return levelsDb; }
+    const PointArray& getPeaks() const noexcept  { return peaksDb; }
+
+private:
+    static constexpr float kReleaseDbPerSecond = 30.0f;
+    static constexpr double kPeakHoldSeconds = 1.5;
+    static constexpr float kPeakDecayDbPerSecond = 12.0f;
+
+    // numBins > 0：firstBin 起 numBins 个 bin 的平均功率
+    // numBins == 0：firstBin 和 firstBin + 1 之间插值
+    // numBins < 0：点在网格最高频率以上 (低采样率)，恒为 kSpectrumFloorDb
+    struct Point
+    {
+        int firstBin = 1;
+        int numBins = -1;
+        float fraction = 0.0f;
+    };
+
+    std::array<Point, kNumPoints> points {};
+    float equivalentNoiseBins = 1.5f;
+
+    float releasePerFrame = 0.0f;
+    float peakDecayPerFrame = 0.0f;
+    int peakHoldFrames = 1;
+
+    PointArray frameDb {};
+    PointArray levelsDb {};
+    PointArray peaksDb {};
+    std::array<int, kNumPoints> holdRemaining {};
+};
@@ -0,0 +1,104 @@
+#include "ErbFilterbank.h"
+#include "SpectralKernels.h"
+
+#include <algorithm>
+
+float ErbFilterbank::hzToErbRate (float hz) noexcept
+{
+    return 21.4f * std::log10 (1.0f + 0.00437f * hz);
+}
+
+float ErbFilterbank::erbRateToHz (float erbRate) noexcept
+{
+    return (std::pow (10.0f, erbRate / 21.4f) - 1.0f) / 0.00437f;
+}
+
+void ErbFilterbank::prepare (int fftSize, double sampleRate)
+{
+    const int numBins = fftSize / 2 + 1;
+    const float binHz = (float) sampleRate / (float) fftSize;
+
+    std::vector<float> frequencies ((size_t) numBins);
+
+    for (int k = 0; k < numBins; ++k)
+        frequencies[(size_t) k] = (float) k * binHz;
+
+    prepare (frequencies.data(), numBins, sampleRate);
+}
+
+void ErbFilterbank::prepare (const float* binFrequencies, int numBins, double sampleRate)
+{
+    const int lastIndex = numBins - 1;
+    const float* const binsEnd = binFrequencies + numBins;
+
+    const float fMin = 20.0f;
+    const float fMax = (float) juce::jmin (20000.0, sampleRate * 0.5);
+    const float erbMin = hzToErbRate (fMin);
+    const float erbMax = hzToErbRate (fMax);
+
+    // kNumBands + 2 个 ERB 等间隔的点：band b 的三角形从 edge[b] 到 edge[b + 2]，峰值在 edge[b + 1]
+    std::array<float, kNumBands + 2> edges {};
+
+    for (int i = 0; i < kNumBands + 2; ++i)
+        edges[(size_t) i] = erbRateToHz (erbMin + (erbMax - erbMin) * (float) i / (float) (kNumBands + 1));
+
+    weights.clear();
+    weights.reserve ((size_t) numBins * 2 + kNumBands);
+
+    for (int b = 0; b < kNumBands; ++b)
+    {
+        const float lo     = edges[(size_t) b];
+        const float centre = edges[(size_t) b + 1];
+        const float hi     = edges[(size_t) b + 2];
+
+        centreFrequencies[(size_t) b] = centre;
+
+        // [lo, hi] 里的 bin (DC 不算)
+        Row row;
+        row.firstBin = juce::jmax (1, (int) (std::lower_bound (binFrequencies, binsEnd, lo) - binFrequencies));
+        row.weightOffset = (int) weights.size();
+
+        const int lastBin = juce::jmin (lastIndex, (int) (std::upper_bound (binFrequencies, binsEnd, hi) - binFrequencies) - 1);
+        float sum = 0.0f;
+
+        for (int k = row.firstBin; k <= lastBin; ++k)
+        {
+            const float f = binFrequencies[k];
+            const float w = f <= centre ? (f - lo) / (centre - lo)
+                                        : (hi - f) / (hi - centre);
+
+            weights.push_back (juce::jmax (0.0f, w));
+            sum += weights.back();
+        }
+
+        if (sum <= 0.0f)
+        {
+            // 低频 band 比 bin 间隔还窄 (点数小的时候)：退化成离中心最近的一个 bin
+            weights.resize ((size_t) row.weightOffset);
+
+            const int above = juce::jlimit (1, lastIndex, (int) (std::lower_bound (binFrequencies, binsEnd, centre) - binFrequencies));
+            row.firstBin = above > 1 && centre - binFrequencies[above - 1] < binFrequencies[above] - centre ? above - 1 : above;
+            weights.push_back (1.0f);
+            sum = 1.0f;
+        }
+
+        row.numBins = (int) weights.size() - row.weightOffset;
+
+        // 每行归一化：输出是 band 内的加权平均功率，和带宽无关
+        for (int i = 0; i < row.numBins; ++i)
+            weights[(size_t) (row.weightOffset + i)] /= sum;
+
+        rows[(size_t) b] = row;
+    }
+}
+
+void ErbFilterbank::process (const float* powerSpectrum, std::array<float, kNumBands>& bandsOut) const noexcept
+{
+    for (size_t b = 0; b < (size_t) kNumBands; ++b)
+    {
+        const auto& row = rows[b];
+        const float acc = SpectralKernels::dot (weights.data() + row.weightOffset, powerSpectrum + row.firstBin, row.numBins);
+
+        bandsOut[b] = std::sqrt (acc);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <vector>
+
+#include "AnalysisSnapshot.h"
+
+// 96 个 ERB 间隔的三角滤波器 (20 Hz .. min (20 kHz, nyquist))，
+// 权重在 prepare 时预先算好，按稀疏行存储：每个 band 只存自己覆盖的那一段连续 bin，
+// 每帧的开销是 O(非零权重数) ≈ 2 * nyquist 次乘加，比 FFT 本身小得多。
+class ErbFilterbank
+{
+public:
+    static constexpr int kNumBands = AnalysisSnapshot::kFilterbankBands;
+
+    // 非音频线程调用：按 FFT 点数和采样率建权重矩阵
+    void prepare (int fftSize, double sampleRate);
+
+    // 非均匀的 bin 网格 (比如 MultirateSpectrum 合并后的谱)：binFrequencies[0] 是 DC，之后单调递增
+    void prepare (const float* binFrequencies, int numBins, double sampleRate);
+
+    // 音频线程：powerSpectrum 是 bin 0..nyquist (或 prepare 时给的网格) 的功率谱，
+    // 输出每个 band 的加权平均功率开方 (RMS magnitude)
+    void process (const float* powerSpectrum, std::array<float, kNumBands>& bandsOut) const noexcept;
+
+    float getCentreFrequency (int band) const noexcept { return centreFrequencies[(size_t) band]; }
+    const std::array<float, kNumBands>& getCentreFrequencies() const noexcept { return centreFrequencies; }
+
+    // Glasberg & Moore ERB-rate 刻度
+    static float hzToErbRate (float hz) noexcept;
+    static float erbRateToHz (float erbRate) noexcept;
+
+private:
+    struct Row
+    {
+        int firstBin = 0;
+        int numBins = 0;
+        int weightOffset = 0;   // 在 weights 里的起始位置
+    };
+
+    std::array<Row, kNumBands> rows;
+    std::vector<float> weights;   // 每行权重和为 1
+    std::array<float, kNumBands> centreFrequencies {};
+};
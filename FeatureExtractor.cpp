@@ -0,0 +1,161 @@
+#include "FeatureExtractor.h"
+#include "SpectralKernels.h"
+
+float FeatureExtractor::getBandEnergy (int startBin, int endBin) const noexcept
+{
+    startBin = juce::jmax (1, startBin);
+    endBin = juce::jmin (nyquistBin, endBin);
+
+    if (endBin < startBin)
+        return 0.0f;
+
+    return (float) (cumulativePower[endBin + 1] - cumulativePower[startBin]);
+}
+
+float FeatureExtractor::getBandMeanMagnitude (int startBin, int endBin) const noexcept
+{
+    startBin = juce::jmax (1, startBin);
+    endBin = juce::jmin (nyquistBin, endBin);
+
+    if (endBin < startBin)
+        return 0.0f;
+
+    const double sum = cumulativeMagnitude[endBin + 1] - cumulativeMagnitude[startBin];
+    return (float) (sum / (double) (endBin - startBin + 1));
+}
+
+void FeatureExtractor::buildLogBands (int fftSize, double sampleRate, BandRange* bandsOut, int numBands)
+{
+    const float fMin = 20.0f;
+    const float fMax = (float) juce::jmin (20000.0, sampleRate * 0.5);
+
+    const int nyquistBin = fftSize / 2;
+    auto hzToBin = [sampleRate, fftSize] (float hz)
+    {
+        const float clamped = juce::jlimit (0.0f, (float) (sampleRate * 0.5), hz);
+        return (int) std::floor (clamped * (float) fftSize / (float) sampleRate);
+    };
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        const float t0 = (float) b / (float) numBands;
+        const float t1 = (float) (b + 1) / (float) numBands;
+
+        // log spacing
+        const float f0 = fMin * std::pow (fMax / fMin, t0);
+        const float f1 = fMin * std::pow (fMax / fMin, t1);
+
+        int start = juce::jlimit (1, nyquistBin, hzToBin (f0));
+        int end   = juce::jlimit (1, nyquistBin, hzToBin (f1));
+
+        if (end <= start) end = juce::jmin (start + 1, nyquistBin);
+
+        bandsOut[b] = { start, end };
+    }
+}
+
+void FeatureExtractor::getBandEnergies (const BandRange* bands, float* energiesOut, int numBands) const noexcept
+{
+    for (int b = 0; b < numBands; ++b)
+        energiesOut[b] = getBandEnergy (bands[b].startBin, bands[b].endBin);
+}
+
+void FeatureExtractor::getBandMeanMagnitudes (const BandRange* bands, float* magsOut, int numBands) const noexcept
+{
+    for (int b = 0; b < numBands; ++b)
+        magsOut[b] = getBandMeanMagnitude (bands[b].startBin, bands[b].endBin);
+}
+
+void FeatureExtractor::prepare (int newFftSize, double newSampleRate)
+{
+    fftSize = newFftSize;
+    nyquistBin = fftSize / 2;
+    sampleRate = newSampleRate;
+
+    brightStartBin = frequencyToBin (4000.0f);
+    bodyStartBin   = frequencyToBin (100.0f);
+    bodyEndBin     = frequencyToBin (500.0f);
+    biteStartBin   = frequencyToBin (1000.0f);
+    biteEndBin     = frequencyToBin (4000.0f);
+    airStartBin    = frequencyToBin (8000.0f);
+
+    currentMags.assign ((size_t) nyquistBin + 1, 0.0f);
+    currentPower.assign ((size_t) nyquistBin + 1, 0.0f);
+    cumulativePower.assign ((size_t) nyquistBin + 2, 0.0);
+    cumulativeMagnitude.assign ((size_t) nyquistBin + 2, 0.0);
+
+    reset();
+}
+
+void FeatureExtractor::reset()
+{
+    // 上一帧的结果清掉，第一帧之前的频段查询都是 0
+    std::fill (currentMags.begin(), currentMags.end(), 0.0f);
+    std::fill (currentPower.begin(), currentPower.end(), 0.0f);
+    std::fill (cumulativePower.begin(), cumulativePower.end(), 0.0);
+    std::fill (cumulativeMagnitude.begin(), cumulativeMagnitude.end(), 0.0);
+}
+
+//辅助函数
+int FeatureExtractor::frequencyToBin (float freqHz) const
+{
+    const float nyquist = (float) sampleRate * 0.5f;
+    const float clampedFreq = juce::jlimit (0.0f, nyquist, freqHz);
+    return (int) std::round (clampedFreq * (float) fftSize / (float) sampleRate);
+}
+
+TimbreProfile FeatureExtractor::processFrame (const float* fftData)
+{
+    TimbreProfile p;
+    
+    const int numBins = nyquistBin;
+    
+    if (fftData == nullptr || numBins <= 0)
+        return p;
+    
+    const float epsilon = 1e-10f;
+    
+    // magnitude / power 用向量化 kernel 一次算完 (bin 1..nyquist)
+    SpectralKernels::magnitude (fftData + 2, currentMags.data() + 1, numBins);
+    SpectralKernels::power (fftData + 2, currentPower.data() + 1, numBins);
+    
+    // 每帧一次前缀和，bin 0 (DC) 在 prepare 里已经置 0，不参与任何频段
+    SpectralKernels::prefixSum (currentPower.data(), cumulativePower.data(), numBins + 1);
+    SpectralKernels::prefixSum (currentMags.data(), cumulativeMagnitude.data(), numBins + 1);
+    
+    const float totalEnergy  = getBandEnergy (1, numBins);
+    const float brightEnergy = getBandEnergy (brightStartBin, numBins);
+    const float bodyEnergy   = getBandEnergy (bodyStartBin, bodyEndBin);
+    const float biteEnergy   = getBandEnergy (biteStartBin, biteEndBin);
+    const float airEnergy    = getBandEnergy (airStartBin, numBins);
+    
+    p.bright = (totalEnergy > epsilon)
+        ? juce::jlimit (0.0f, 1.0f, (brightEnergy / totalEnergy) * 3.0f)
+        : 0.0f;
+    
+    p.body = (totalEnergy > epsilon)
+        ? juce::jlimit (0.0f, 1.0f, (bodyEnergy / totalEnergy) * 5.0f)
+        : 0.0f;
+    
+    p.bite = (totalEnergy > epsilon)
+        ? juce::jlimit (0.0f, 1.0f, (biteEnergy / totalEnergy) * 4.0f)
+        : 0.0f;
+    
+    p.air = (totalEnergy > epsilon)
+        ? juce::jlimit (0.0f, 1.0f, (airEnergy / totalEnergy) * 8.0f)
+        : 0.0f;
+    
+    // Noise: 频谱平坦度 (几何平均 / 算术平均)
+    const float sumLog = SpectralKernels::sumLog (currentMags.data() + 1, epsilon, numBins);
+    const float sumLinear = (float) cumulativeMagnitude[(size_t) numBins + 1] + epsilon * (float) numBins;
+    float geometricMean = std::exp (sumLog / (float) numBins);
+    float arithmeticMean = sumLinear / (float) numBins;
+    p.noise = (arithmeticMean > epsilon)
+        ? juce::jlimit (0.0f, 1.0f, (geometricMean / arithmeticMean) * 2.0f)
+        : 0.0f;
+    
+    // Width / Motion / Space 由 AnalysisPlan 填
+    p.width = 0.5f;
+    
+    return p;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <vector>
+
+#include "AnalysisSnapshot.h"
+#include "TimbreProfile.h"
+
+// 帧驱动的音色特征提取：每出一个新的 STFT 帧 (StftFramer 触发) 只算一次，
+// 不再每个 host block 重复跑 sqrt/log。
+// Width / Motion / Space 不在这里算 (分别来自 L/R 互谱、OnsetDetector、DecayAnalyser，由 AnalysisPlan 填)。
+// per-bin 的工作都在 SpectralKernels 里 (运行时选 SIMD 版本)，点数在 prepare 时决定就够了：
+// 按点数做编译期定长的版本测下来没有更快 (0bab4e0 的 Benchmarks/FeatureExtractorBench.cpp 比过定长 / 通用两种)
+class FeatureExtractor
+{
+public:
+    // 各系数按 2048 点标定；magnitude 和 FFT 点数成正比，其他点数按这个比例换算
+    static constexpr int kReferenceFftSize = AnalysisSnapshot::kSpectrumFftSize;
+
+    // 闭区间 [startBin, endBin]
+    struct BandRange { int startBin = 0, endBin = 0; };
+
+    // 20 Hz .. min (20 kHz, nyquist) 按 log 等分成 numBands 段，写出每段的 bin 区间
+    static void buildLogBands (int fftSize, double sampleRate, BandRange* bandsOut, int numBands);
+
+    // 非音频线程调用：分配 magnitude buffer，计算各频段的 bin 边界
+    void prepare (int fftSize, double sampleRate);
+    void reset();
+
+    // fftData: JUCE performRealOnlyForwardTransform 的 interleaved re/im 输出
+    TimbreProfile processFrame (const float* fftData);
+
+    int getFftSize() const noexcept { return fftSize; }
+
+    // 最近一帧的功率谱 / magnitude 谱 bin 0..nyquist (bin 0 恒为 0)
+    const float* getPowerSpectrum() const noexcept     { return currentPower.data(); }
+    const float* getMagnitudeSpectrum() const noexcept { return currentMags.data(); }
+
+    // ---- O(1) 频段查询：processFrame 之后有效，区间自动裁到 1..nyquist ----
+    // 每帧只建一次累积数组，任意多个频段 (固定、log、用户自定义) 都只是一次减法
+    float getBandEnergy (int startBin, int endBin) const noexcept;
+    float getBandMeanMagnitude (int startBin, int endBin) const noexcept;
+    void getBandEnergies (const BandRange* bands, float* energiesOut, int numBands) const noexcept;
+    void getBandMeanMagnitudes (const BandRange* bands, float* magsOut, int numBands) const noexcept;
+
+private:
+    int frequencyToBin (float freqHz) const;
+
+    int fftSize = 0;
+    int nyquistBin = 0;
+    double sampleRate = 44100.0;
+
+    int brightStartBin = 0;
+    int bodyStartBin = 0, bodyEndBin = 0;
+    int biteStartBin = 0, biteEndBin = 0;
+    int airStartBin = 0;
+
+    std::vector<float> currentMags;
+    std::vector<float> currentPower;
+    std::vector<double> cumulativePower;       // [k] = bin 0..k-1 的能量和 (bin 0 视为 0)
+    std::vector<double> cumulativeMagnitude;
+};
@@ -0,0 +1,111 @@
+#include "HalfBandDecimator.h"
+#include "SpectralKernels.h"
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <cstring>
+
+void HalfBandDecimator::prepare (double inputRate, double passbandHz)
+{
+    // Kaiser 窗 (beta 8，约 80 dB) 的阶数估计：N - 1 = (A - 8) / (2.285 * 2 pi * 过渡带宽)
+    const double outputRate = inputRate * 0.5;
+    const double transition = juce::jmax (0.01, (outputRate - 2.0 * passbandHz) / inputRate);   // cycles / sample
+    const double estimatedLength = 1.0 + (80.0 - 8.0) / (2.285 * juce::MathConstants<double>::twoPi * transition);
+
+    // 长度取 4K - 1：中心在奇数下标上，偶数下标 2K 个非零系数
+    const int halfEven = juce::jmax (1, (int) std::ceil ((estimatedLength + 1.0) / 4.0));
+    const int numEven = 2 * halfEven;
+    const int length = 2 * numEven - 1;
+    const double centre = 0.5 * (double) (length - 1);
+
+    std::vector<float> window ((size_t) length);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables (window.data(), (size_t) length,
+                                                              juce::dsp::WindowingFunction<float>::kaiser,
+                                                              false, 8.0f);
+
+    // 截止 0.25 cycles / sample 的 sinc：h[j] = 0.5 sinc ((j - centre) / 2)，中心以外的奇数下标是 0
+    evenCoefficients.assign ((size_t) numEven, 0.0f);
+
+    for (int i = 0; i < numEven; ++i)
+    {
+        const double x = 0.5 * ((double) (2 * i) - centre);
+        const double sinc = std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+        evenCoefficients[(size_t) i] = (float) (0.5 * sinc * (double) window[(size_t) (2 * i)]);
+    }
+
+    centreCoefficient = 0.5f * window[(size_t) (numEven - 1)];
+
+    // 直流增益归一化到 1 (窗截断之后和不是正好 1)
+    double sum = centreCoefficient;
+    for (float h : evenCoefficients)
+        sum += h;
+
+    for (auto& h : evenCoefficients)
+        h = (float) (h / sum);
+
+    centreCoefficient = (float) (centreCoefficient / sum);
+
+    absoluteGain = std::abs (centreCoefficient);
+    for (float h : evenCoefficients)
+        absoluteGain += std::abs (h);
+
+    staging.assign ((size_t) (2 * kChunkPairs), 0.0f);
+    evenHistory.assign ((size_t) (numEven - 1 + kChunkPairs), 0.0f);
+    oddHistory.assign ((size_t) (halfEven + kChunkPairs), 0.0f);
+    reset();
+}
+
+void HalfBandDecimator::reset()
+{
+    std::fill (staging.begin(), staging.end(), 0.0f);
+    std::fill (evenHistory.begin(), evenHistory.end(), 0.0f);
+    std::fill (oddHistory.begin(), oddHistory.end(), 0.0f);
+    numStaged = 0;
+}
+
+int HalfBandDecimator::process (const float* input, int numInput, float* output) noexcept
+{
+    // 输出 m = sum_i h[2 i] x[2 m - 2 i] + h_c x[2 m - (2K - 1)]
+    //        = dot (偶数系数, 最近 2K 个偶数 sample) + h_c * 第 m - K 个奇数 sample
+    const int numEven = (int) evenCoefficients.size();
+    const int evenTail = numEven - 1;
+    const int oddTail = numEven / 2;
+    int numOutput = 0;
+
+    while (numInput > 0)
+    {
+        const int n = juce::jmin (numInput, 2 * kChunkPairs - numStaged);
+        std::memcpy (staging.data() + numStaged, input, (size_t) n * sizeof (float));
+        numStaged += n;
+        input += n;
+        numInput -= n;
+
+        const int numPairs = numStaged / 2;
+
+        if (numPairs == 0)
+            break;
+
+        SpectralKernels::deinterleave (staging.data(), evenHistory.data() + evenTail, oddHistory.data() + oddTail, numPairs);
+
+        // 按系数在外、输出在内累加：一块的所有输出一起做向量乘加
+        // (每个输出单独点积的话前几级只有十来个系数，调用开销比乘加还多)
+        float* out = output + numOutput;
+        juce::FloatVectorOperations::copyWithMultiply (out, oddHistory.data(), centreCoefficient, numPairs);
+
+        for (int t = 0; t < numEven; ++t)
+            juce::FloatVectorOperations::addWithMultiply (out, evenHistory.data() + t, evenCoefficients[(size_t) t], numPairs);
+
+        numOutput += numPairs;
+
+        std::memmove (evenHistory.data(), evenHistory.data() + numPairs, (size_t) evenTail * sizeof (float));
+        std::memmove (oddHistory.data(), oddHistory.data() + numPairs, (size_t) oddTail * sizeof (float));
+
+        // 凑不成对的最后一个 sample 留到下一次
+        numStaged -= 2 * numPairs;
+
+        if (numStaged > 0)
+            staging[0] = staging[(size_t) (2 * numPairs)];
+    }
+
+    return numOutput;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <vector>
+
+// 2:1 半带 FIR 抽取器 (单声道)，PolyphaseResampler 的 2 / 4 / 8 倍整数抽取用它级联。
+// 半带滤波器截止正好在输入 nyquist 的一半：除了中心，奇数下标的系数都是 0，
+// 输入按奇偶拆开后每个输出只是偶数相位的一次点积 + 中心一个乘法，点积长度是总阶数的一半。
+// 过渡带按要保留的通带定：passbandHz 以下不动，(输出采样率 - passbandHz) 以上衰减约 80 dB
+// (折叠回来正好落在 passbandHz 以上)。级联里靠前的级过渡带很宽，阶数很短。
+class HalfBandDecimator
+{
+public:
+    // 非音频线程：设计滤波器、分配 history
+    void prepare (double inputRate, double passbandHz);
+    void reset();
+
+    int getMaxOutputSamples (int numInput) const noexcept { return numInput / 2 + 1; }
+
+    // 偶数相位的系数个数 (每个输出的点积长度)；总阶数是 2 * getNumEvenTaps() - 1
+    int getNumEvenTaps() const noexcept { return (int) evenCoefficients.size(); }
+
+    // sum |h|：|输出| <= 最近 2 * getNumEvenTaps() - 1 个输入的峰值 x 这个数
+    float getAbsoluteGain() const noexcept { return absoluteGain; }
+
+    // 实时安全：不分配。返回写出的个数 (上次剩下的半对 sample 留到下一次)
+    int process (const float* input, int numInput, float* output) noexcept;
+
+private:
+    static constexpr int kChunkPairs = 128;
+
+    std::vector<float> evenCoefficients;   // h[0], h[2], ... (对称，不用反序)
+    float centreCoefficient = 0.5f;
+    float absoluteGain = 1.0f;
+
+    std::vector<float> staging;            // 收齐成对的输入
+    int numStaged = 0;
+    std::vector<float> evenHistory;        // 前 numEven - 1 个是上一块的尾巴
+    std::vector<float> oddHistory;         // 前 numEven / 2 个是上一块的尾巴
+};
@@ -0,0 +1,277 @@
+#include "LoudnessMeter.h"
+#include "SpectralKernels.h"
+
+void LoudnessMeter::prepare (double sampleRate, const juce::AudioChannelSet& layout)
+{
+    // BS.1770-4 附录里的模拟原型，按实际采样率重新做双线性变换 (44.1k / 96k 下也准确)
+    Biquad shelf, highPass;
+
+    {
+        const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+        const double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow (10.0, gainDb / 20.0);
+        const double vb = std::pow (vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        shelf.b0 = (float) ((vh + vb * k / q + k * k) / a0);
+        shelf.b1 = (float) (2.0 * (k * k - vh) / a0);
+        shelf.b2 = (float) ((vh - vb * k / q + k * k) / a0);
+        shelf.a1 = (float) (2.0 * (k * k - 1.0) / a0);
+        shelf.a2 = (float) ((1.0 - k / q + k * k) / a0);
+    }
+
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        const double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        highPass.b0 = 1.0f;
+        highPass.b1 = -2.0f;
+        highPass.b2 = 1.0f;
+        highPass.a1 = (float) (2.0 * (k * k - 1.0) / a0);
+        highPass.a2 = (float) ((1.0 - k / q + k * k) / a0);
+    }
+
+    kWeightingCoefficients = { shelf.b0, shelf.b1, shelf.b2, shelf.a1, shelf.a2,
+                               highPass.b0, highPass.b1, highPass.b2, highPass.a1, highPass.a2 };
+
+    numLayoutChannels = juce::jmin (kMaxChannels, juce::jmax (1, layout.size()));
+
+    for (int c = 0; c < kMaxChannels; ++c)
+    {
+        auto& ch = channels[(size_t) c];
+        using CT = juce::AudioChannelSet::ChannelType;
+
+        switch (c < layout.size() ? layout.getTypeOfChannel (c) : CT::unknown)
+        {
+            case CT::LFE:                ch.weight = 0.0f; break;
+            case CT::leftSurround:
+            case CT::rightSurround:
+            case CT::leftSurroundSide:
+            case CT::rightSurroundSide:
+            case CT::leftSurroundRear:
+            case CT::rightSurroundRear:  ch.weight = 1.41f; break;
+            default:                     ch.weight = 1.0f; break;
+        }
+
+        ch.truePeakOversampler.prepare (sampleRate, sampleRate * kTruePeakOversampling, kTruePeakTapsPerPhase);
+    }
+
+    samplesPerStep = juce::jmax (1, juce::roundToInt (sampleRate * 0.1));
+    truePeakBuffer.assign ((size_t) channels[0].truePeakOversampler.getMaxOutputSamples (kTruePeakBlockSize), 0.0f);
+
+    // 多留 0.1% 盖住 float 点积的舍入
+    truePeakGainBound = channels[0].truePeakOversampler.getMaxPhaseGain() * 1.001f;
+
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    for (auto& state : kWeightingState)
+        state.fill (0.0f);
+
+    for (auto& ch : channels)
+    {
+        ch.truePeakOversampler.reset();
+        ch.recentPeak = 0.0f;
+    }
+
+    stepSamples = 0;
+    currentStep = {};
+    stepHistory.fill ({});
+    stepWrite = 0;
+    numSteps = 0;
+
+    histogramCounts.fill (0);
+    histogramPower.fill (0.0);
+
+    truePeak = 0.0f;
+    reading = {};
+}
+
+void LoudnessMeter::process (const float* const* input, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin (numChannels, numLayoutChannels);
+    int offset = 0;
+
+    while (offset < numSamples)
+    {
+        // 按 100 ms 的步边界切开，每一步结束时更新读数
+        const int n = juce::jmin (numSamples - offset, samplesPerStep - stepSamples);
+
+        processKWeighting (input, numChannels, offset, n);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            auto& ch = channels[(size_t) c];
+            const float* data = input[c] + offset;
+
+            const auto range = juce::FloatVectorOperations::findMinAndMax (data, n);
+            currentStep.peak = juce::jmax (currentStep.peak, -range.getStart(), range.getEnd());
+
+            currentStep.squares += (double) SpectralKernels::dot (data, data, n);
+
+            currentStep.channelSamples += n;
+
+            processTruePeak (ch, data, n);
+        }
+
+        offset += n;
+        stepSamples += n;
+
+        if (stepSamples == samplesPerStep)
+            finishStep();
+    }
+}
+
+void LoudnessMeter::processKWeighting (const float* const* input, int numChannels, int offset, int numSamples) noexcept
+{
+    for (int group = 0; group * kKWeightingLanes < numChannels; ++group)
+    {
+        const int first = group * kKWeightingLanes;
+        const int numLanes = juce::jmin (kKWeightingLanes, numChannels - first);
+
+        // 凑不满 4 个声道的 lane 重复读这组的第一个声道，结果不用
+        std::array<const float*, kKWeightingLanes> lanes;
+        bool anyWeighted = false;
+
+        for (int lane = 0; lane < kKWeightingLanes; ++lane)
+        {
+            const int c = first + (lane < numLanes ? lane : 0);
+            lanes[(size_t) lane] = input[c] + offset;
+            anyWeighted = anyWeighted || channels[(size_t) c].weight > 0.0f;
+        }
+
+        // 只有 LFE 的组不计入响度
+        if (! anyWeighted)
+            continue;
+
+        std::array<double, kKWeightingLanes> squares;
+        SpectralKernels::biquadCascade4 (lanes.data(), kWeightingCoefficients.data(), kWeightingState[(size_t) group].data(),
+                                         squares.data(), numSamples);
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            const float weight = channels[(size_t) (first + lane)].weight;
+
+            if (weight > 0.0f)
+                currentStep.weightedSquares += squares[(size_t) lane] * weight;
+        }
+    }
+}
+
+void LoudnessMeter::processTruePeak (ChannelState& ch, const float* input, int numSamples) noexcept
+{
+    for (int offset = 0; offset < numSamples; offset += kTruePeakBlockSize)
+    {
+        const int n = juce::jmin (kTruePeakBlockSize, numSamples - offset);
+
+        // 这一块的每个输出只用到这一块和之前 taps - 1 个输入
+        const auto inputRange = juce::FloatVectorOperations::findMinAndMax (input + offset, n);
+        const float blockPeak = juce::jmax (-inputRange.getStart(), inputRange.getEnd());
+        const float windowPeak = juce::jmax (blockPeak, ch.recentPeak);
+        ch.recentPeak = n >= ch.truePeakOversampler.getTapsPerPhase() - 1 ? blockPeak : windowPeak;
+
+        if (windowPeak * truePeakGainBound <= truePeak)
+        {
+            ch.truePeakOversampler.skip (input + offset, n);
+            continue;
+        }
+
+        const int numOut = ch.truePeakOversampler.process (input + offset, n, truePeakBuffer.data());
+
+        const auto range = juce::FloatVectorOperations::findMinAndMax (truePeakBuffer.data(), numOut);
+        truePeak = juce::jmax (truePeak, -range.getStart(), range.getEnd());
+    }
+}
+
+void LoudnessMeter::finishStep() noexcept
+{
+    stepHistory[(size_t) stepWrite] = currentStep;
+    stepWrite = (stepWrite + 1) % kStepsPerShortTerm;
+    numSteps = juce::jmin (numSteps + 1, kStepsPerShortTerm);
+    currentStep = {};
+    stepSamples = 0;
+
+    // 最近 k 步的和 (ring 从 stepWrite 往回数)
+    auto sumRecent = [this] (int numRecent)
+    {
+        Step sum;
+        for (int i = 1; i <= numRecent; ++i)
+        {
+            const auto& s = stepHistory[(size_t) ((stepWrite - i + kStepsPerShortTerm) % kStepsPerShortTerm)];
+            sum.weightedSquares += s.weightedSquares;
+            sum.squares += s.squares;
+            sum.peak = juce::jmax (sum.peak, s.peak);
+            sum.channelSamples += s.channelSamples;
+        }
+        return sum;
+    };
+
+    const double stepLength = (double) samplesPerStep;
+
+    if (numSteps >= kStepsPerMomentary)
+    {
+        const double meanSquare = sumRecent (kStepsPerMomentary).weightedSquares / (stepLength * kStepsPerMomentary);
+        reading.momentaryLufs = toLufs (meanSquare);
+
+        // 每 100 ms 一个 400 ms 块 = 75% 重叠，直接拿 momentary 当 gating 块
+        if (reading.momentaryLufs > kHistogramMinLufs)
+        {
+            const int bin = juce::jlimit (0, kHistogramBins - 1,
+                                          (int) ((reading.momentaryLufs - kHistogramMinLufs) / kHistogramStepLu));
+            ++histogramCounts[(size_t) bin];
+            histogramPower[(size_t) bin] += meanSquare;
+        }
+
+        updateIntegrated();
+    }
+
+    const auto shortTerm = sumRecent (numSteps);
+
+    if (numSteps == kStepsPerShortTerm)
+        reading.shortTermLufs = toLufs (shortTerm.weightedSquares / (stepLength * kStepsPerShortTerm));
+
+    const double rms = std::sqrt (shortTerm.squares / (double) juce::jmax (1, shortTerm.channelSamples));
+    reading.crestFactorDb = rms > 1e-9 && shortTerm.peak > 0.0f ? (float) (20.0 * std::log10 (shortTerm.peak / rms)) : 0.0f;
+    reading.truePeakDb = truePeak > 0.0f ? 20.0f * std::log10 (truePeak) : kSilenceLufs;
+}
+
+void LoudnessMeter::updateIntegrated() noexcept
+{
+    // 第一遍：绝对门限以上所有块的平均 -> 相对门限
+    double power = 0.0;
+    int count = 0;
+
+    for (int i = 0; i < kHistogramBins; ++i)
+    {
+        power += histogramPower[(size_t) i];
+        count += histogramCounts[(size_t) i];
+    }
+
+    if (count == 0)
+        return;
+
+    const float relativeGate = toLufs (power / count) - 10.0f;
+    const int firstBin = juce::jlimit (0, kHistogramBins,
+                                       (int) std::ceil ((relativeGate - kHistogramMinLufs) / kHistogramStepLu));
+
+    // 第二遍：相对门限以上的块 (按 0.1 LU 的格子取整)
+    power = 0.0;
+    count = 0;
+
+    for (int i = firstBin; i < kHistogramBins; ++i)
+    {
+        power += histogramPower[(size_t) i];
+        count += histogramCounts[(size_t) i];
+    }
+
+    if (count > 0)
+        reading.integratedLufs = toLufs (power / count);
+}
+
+float LoudnessMeter::toLufs (double meanSquare) noexcept
+{
+    return meanSquare > 1e-20 ? (float) (-0.691 + 10.0 * std::log10 (meanSquare)) : kSilenceLufs;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <array>
+#include <vector>
+
+#include "PolyphaseResampler.h"
+
+// ITU-R BS.1770 / EBU R128 响度表，和音色分析并排跑
+//   - K-weighting (高架 + RLB 高通两级 biquad)：每 4 个声道一组，一个声道一个 SIMD lane
+//     (立体声是一组里的两个 lane，5.1 / 7.1 是两组)，每个 lane 各自累加平方和再乘声道权重
+//   - 100 ms 一步：momentary = 最近 4 步 (400 ms)，short-term = 最近 30 步 (3 s)
+//   - integrated：400 ms 块、75% 重叠，-70 LUFS 绝对门限 + -10 LU 相对门限；
+//     块响度放进 0.1 LU 的直方图里，内存固定，跑多久都不会增长
+//   - true-peak：4x 多相过采样后的最大绝对值；输入峰值乘上滤波器增益上界都到不了当前读数的块
+//     不可能刷新它，这些块只推进过采样器的状态，不算输出 (结果和全算一样)
+//   - crest factor：short-term 窗口内 sample peak / RMS
+// 声道权重按布局：LFE 不计，环绕声道 +1.5 dB (1.41)，其它 1.0。
+class LoudnessMeter
+{
+public:
+    static constexpr int kMaxChannels = 8;
+    static constexpr float kSilenceLufs = -100.0f;   // 还没有数据 / 全部被门限挡掉
+
+    struct Reading
+    {
+        float momentaryLufs = kSilenceLufs;
+        float shortTermLufs = kSilenceLufs;
+        float integratedLufs = kSilenceLufs;
+        float truePeakDb = kSilenceLufs;       // dBTP，reset 以来的最大值
+        float crestFactorDb = 0.0f;            // short-term 窗口
+    };
+
+    // 非音频线程：按采样率算滤波器系数，按布局定声道权重，分配过采样 buffer
+    void prepare (double sampleRate, const juce::AudioChannelSet& layout);
+    void reset();
+
+    // 音频线程 / worker：不分配
+    void process (const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    const Reading& getReading() const noexcept { return reading; }
+
+private:
+    static constexpr int kStepsPerMomentary = 4;
+    static constexpr int kStepsPerShortTerm = 30;
+    static constexpr float kHistogramMinLufs = -70.0f;   // 绝对门限
+    static constexpr float kHistogramStepLu = 0.1f;
+    static constexpr int kHistogramBins = 800;           // -70 .. +10 LUFS
+    static constexpr int kTruePeakOversampling = 4;
+    static constexpr int kTruePeakTapsPerPhase = 12;
+    static constexpr int kTruePeakBlockSize = 256;
+    static constexpr int kKWeightingLanes = 4;
+    static constexpr int kKWeightingGroups = kMaxChannels / kKWeightingLanes;
+
+    struct Biquad
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    struct ChannelState
+    {
+        float weight = 1.0f;
+        PolyphaseResampler truePeakOversampler;
+        float recentPeak = 0.0f;      // 过采样器 history 里那些输入的峰值 (上界)
+    };
+
+    struct Step
+    {
+        double weightedSquares = 0.0;   // K-weighted、按声道权重加权的平方和
+        double squares = 0.0;           // 不加权的平方和 (crest factor 用)
+        float peak = 0.0f;              // sample peak
+        int channelSamples = 0;         // squares 里累加了多少个 sample (声道数 x 长度)
+    };
+
+    void processKWeighting (const float* const* input, int numChannels, int offset, int numSamples) noexcept;
+    void processTruePeak (ChannelState& ch, const float* input, int numSamples) noexcept;
+    void finishStep() noexcept;
+    void updateIntegrated() noexcept;
+
+    static float toLufs (double meanSquare) noexcept;
+
+    // 两级 {b0, b1, b2, a1, a2}，每组的 TDF-II 状态按 SpectralKernels::biquadCascade4 的布局排
+    std::array<float, 10> kWeightingCoefficients {};
+    std::array<std::array<float, 4 * kKWeightingLanes>, kKWeightingGroups> kWeightingState {};
+    std::array<ChannelState, kMaxChannels> channels;
+    int numLayoutChannels = 0;
+
+    int samplesPerStep = 4800;
+    int stepSamples = 0;                                     // 当前这一步已经累加了多少 sample
+    Step currentStep;
+    std::array<Step, kStepsPerShortTerm> stepHistory {};    // ring，最近 30 步
+    int stepWrite = 0;
+    int numSteps = 0;
+
+    std::array<int, kHistogramBins> histogramCounts {};
+    std::array<double, kHistogramBins> histogramPower {};   // 每格里块的 mean square 之和
+
+    std::vector<float> truePeakBuffer;
+    float truePeakGainBound = 1.0f;   // 过采样输出 / 输入峰值的上界
+    float truePeak = 0.0f;
+
+    Reading reading;
+};
@@ -0,0 +1,101 @@
+#include "MultirateSpectrum.h"
+#include "FeatureExtractor.h"
+#include "SpectralKernels.h"
+
+MultirateSpectrum::MultirateSpectrum() = default;
+
+void MultirateSpectrum::prepare (const AnalysisConfig& mainConfig, double sampleRate)
+{
+    const int mainFftSize = mainConfig.getFftSize();
+    const int lowFftSize = 1 << kLowFftOrder;
+
+    // 抽取后的 nyquist 留够余量覆盖 crossover (抽取滤波器在 0.45 * 输出采样率处截止)
+    decimationFactor = sampleRate >= 44100.0 ? 8 : 4;
+
+    const double lowRate = sampleRate / decimationFactor;
+    const float lowBinHz = (float) (lowRate / lowFftSize);
+    const float mainBinHz = (float) (sampleRate / mainFftSize);
+
+    mainNyquistBin = mainFftSize / 2;
+    active = lowBinHz < mainBinHz && kCrossoverHz < 0.4f * (float) lowRate;
+
+    lowCrossoverBin = active ? (int) (kCrossoverHz / lowBinHz) : 0;
+    mainFirstBin = active ? (int) (kCrossoverHz / mainBinHz) + 1 : 1;
+
+    const auto reference = (float) FeatureExtractor::kReferenceFftSize;
+    lowPowerScale = juce::square (reference / (float) lowFftSize);
+    mainPowerScale = juce::square (reference / (float) mainFftSize);
+
+    // 合并网格：DC + 低频段 1..lowCrossoverBin + 主 FFT mainFirstBin..nyquist
+    frequencies.clear();
+    frequencies.push_back (0.0f);
+
+    for (int k = 1; k <= lowCrossoverBin; ++k)
+        frequencies.push_back ((float) k * lowBinHz);
+
+    for (int k = mainFirstBin; k <= mainNyquistBin; ++k)
+        frequencies.push_back ((float) k * mainBinHz);
+
+    mergedPower.assign (frequencies.size(), 0.0f);
+
+    if (active)
+    {
+        AnalysisConfig lowConfig = mainConfig;
+        lowConfig.fftOrder = kLowFftOrder;
+        lowConfig.overlap = 0.75f;
+
+        decimator.prepareDecimator (sampleRate, decimationFactor);
+        lowFramer.prepare (lowConfig);
+        decimated.assign ((size_t) decimator.getMaxOutputSamples (kDecimatedBlockSize), 0.0f);
+        lowFrame.assign ((size_t) lowFftSize * 2, 0.0f);
+        lowPower.assign ((size_t) lowCrossoverBin + 1, 0.0f);
+    }
+
+    reset();
+}
+
+void MultirateSpectrum::reset()
+{
+    std::fill (mergedPower.begin(), mergedPower.end(), 0.0f);
+    std::fill (lowPower.begin(), lowPower.end(), 0.0f);
+    lowBandReady = false;
+
+    if (active)
+    {
+        decimator.reset();
+        lowFramer.reset();
+    }
+}
+
+void MultirateSpectrum::process (const float* mid, int numSamples) noexcept
+{
+    if (! active)
+        return;
+
+    for (int offset = 0; offset < numSamples; offset += kDecimatedBlockSize)
+    {
+        const int n = juce::jmin (kDecimatedBlockSize, numSamples - offset);
+        const int numDecimated = decimator.process (mid + offset, n, decimated.data());
+
+        lowFramer.process (decimated.data(), numDecimated, lowFrame.data(), [this]
+        {
+            lowFft.performRealOnlyForwardTransform (lowFrame.data(), true);
+            SpectralKernels::power (lowFrame.data() + 2, lowPower.data() + 1, lowCrossoverBin);
+            lowBandReady = true;
+        });
+    }
+}
+
+void MultirateSpectrum::merge (const float* mainPower) noexcept
+{
+    float* out = mergedPower.data() + 1;
+
+    if (active)
+    {
+        juce::FloatVectorOperations::copyWithMultiply (out, lowPower.data() + 1, lowPowerScale, lowCrossoverBin);
+        out += lowCrossoverBin;
+    }
+
+    juce::FloatVectorOperations::copyWithMultiply (out, mainPower + mainFirstBin, mainPowerScale,
+                                                   mainNyquistBin - mainFirstBin + 1);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <vector>
+
+#include "AnalysisConfig.h"
+#include "PolyphaseResampler.h"
+#include "StftFramer.h"
+
+// 多速率前端：低频段单独抽取后用小 FFT 分析，和主 FFT 的高频段拼成一张谱
+//   - Mid 先按 getDecimationFactor() (4 或 8) 抽取，再做 kLowFftOrder 点的 STFT：
+//     48k 下抽 8 倍是 6 kHz，2048 点 bin 间隔约 2.9 Hz，和 48k 上 16384 点一样细，
+//     但每个输入 sample 只多一次抽取滤波 + 1/8 的小 FFT
+//   - kCrossoverHz 以下用低频段的 bin，以上用主 FFT 的 bin；两边都换算到
+//     kReferenceFftSize 点的电平 (正弦波在哪个网格上读数都一样)
+//   - 主 FFT 本身已经够细 (bin 间隔不比低频段大) 时不启用，合并谱就是主 FFT 的谱
+class MultirateSpectrum
+{
+public:
+    static constexpr int kLowFftOrder = 11;
+    static constexpr float kCrossoverHz = 1000.0f;
+
+    MultirateSpectrum();
+
+    // 非音频线程：按主分析配置和分析采样率分配抽取器 / 分帧器 / 合并网格
+    void prepare (const AnalysisConfig& mainConfig, double sampleRate);
+    void reset();
+
+    bool isActive() const noexcept { return active; }
+    int getDecimationFactor() const noexcept { return decimationFactor; }
+
+    // 合并谱里下标 1..getNumLowBins() 来自低频段；reset 之后低频段要先凑满自己的一帧
+    // (抽取后 2^kLowFftOrder 个 sample)，在那之前这一段是 0
+    int getNumLowBins() const noexcept { return lowCrossoverBin; }
+    bool hasLowBandFrame() const noexcept { return ! active || lowBandReady; }
+
+    // 音频线程：分析采样率上的 Mid (时域)，抽取后推进低频段的分帧器
+    void process (const float* mid, int numSamples) noexcept;
+
+    // 音频线程：主 FFT 出新帧之后调用，mainPower 是主 FFT bin 0..nyquist 的功率谱
+    void merge (const float* mainPower) noexcept;
+
+    // 合并后的网格：下标 0 是 DC (功率恒为 0)，频率单调递增
+    int getNumBins() const noexcept              { return (int) frequencies.size(); }
+    const float* getFrequencies() const noexcept { return frequencies.data(); }
+    const float* getPowerSpectrum() const noexcept { return mergedPower.data(); }
+
+private:
+    static constexpr int kDecimatedBlockSize = 256;
+
+    juce::dsp::FFT lowFft { kLowFftOrder };
+    PolyphaseResampler decimator;
+    StftFramer lowFramer;
+
+    bool active = false;
+    bool lowBandReady = false;
+    int decimationFactor = 1;
+    int lowCrossoverBin = 0;     // 低频段用到第几个 bin (含)
+    int mainFirstBin = 1;        // 主 FFT 从第几个 bin 开始用
+    int mainNyquistBin = 0;
+    float lowPowerScale = 1.0f;  // (kReferenceFftSize / N)^2
+    float mainPowerScale = 1.0f;
+
+    std::vector<float> decimated;
+    std::vector<float> lowFrame;     // 2 * N (JUCE real FFT)
+    std::vector<float> lowPower;     // 低频段最近一帧的功率谱，bin 0..lowCrossoverBin
+    std::vector<float> frequencies;
+    std::vector<float> mergedPower;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultirateSpectrum)
+};
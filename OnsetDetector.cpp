@@ -0,0 +1,155 @@
+#include "OnsetDetector.h"
+#include "SpectralKernels.h"
+
+void OnsetDetector::prepare (int newNumBins, int fftSize, double newFramesPerSecond, double densityWindowSeconds)
+{
+    jassert (newNumBins > 0 && newFramesPerSecond > 0.0);
+
+    numBins = newNumBins;
+    framesPerSecond = newFramesPerSecond;
+    silenceThreshold = kSilencePerBin * (float) fftSize * (float) numBins;
+
+    auto toFrames = [this] (double seconds) { return juce::jlimit (1, kHistoryFrames, (int) std::ceil (seconds * framesPerSecond)); };
+    thresholdFrames = toFrames (kThresholdSeconds);
+    peakFrames = toFrames (kPeakSeconds);
+    minIntervalFrames = juce::jmax (1, (int) std::ceil (kMinIntervalSeconds * framesPerSecond));
+    densityWindowFrames = densityWindowSeconds > 0.0 ? (int64_t) std::ceil (densityWindowSeconds * framesPerSecond) : 0;
+
+    // 点数不变时 assign 不会重新分配
+    previousMags.assign ((size_t) numBins, 0.0f);
+
+    reset();
+}
+
+void OnsetDetector::reset()
+{
+    std::fill (previousMags.begin(), previousMags.end(), 0.0f);
+    hasPrevious = false;
+
+    fluxHistory.fill (0.0f);
+    historyWrite = 0;
+    historySize = 0;
+    lastFlux = 0.0f;
+
+    frameIndex = 0;
+    lastOnsetFrame = -1;
+
+    onsets.fill ({});
+    onsetWrite = 0;
+    numStoredOnsets = 0;
+    totalOnsets = 0;
+    totalStrength = 0.0;
+}
+
+bool OnsetDetector::processFrame (const float* mags) noexcept
+{
+    // sum (max (a - b, 0)) = (sum |a - b| + sum a - sum b) / 2，三个现成的向量 kernel 就够了
+    const float currentSum = SpectralKernels::sum (mags, numBins);
+    const float previousSum = SpectralKernels::sum (previousMags.data(), numBins);
+    const float rising = 0.5f * (SpectralKernels::sumAbsDiff (mags, previousMags.data(), numBins)
+                                 + currentSum - previousSum);
+
+    std::copy (mags, mags + numBins, previousMags.begin());
+
+    // 除以两帧里较大的那个：能量往下掉的时候 (尾巴离开窗口)，残留噪声的起伏不会被放大成音头
+    const bool silent = currentSum < silenceThreshold;
+    const float flux = hasPrevious && ! silent ? juce::jlimit (0.0f, 1.0f, rising / juce::jmax (currentSum, previousSum)) : 0.0f;
+    hasPrevious = true;
+
+    // 门限 / 峰值窗口都只看之前的帧
+    float mean = 0.0f, recentMax = 0.0f;
+    const int numMean = juce::jmin (thresholdFrames, historySize);
+    const int numPeak = juce::jmin (peakFrames, historySize);
+
+    for (int i = 1; i <= numMean; ++i)
+    {
+        const float previous = fluxHistory[(size_t) ((historyWrite - i + kHistoryFrames) % kHistoryFrames)];
+        mean += previous;
+
+        if (i <= numPeak)
+            recentMax = juce::jmax (recentMax, previous);
+    }
+
+    mean = numMean > 0 ? mean / (float) numMean : 0.0f;
+
+    const bool isOnset = ! silent
+                      && flux >= recentMax
+                      && flux >= mean * kThresholdRatio + kThresholdDelta
+                      && (lastOnsetFrame < 0 || frameIndex - lastOnsetFrame >= minIntervalFrames);
+
+    if (isOnset)
+    {
+        const float strength = juce::jlimit (0.0f, 1.0f, (flux - mean) / flux);
+
+        onsets[(size_t) onsetWrite] = { frameIndex, strength };
+        onsetWrite = (onsetWrite + 1) % kMaxOnsets;
+        numStoredOnsets = juce::jmin (numStoredOnsets + 1, kMaxOnsets);
+
+        ++totalOnsets;
+        totalStrength += strength;
+        lastOnsetFrame = frameIndex;
+    }
+
+    fluxHistory[(size_t) historyWrite] = flux;
+    historyWrite = (historyWrite + 1) % kHistoryFrames;
+    historySize = juce::jmin (historySize + 1, kHistoryFrames);
+    lastFlux = flux;
+    ++frameIndex;
+
+    return isOnset;
+}
+
+int OnsetDetector::getOnsetTimes (std::array<float, kMaxOnsets>& timesOut) const noexcept
+{
+    const int first = (onsetWrite - numStoredOnsets + kMaxOnsets) % kMaxOnsets;
+
+    for (int i = 0; i < numStoredOnsets; ++i)
+        timesOut[(size_t) i] = (float) ((double) onsets[(size_t) ((first + i) % kMaxOnsets)].frame / framesPerSecond);
+
+    return numStoredOnsets;
+}
+
+float OnsetDetector::getOnsetDensity() const noexcept
+{
+    if (frameIndex == 0)
+        return 0.0f;
+
+    if (densityWindowFrames == 0)
+        return (float) ((double) totalOnsets * framesPerSecond / (double) frameIndex);
+
+    // 窗口还没满时按已经跑过的长度算
+    const int64_t window = juce::jmin (densityWindowFrames, frameIndex);
+    int count = 0;
+
+    for (int i = 1; i <= numStoredOnsets; ++i)
+    {
+        if (frameIndex - onsets[(size_t) ((onsetWrite - i + kMaxOnsets) % kMaxOnsets)].frame > window)
+            break;
+
+        ++count;
+    }
+
+    return (float) ((double) count * framesPerSecond / (double) window);
+}
+
+float OnsetDetector::getAttackStrength() const noexcept
+{
+    if (densityWindowFrames == 0)
+        return totalOnsets > 0 ? (float) (totalStrength / (double) totalOnsets) : 0.0f;
+
+    float sum = 0.0f;
+    int count = 0;
+
+    for (int i = 1; i <= numStoredOnsets; ++i)
+    {
+        const auto& onset = onsets[(size_t) ((onsetWrite - i + kMaxOnsets) % kMaxOnsets)];
+
+        if (frameIndex - onset.frame > densityWindowFrames)
+            break;
+
+        sum += onset.strength;
+        ++count;
+    }
+
+    return count > 0 ? sum / (float) count : 0.0f;
+}
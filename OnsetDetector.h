@@ -0,0 +1,88 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <vector>
+
+// 流式的音头 (onset / transient) 检测，给 Motion 和 Bite 用
+// 每个 STFT 帧输入一次 Mid 的 magnitude 谱：
+//   1. spectral flux：只算上升的部分 sum (max (|X_n| - |X_n-1|, 0))，再除以两帧 sum |X| 里较大的，
+//      和电平无关 (0 = 没变化，1 = 从静音里冒出来)
+//   2. 自适应门限：前 kThresholdSeconds 的平均 flux x kThresholdRatio + kThresholdDelta
+//      (乘一个比例：噪声底在尾巴结束后慢慢回来时 flux 也会缓慢上升，不能算音头)
+//   3. 峰值挑选：不小于前 kPeakSeconds 内的最大值、超过门限、离上一个音头至少 kMinIntervalSeconds
+// 只往回看，不需要 lookahead，实时和 capture 走同一套逻辑。
+class OnsetDetector
+{
+public:
+    static constexpr int kMaxOnsets = 64;   // 最近的音头时间保留这么多个
+
+    // 非音频线程 (bin 数不变时不分配，worker 每次整段分析前也会调用)
+    // densityWindowSeconds <= 0：密度 / 力度按整段统计 (capture 用)，否则只看最近这么长
+    void prepare (int numBins, int fftSize, double framesPerSecond, double densityWindowSeconds);
+    void reset();
+
+    // 每帧：mags 是 bin 1..numBins 的 magnitude；这一帧是音头时返回 true
+    bool processFrame (const float* mags) noexcept;
+
+    // 从 reset 算起的时间 (秒，按帧起点算)
+    double getTimeSeconds() const noexcept { return (double) frameIndex / framesPerSecond; }
+    float getLastFlux() const noexcept     { return lastFlux; }
+
+    // 最近的音头时间 (秒，和 getTimeSeconds 同一时间轴，从旧到新)，返回个数
+    int getOnsetTimes (std::array<float, kMaxOnsets>& timesOut) const noexcept;
+
+    // 每秒多少个音头
+    float getOnsetDensity() const noexcept;
+
+    // 音头的平均力度 0..1：峰值 flux 高出门限前的平均值多少 (从静音里起的音头接近 1)
+    float getAttackStrength() const noexcept;
+
+    // 密度映射到 Motion (kFullMotionDensity 个/秒 -> 1)
+    float getMotion() const noexcept { return juce::jlimit (0.0f, 1.0f, getOnsetDensity() / kFullMotionDensity); }
+
+    // Bite 的频谱比例按音头力度加权：没有音头时减半，音头越硬越接近原值
+    float getBiteWeight() const noexcept { return 0.5f + 0.5f * getAttackStrength(); }
+
+private:
+    static constexpr int kHistoryFrames = 64;              // flux 历史 (门限 / 峰值窗口都在这里面)
+    static constexpr double kThresholdSeconds = 0.1;
+    static constexpr double kPeakSeconds = 0.03;
+    static constexpr double kMinIntervalSeconds = 0.05;
+    static constexpr float kThresholdRatio = 1.5f;
+    static constexpr float kThresholdDelta = 0.05f;
+    static constexpr float kSilencePerBin = 1e-5f;         // 每 bin 平均 magnitude / fftSize 低于这个不检测
+    static constexpr float kFullMotionDensity = 8.0f;
+
+    struct Onset
+    {
+        int64_t frame = 0;
+        float strength = 0.0f;
+    };
+
+    int numBins = 0;
+    float silenceThreshold = 0.0f;     // sum |X| 低于这个视为静音
+    double framesPerSecond = 48000.0 / 512.0;
+    int thresholdFrames = 1, peakFrames = 1, minIntervalFrames = 1;
+    int64_t densityWindowFrames = 0;   // 0 = 整段
+
+    std::vector<float> previousMags;
+    bool hasPrevious = false;
+
+    std::array<float, kHistoryFrames> fluxHistory {};
+    int historyWrite = 0;
+    int historySize = 0;
+    float lastFlux = 0.0f;
+
+    int64_t frameIndex = 0;
+    int64_t lastOnsetFrame = -1;
+
+    std::array<Onset, kMaxOnsets> onsets {};   // ring，最近的音头
+    int onsetWrite = 0;
+    int numStoredOnsets = 0;
+
+    // 整段统计 (densityWindowFrames == 0 时用)
+    int64_t totalOnsets = 0;
+    double totalStrength = 0.0;
+};
@@ -0,0 +1,65 @@
+#include "OnsetEnvelope.h"
+
+#include <cmath>
+
+void OnsetEnvelope::prepare (double newSampleRate, double maxSeconds)
+{
+    jassert (newSampleRate > 0.0 && maxSeconds > 0.0);
+
+    sampleRate = newSampleRate;
+    values.assign ((size_t) std::ceil (maxSeconds * kValuesPerSecond) + 1, 0.0f);
+
+    reset();
+}
+
+void OnsetEnvelope::reset()
+{
+    numValues = 0;
+    samplePosition = 0;
+    nextBoundary = (juce::int64) std::llround (sampleRate / kValuesPerSecond);
+    energySum = 0.0;
+    energyCount = 0;
+    previousMid = 0.0f;
+    previousDb = kFloorDb;
+}
+
+void OnsetEnvelope::process (const float* left, const float* right, int numSamples) noexcept
+{
+    int i = 0;
+
+    while (i < numSamples && numValues < (int) values.size())
+    {
+        // 到这一格结束为止的 sample 一口气累加完
+        const int n = (int) juce::jmin ((juce::int64) (numSamples - i), nextBoundary - samplePosition);
+
+        for (int k = i; k < i + n; ++k)
+        {
+            const float mid = 0.5f * (left[k] + right[k]);
+            const float diff = mid - previousMid;
+            energySum += (double) (diff * diff);
+            previousMid = mid;
+        }
+
+        energyCount += n;
+        samplePosition += n;
+        i += n;
+
+        if (samplePosition == nextBoundary)
+            finishValue();
+    }
+}
+
+void OnsetEnvelope::finishValue() noexcept
+{
+    const double meanEnergy = energySum / (double) juce::jmax (1, energyCount);
+    const float db = juce::jmax (kFloorDb, (float) (10.0 * std::log10 (meanEnergy + 1e-12)));
+
+    // 第一格没有 "上一格" (capture 多半从歌的中间开始)，不算上涨
+    values[(size_t) numValues] = numValues > 0 ? juce::jmax (0.0f, db - previousDb) : 0.0f;
+    previousDb = db;
+    ++numValues;
+
+    energySum = 0.0;
+    energyCount = 0;
+    nextBoundary = (juce::int64) std::llround ((double) (numValues + 1) * sampleRate / kValuesPerSecond);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <vector>
+
+// 对齐用的音头包络：Mid 先做一阶差分 (突出瞬态、压掉低频的长音)，每 10 ms 出一个值 =
+// 这 10 ms 的 log 能量比上一格涨了多少 dB (只取上涨)。
+// 每格的边界按累计时间算，和采样率 / block 大小无关：capture 和不同采样率的 reference 文件
+// 出来的包络是同一个时间网格，可以直接做互相关 (ReferenceAligner)。
+class OnsetEnvelope
+{
+public:
+    static constexpr double kValuesPerSecond = 100.0;
+
+    // 非音频线程：最多存 maxSeconds 的包络 (一次分配)
+    void prepare (double sampleRate, double maxSeconds);
+    void reset();
+
+    // 任意长度的一段 L/R，不分配 (超出容量的部分丢掉)
+    void process (const float* left, const float* right, int numSamples) noexcept;
+
+    const float* getValues() const noexcept { return values.data(); }
+    int getNumValues() const noexcept       { return numValues; }
+
+private:
+    static constexpr float kFloorDb = -80.0f;   // 比这还安静的格当成静音，不让噪声底的起伏算成音头
+
+    void finishValue() noexcept;
+
+    double sampleRate = 44100.0;
+    std::vector<float> values;
+    int numValues = 0;
+
+    juce::int64 samplePosition = 0;
+    juce::int64 nextBoundary = 0;        // 当前这一格结束的 sample
+    double energySum = 0.0;
+    int energyCount = 0;
+    float previousMid = 0.0f;
+    float previousDb = kFloorDb;
+};
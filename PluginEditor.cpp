@@ -101,13 +101,27 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
         addAndMakeVisible (diffValueLabels[i]);
     }
 
+    // ====== 响度 (表格下面，target / current 各一行) ======
+    for (auto* label : { &targetLoudnessLabel, &currentLoudnessLabel })
+    {
+        label->setText ("-", juce::dontSendNotification);
+        label->setJustificationType (juce::Justification::centredLeft);
+        label->setFont (juce::Font (13.0f));
+        addAndMakeVisible (*label);
+    }
+
     // ====== Buttons ======
     addAndMakeVisible (captureButton);
+    addAndMakeVisible (alignButton);
     addAndMakeVisible (compareButton);
     
     captureButton.onClick = [this]
     {
-        processorRef.beginCaptureSeconds (2.0);
+        // 正在录的时候再按一次 = 停止
+        if (processorRef.isCaptureActive())
+            processorRef.stopCapture();
+        else
+            processorRef.beginCaptureSeconds (2.0);
         statusLabel.setText (processorRef.getStatusText(), juce::dontSendNotification);
         
         // 清空 Diff 列
@@ -115,6 +129,17 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
             diffValueLabels[i].setText ("-", juce::dontSendNotification);
     };
 
+    // 导入 reference 后，在 host 播放时录一段和 reference 对齐 (target 不变)
+    alignButton.onClick = [this]
+    {
+        if (! processorRef.canAlignReference())
+            statusLabel.setText ("Import a reference file first", juce::dontSendNotification);
+        else if (! processorRef.beginAlignmentSeconds (kAlignSeconds))
+            statusLabel.setText ("Busy: wait for the current capture / import to finish", juce::dontSendNotification);
+        else
+            statusLabel.setText (processorRef.getStatusText(), juce::dontSendNotification);
+    };
+
     compareButton.onClick = [this]
     {
         processorRef.performCompare();
@@ -149,11 +174,34 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
         }
     };
 
+    // ====== Target 库 (表格最下面) ======
+    addAndMakeVisible (saveToLibraryButton);
+    saveToLibraryButton.onClick = [this]
+    {
+        const auto name = "Target " + juce::Time::getCurrentTime().formatted ("%Y-%m-%d %H:%M:%S");
+
+        if (! processorRef.hasTarget())
+            statusLabel.setText ("Capture or import a target first", juce::dontSendNotification);
+        else if (! processorRef.saveTargetToLibrary (name))
+            statusLabel.setText (processorRef.isLibraryUnreadable() ? "The library file is unreadable: not overwriting it"
+                                                                    : "Could not write the target library",
+                                 juce::dontSendNotification);
+        else
+            statusLabel.setText ("Saved \"" + name + "\" to the library", juce::dontSendNotification);
+    };
+
+    libraryLabel.setText ("Library: empty", juce::dontSendNotification);
+    libraryLabel.setJustificationType (juce::Justification::centredLeft);
+    libraryLabel.setFont (juce::Font (13.0f));
+    addAndMakeVisible (libraryLabel);
+
     // ====== Status Label ======
     addAndMakeVisible (statusLabel);
     statusLabel.setText (processorRef.getStatusText(), juce::dontSendNotification);
     statusLabel.setJustificationType (juce::Justification::centred);
     statusLabel.setFont (juce::Font (13.0f));
+    
+    addChildComponent (importProgressBar);
 
     startTimerHz (10);
 }
@@ -169,6 +217,50 @@ void AudioPluginAudioProcessorEditor::paint (juce::Graphics& g)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 }
 
+void AudioPluginAudioProcessorEditor::paintOverChildren (juce::Graphics& g)
+{
+    // 拖着能导入的文件经过时描个边
+    if (fileDragActive)
+    {
+        g.setColour (juce::Colours::lightgreen);
+        g.drawRect (getLocalBounds(), 3);
+    }
+}
+
+//拖放导入 reference
+bool AudioPluginAudioProcessorEditor::isInterestedInFileDrag (const juce::StringArray& files)
+{
+    return files.size() == 1 && processorRef.canImportTargetFile (juce::File (files[0]));
+}
+
+void AudioPluginAudioProcessorEditor::fileDragEnter (const juce::StringArray&, int, int)
+{
+    fileDragActive = true;
+    repaint();
+}
+
+void AudioPluginAudioProcessorEditor::fileDragExit (const juce::StringArray&)
+{
+    fileDragActive = false;
+    repaint();
+}
+
+void AudioPluginAudioProcessorEditor::filesDropped (const juce::StringArray& files, int, int)
+{
+    fileDragActive = false;
+    repaint();
+
+    // worker 正忙 (在录 / 在分析 / 上一个文件还没读完) 时不接
+    if (! processorRef.importTargetFile (juce::File (files[0])))
+    {
+        statusLabel.setText ("Busy: wait for the current capture or import to finish", juce::dontSendNotification);
+        return;
+    }
+
+    for (size_t i = 0; i < 8; ++i)
+        diffValueLabels[i].setText ("-", juce::dontSendNotification);
+}
+
 //窗口打开函数
 void AudioPluginAudioProcessorEditor::openIntermediateWindow()
 {
@@ -219,16 +311,19 @@ void AudioPluginAudioProcessorEditor::resized()
     // ===== 状态文字 =====
     const int statusH = 50;
     statusLabel.setBounds (area.removeFromTop (statusH));
+    importProgressBar.setBounds (statusLabel.getBounds().withSizeKeepingCentre (statusLabel.getWidth(), 24));
     area.removeFromTop (12);
 
     // ===== 按钮 =====
     const int buttonH = 44;
     auto buttonArea = area.removeFromTop (buttonH);
     const int capButtonGap = 10;
-    int capButtonWidth = (buttonArea.getWidth() - capButtonGap) / 2;
+    int capButtonWidth = (buttonArea.getWidth() - capButtonGap * 2) / 3;
     
     captureButton.setBounds (buttonArea.removeFromLeft (capButtonWidth));
     buttonArea.removeFromLeft (capButtonGap);
+    alignButton.setBounds (buttonArea.removeFromLeft (capButtonWidth));
+    buttonArea.removeFromLeft (capButtonGap);
     compareButton.setBounds (buttonArea);
     
     area.removeFromTop (18);
@@ -272,12 +367,28 @@ void AudioPluginAudioProcessorEditor::resized()
         currentValueLabels[i].setBounds (colCurrent.removeFromTop (rowH));
         diffValueLabels[i].setBounds (colDiff.removeFromTop (rowH));
     }
+
+    // ===== 响度 =====
+    auto loudnessArea = area;
+    loudnessArea.removeFromTop (headerH + headerGap + rowH * (int) nameLabels.size() + 12);
+    targetLoudnessLabel.setBounds (loudnessArea.removeFromTop (22));
+    currentLoudnessLabel.setBounds (loudnessArea.removeFromTop (22));
+
+    // ===== Target 库 =====
+    loudnessArea.removeFromTop (8);
+    auto libraryArea = loudnessArea.removeFromTop (28);
+    saveToLibraryButton.setBounds (libraryArea.removeFromLeft (130));
+    libraryArea.removeFromLeft (10);
+    libraryLabel.setBounds (libraryArea);
 }
 
 void AudioPluginAudioProcessorEditor::timerCallback()
 {
+    // 每次刷新只取一份 snapshot，所有控件显示的是同一时刻的数据
+    const auto snapshot = processorRef.getSnapshot();
+    
     // 更新 Current 列
-    const auto current = processorRef.getCurrentProfileArray();
+    const auto current = snapshot.current.toArray();
     for (size_t i = 0; i < 8; ++i)
     {
         currentValueLabels[i].setText (juce::String (current[i], 2), juce::dontSendNotification);
@@ -285,25 +396,81 @@ void AudioPluginAudioProcessorEditor::timerCallback()
     
     // 更新 Target 列
     std::array<float, 8> target {};
-    if (processorRef.hasTarget())
+    if (snapshot.targetReady)
     {
-        target = processorRef.getTargetProfileArray();
+        target = snapshot.target.toArray();
         for (size_t i = 0; i < 8; ++i)
         {
             targetValueLabels[i].setText (juce::String (target[i], 2), juce::dontSendNotification);
         }
     }
     
+    // 更新响度
+    currentLoudnessLabel.setText (formatLoudness ("Current", snapshot.currentLoudness), juce::dontSendNotification);
+    targetLoudnessLabel.setText (snapshot.targetReady ? formatLoudness ("Target", snapshot.targetLoudness) : "Target: -",
+                                 juce::dontSendNotification);
+    
+    // 库里最近的几条 (每次刷新对整个库扫一遍)
+    updateLibraryMatches (snapshot.current);
+
     // 更新雷达图
     radarChart.setCurrentData (current);
     radarChart.setTargetData (target);
     
-    // 更新状态文字
-    if (!processorRef.hasTarget())
+    // 导入进度直接读 worker (不依赖音频线程在跑)
+    const bool importing = processorRef.isImportingTarget();
+    importProgress = processorRef.getImportProgress();
+    importProgressBar.setVisible (importing);
+    statusLabel.setVisible (! importing);
+    
+    // 更新状态文字 (target 刚分析完成 / 导入刚结束时也刷新一次，把 "Analysing..." 换掉；
+    // 对齐中、状态变了、开始 / 停止跟随 reference 时也刷新)
+    const bool targetReadyNow = snapshot.targetReady;
+    if (!targetReadyNow || !lastTargetReady || importing || lastImporting
+        || snapshot.status == AnalysisSnapshot::Status::Aligning || snapshot.status != lastStatus
+        || snapshot.followingReference != lastFollowing)
     {
         statusLabel.setText (processorRef.getStatusText(), juce::dontSendNotification);
     }
+    lastTargetReady = targetReadyNow;
+    lastImporting = importing;
+    lastStatus = snapshot.status;
+    lastFollowing = snapshot.followingReference;
 }
 
+void AudioPluginAudioProcessorEditor::updateLibraryMatches (const TimbreProfile& current)
+{
+    ProfileLibrary::MatchArray matches;
+    const int numMatches = processorRef.findLibraryMatches (current, matches, kLibraryMatches);
+
+    if (numMatches == 0)
+    {
+        libraryLabel.setText (processorRef.isLibraryUnreadable() ? "Library: unreadable file" : "Library: empty",
+                              juce::dontSendNotification);
+        return;
+    }
+
+    juce::String text ("Nearest of " + juce::String (processorRef.getLibrarySize()) + ":");
+
+    for (int i = 0; i < numMatches; ++i)
+    {
+        const auto& match = matches[(size_t) i];
+        text += "  " + processorRef.getLibraryEntryName (match.index) + " (" + juce::String (match.distance, 2) + ")";
+    }
 
+    libraryLabel.setText (text, juce::dontSendNotification);
+}
 
+juce::String AudioPluginAudioProcessorEditor::formatLoudness (const char* name, const LoudnessMeter::Reading& reading)
+{
+    auto lufs = [] (float value)
+    {
+        return value <= LoudnessMeter::kSilenceLufs ? juce::String ("-inf") : juce::String (value, 1);
+    };
+    
+    return juce::String (name) + ":  M " + lufs (reading.momentaryLufs)
+         + "  S " + lufs (reading.shortTermLufs)
+         + "  I " + lufs (reading.integratedLufs) + " LUFS"
+         + "   TP " + lufs (reading.truePeakDb) + " dBTP"
+         + "   Crest " + juce::String (reading.crestFactorDb, 1) + " dB";
+}
@@ -5,6 +5,7 @@
 #include <array>
 #include <memory>
 
+#include "LoudnessMeter.h"
 #include "RadarChartComponent.h"
 #include "SpectrumWindow.h"
 
@@ -12,6 +13,7 @@ class AudioPluginAudioProcessor;
 
 class AudioPluginAudioProcessorEditor final
     : public juce::AudioProcessorEditor,
+      public juce::FileDragAndDropTarget,
       private juce::Timer
 {
 public:
@@ -19,8 +21,15 @@ public:
     ~AudioPluginAudioProcessorEditor() override;
 
     void paint (juce::Graphics&) override;
+    void paintOverChildren (juce::Graphics&) override;
     void resized() override;
 
+    // 拖一个 reference 文件 (WAV / AIFF / FLAC) 进来当 target
+    bool isInterestedInFileDrag (const juce::StringArray& files) override;
+    void fileDragEnter (const juce::StringArray& files, int x, int y) override;
+    void fileDragExit (const juce::StringArray& files) override;
+    void filesDropped (const juce::StringArray& files, int x, int y) override;
+
 private:
     AudioPluginAudioProcessor& processorRef;
 
@@ -46,10 +55,29 @@ private:
     std::array<juce::Label, 8> targetValueLabels;
     std::array<juce::Label, 8> currentValueLabels;
     juce::Label statusLabel;
+    juce::Label targetLoudnessLabel;
+    juce::Label currentLoudnessLabel;
     juce::TextButton captureButton { "Capture" };
+    juce::TextButton alignButton { "Align" };
     juce::TextButton compareButton { "Compare" };
+    juce::TextButton saveToLibraryButton { "Save to Library" };
+    juce::Label libraryLabel;          // current 在 target 库里最近的几条
+    bool lastTargetReady = false;
+    bool lastImporting = false;
+    AnalysisSnapshot::Status lastStatus = AnalysisSnapshot::Status::Idle;
+    bool lastFollowing = false;
+
+    static constexpr double kAlignSeconds = 20.0;   // 对齐用的 capture 长度
+    static constexpr int kLibraryMatches = 3;
+
+    // 导入 reference 时盖在状态文字上；进度由 timerCallback 从 worker 读
+    double importProgress = 0.0;
+    juce::ProgressBar importProgressBar { importProgress };
+    bool fileDragActive = false;
 
     void timerCallback() override;
+    static juce::String formatLoudness (const char* name, const LoudnessMeter::Reading& reading);
+    void updateLibraryMatches (const TimbreProfile& current);
     void openIntermediateWindow();
     void openAdvancedWindow();
 
@@ -13,336 +13,320 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
                        )
 #endif
 {
-    for (auto& a : currentEnvAtomic) a.store (0.0f, std::memory_order_relaxed);
-    for (auto& a : current01)        a.store (0.0f, std::memory_order_relaxed);
     for (int i = 0; i < 8; ++i)
         diffValues[i].store(0.0f, std::memory_order_relaxed);
     
-    targetReady.store (false);
+    for (auto* spectrum : { &targetSpectrumData, &targetSpectrumLow, &targetSpectrumMedian, &targetSpectrumHigh })
+        spectrum->fill (AnalysisSnapshot::kSpectrumFloorDb);
     
-    // 音色分析初始化
-    hasPreviousFrame = false;
-    previousFrameEnergy.fill (0.0f);
-}
-
-
-AudioPluginAudioProcessor::TimbreProfile
-AudioPluginAudioProcessor::analyseBufferToProfile (const juce::AudioBuffer<float>& monoBuffer,
-                                                   double sampleRate)
-{
-    TimbreProfile p;
-    
-    if (monoBuffer.getNumSamples() <= 0)
-        return p;
-    
-    const int analysisFFTSize = 4096;
-    const int analysisFFTOrder = 12;
-    juce::dsp::FFT analysisFFT (analysisFFTOrder);
-    juce::dsp::WindowingFunction<float> analysisWindow (
-        (size_t) analysisFFTSize,
-        juce::dsp::WindowingFunction<float>::hann
-    );
-    
-    std::vector<float> fftWorkBuffer ((size_t) analysisFFTSize * 2, 0.0f);
-    
-    const float* inputData = monoBuffer.getReadPointer (0);
-    const int numSamples = monoBuffer.getNumSamples();
-    const int hopSize = analysisFFTSize / 2;
-    const int nyquistBin = analysisFFTSize / 2;
-    const float epsilon = 1e-10f;
-    
-    // 频率 bin 边界
-    auto freqToBin = [&](float hz) {
-        return (int) std::round (hz * (float) analysisFFTSize / (float) sampleRate);
+    // 后台分析完成 (worker 线程)：交给音频线程，由它放进下一份 snapshot
+    analysisWorker.onProfileReady = [this] (const AnalysisWorker::CaptureResult& result)
+    {
+        targetHandoff.getWriteBuffer() = result;
+        targetHandoff.publish();
     };
-    
-    const int brightStartBin = freqToBin (4000.0f);
-    const int bodyStartBin   = freqToBin (100.0f);
-    const int bodyEndBin     = freqToBin (500.0f);
-    const int biteStartBin   = freqToBin (1000.0f);
-    const int biteEndBin     = freqToBin (4000.0f);
-    const int airStartBin    = freqToBin (8000.0f);
-    
-    float totalBright = 0.0f;
-    float totalBody = 0.0f;
-    float totalBite = 0.0f;
-    float totalAir = 0.0f;
-    float totalNoise = 0.0f;
-    float totalMotion = 0.0f;
-    int frameCount = 0;
-    
-    std::vector<float> prevFrameMags ((size_t) nyquistBin + 1, 0.0f);
-    bool hasPrevFrame = false;
-    
-    for (int frameStart = 0; frameStart + analysisFFTSize <= numSamples; frameStart += hopSize)
+
+    analysisWorker.onTrackReady = [this] (std::unique_ptr<ReferenceTrack> track)
     {
-        std::fill (fftWorkBuffer.begin(), fftWorkBuffer.end(), 0.0f);
-        for (int i = 0; i < analysisFFTSize; ++i)
-            fftWorkBuffer[(size_t) i] = inputData[frameStart + i];
-        
-        analysisWindow.multiplyWithWindowingTable (fftWorkBuffer.data(), (size_t) analysisFFTSize);
-        analysisFFT.performRealOnlyForwardTransform (fftWorkBuffer.data());
-        
-        float totalEnergy = 0.0f;
-        float brightEnergy = 0.0f;
-        float bodyEnergy = 0.0f;
-        float biteEnergy = 0.0f;
-        float airEnergy = 0.0f;
-        
-        std::vector<float> currentMags ((size_t) nyquistBin + 1, 0.0f);
-        
-        for (int bin = 1; bin <= nyquistBin; ++bin)
-        {
-            float re = fftWorkBuffer[(size_t) bin * 2];
-            float im = fftWorkBuffer[(size_t) bin * 2 + 1];
-            float mag = std::sqrt (re * re + im * im);
-            currentMags[(size_t) bin] = mag;
-            
-            float energy = mag * mag;
-            totalEnergy += energy;
-            
-            if (bin >= brightStartBin)
-                brightEnergy += energy;
-            if (bin >= bodyStartBin && bin <= bodyEndBin)
-                bodyEnergy += energy;
-            if (bin >= biteStartBin && bin <= biteEndBin)
-                biteEnergy += energy;
-            if (bin >= airStartBin)
-                airEnergy += energy;
-        }
-        
-        totalBright += (totalEnergy > epsilon) ? (brightEnergy / totalEnergy) : 0.0f;
-        totalBody += (totalEnergy > epsilon) ? (bodyEnergy / totalEnergy) : 0.0f;
-        totalBite += (totalEnergy > epsilon) ? (biteEnergy / totalEnergy) : 0.0f;
-        totalAir += (totalEnergy > epsilon) ? (airEnergy / totalEnergy) : 0.0f;
-        
-        // Noise: 频谱平坦度
-        float sumLog = 0.0f;
-        float sumLinear = 0.0f;
-        for (int bin = 1; bin <= nyquistBin; ++bin)
-        {
-            float mag = currentMags[(size_t) bin] + epsilon;
-            sumLog += std::log (mag);
-            sumLinear += mag;
-        }
-        float geometricMean = std::exp (sumLog / (float) nyquistBin);
-        float arithmeticMean = sumLinear / (float) nyquistBin;
-        totalNoise += (arithmeticMean > epsilon) ? (geometricMean / arithmeticMean) : 0.0f;
-        
-        // Motion: 帧间变化
-        if (hasPrevFrame)
-        {
-            float motionSum = 0.0f;
-            for (int bin = 1; bin <= nyquistBin; ++bin)
-            {
-                float diff = std::abs (currentMags[(size_t) bin] - prevFrameMags[(size_t) bin]);
-                motionSum += diff;
-            }
-            totalMotion += motionSum / (float) nyquistBin;
-        }
-        
-        prevFrameMags = currentMags;
-        hasPrevFrame = true;
-        frameCount++;
-    }
-    
-    if (frameCount > 0)
+        publishTrack (std::move (track));
+    };
+
+    analysisWorker.onAlignmentReady = [this] (const AnalysisWorker::ReferenceMapping& mapping)
     {
-        float invCount = 1.0f / (float) frameCount;
-        
-        p.bright = juce::jlimit (0.0f, 1.0f, totalBright * invCount * 3.0f);
-        p.body   = juce::jlimit (0.0f, 1.0f, totalBody * invCount * 5.0f);
-        p.bite   = juce::jlimit (0.0f, 1.0f, totalBite * invCount * 4.0f);
-        p.air    = juce::jlimit (0.0f, 1.0f, totalAir * invCount * 8.0f);
-        p.noise  = juce::jlimit (0.0f, 1.0f, totalNoise * invCount * 2.0f);
-        p.motion = juce::jlimit (0.0f, 1.0f, totalMotion * invCount * 0.5f);
-        p.width  = 0.5f;
-        p.space  = juce::jlimit (0.0f, 1.0f, p.air * 0.5f + (1.0f - p.motion) * 0.3f);
-    }
-    
-    return p;
+        alignmentHandoff.getWriteBuffer() = mapping;
+        alignmentHandoff.publish();
+    };
+
+    // 打不开 (损坏 / 版本不对) 时当空库显示，但不会往里存 (见 isLibraryUnreadable)
+    profileLibrary.open (ProfileLibrary::getDefaultFile());
 }
 
+
 //
-AudioPluginAudioProcessor::TimbreProfile
-AudioPluginAudioProcessor::analyseCurrentBlockToProfile (const juce::AudioBuffer<float>& buffer,
-                                                         double sampleRate)
+void AudioPluginAudioProcessor::publishCurrentProfile (const TimbreProfile& profile)
 {
-    juce::ignoreUnused (sampleRate);
-    TimbreProfile p;
-    
-    if (buffer.getNumSamples() <= 0 || !bandBinsReady)
-        return p;
-    
-    const int nyquistBin = kFFTSize / 2;
-    const float epsilon = 1e-10f;
-    
-    const int brightStartBin = frequencyToBin (4000.0f);
-    const int bodyStartBin   = frequencyToBin (100.0f);
-    const int bodyEndBin     = frequencyToBin (500.0f);
-    const int biteStartBin   = frequencyToBin (1000.0f);
-    const int biteEndBin     = frequencyToBin (4000.0f);
-    const int airStartBin    = frequencyToBin (8000.0f);
-    
-    float totalEnergy = 0.0f;
-    float brightEnergy = 0.0f;
-    float bodyEnergy = 0.0f;
-    float biteEnergy = 0.0f;
-    float airEnergy = 0.0f;
-    
-    std::array<float, kFFTSize / 2 + 1> currentMags {};
-    currentMags.fill (0.0f);
-    
-    for (int bin = 1; bin <= nyquistBin; ++bin)
-    {
-        float re = fftBuffer[(size_t) bin * 2];
-        float im = fftBuffer[(size_t) bin * 2 + 1];
-        float mag = std::sqrt (re * re + im * im);
-        currentMags[(size_t) bin] = mag;
-        
-        float energy = mag * mag;
-        totalEnergy += energy;
-        
-        if (bin >= brightStartBin)
-            brightEnergy += energy;
-        if (bin >= bodyStartBin && bin <= bodyEndBin)
-            bodyEnergy += energy;
-        if (bin >= biteStartBin && bin <= biteEndBin)
-            biteEnergy += energy;
-        if (bin >= airStartBin)
-            airEnergy += energy;
-    }
-    
-    p.bright = (totalEnergy > epsilon)
-        ? juce::jlimit (0.0f, 1.0f, (brightEnergy / totalEnergy) * 3.0f)
-        : 0.0f;
-    
-    p.body = (totalEnergy > epsilon)
-        ? juce::jlimit (0.0f, 1.0f, (bodyEnergy / totalEnergy) * 5.0f)
-        : 0.0f;
-    
-    p.bite = (totalEnergy > epsilon)
-        ? juce::jlimit (0.0f, 1.0f, (biteEnergy / totalEnergy) * 4.0f)
-        : 0.0f;
+    currentProfile = profile;
+    snapshotDirty = true;
+}
+
+// 音频线程：整份填好再发布，UI 不会读到一半新一半旧的数据
+void AudioPluginAudioProcessor::publishSnapshot (AnalysisWorker::CaptureState captureState)
+{
+    auto& s = snapshotBuffer.getWriteBuffer();
     
-    p.air = (totalEnergy > epsilon)
-        ? juce::jlimit (0.0f, 1.0f, (airEnergy / totalEnergy) * 8.0f)
-        : 0.0f;
+    s.version = ++snapshotVersion;
     
-    // Noise
-    float sumLog = 0.0f;
-    float sumLinear = 0.0f;
-    for (int bin = 1; bin <= nyquistBin; ++bin)
+    if (activePlan != nullptr)
     {
-        float mag = currentMags[(size_t) bin] + epsilon;
-        sumLog += std::log (mag);
-        sumLinear += mag;
-    }
-    float geometricMean = std::exp (sumLog / (float) nyquistBin);
-    float arithmeticMean = sumLinear / (float) nyquistBin;
-    p.noise = (arithmeticMean > epsilon)
-        ? juce::jlimit (0.0f, 1.0f, (geometricMean / arithmeticMean) * 2.0f)
-        : 0.0f;
-    
-    // Motion
-    if (hasPreviousFrame)
-    {
-        float motionSum = 0.0f;
-        for (size_t i = 0; i < kBands; ++i)
-        {
-            int bin = (int) (i * (size_t) nyquistBin / kBands) + 1;
-            float diff = std::abs (currentMags[(size_t) bin] - previousFrameEnergy[i]);
-            motionSum += diff;
-        }
-        p.motion = juce::jlimit (0.0f, 1.0f, (motionSum / (float) kBands) * 0.5f);
-    }
-    
-    // Width
-    if (buffer.getNumChannels() >= 2)
-    {
-        const float* left = buffer.getReadPointer (0);
-        const float* right = buffer.getReadPointer (1);
-        
-        float sumLR = 0.0f, sumL2 = 0.0f, sumR2 = 0.0f;
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            sumLR += left[i] * right[i];
-            sumL2 += left[i] * left[i];
-            sumR2 += right[i] * right[i];
-        }
-        
-        float denom = std::sqrt (sumL2 * sumR2) + epsilon;
-        float correlation = sumLR / denom;
-        p.width = juce::jlimit (0.0f, 1.0f, (1.0f - correlation) * 0.5f + 0.25f);
+        s.spectrum = activePlan->getDisplaySpectrum().getLevels();
+        s.spectrumPeaks = activePlan->getDisplaySpectrum().getPeaks();
     }
     else
     {
-        p.width = 0.5f;
+        s.spectrum.fill (AnalysisSnapshot::kSpectrumFloorDb);
+        s.spectrumPeaks.fill (AnalysisSnapshot::kSpectrumFloorDb);
     }
-    
-    // Space
-    p.space = juce::jlimit (0.0f, 1.0f, p.air * 0.5f + (1.0f - p.motion) * 0.3f + 0.1f);
-    
-    // 保存当前帧
-    for (size_t i = 0; i < kBands; ++i)
+    s.targetSpectrum = targetSpectrumData;
+    s.targetSpectrumLow = targetSpectrumLow;
+    s.targetSpectrumMedian = targetSpectrumMedian;
+    s.targetSpectrumHigh = targetSpectrumHigh;
+    s.currentEnvelope = currentEnv;
+    s.streamEnvelopes = streamEnvelopes;
+    s.bandCorrelation = bandCorrelation;
+    s.bandCoherence = bandCoherence;
+    s.bandDecaySeconds = bandDecaySeconds;
+    s.onsetTimes = onsetTimes;
+    s.numOnsets = numOnsets;
+    s.onsetDensity = onsetDensity;
+    s.targetOnsetDensity = targetOnsetDensity;
+    s.currentBands = currentBands;
+    s.targetBands = targetBands;
+    
+    if (activePlan != nullptr)
+        s.bandCentreHz = activePlan->getFilterbankCentres();
+    
+    // 跟着 reference 走时，target 换成播放位置那一格 (百分位包络仍是整段的)
+    const bool following = activeTrack != nullptr && referenceFrame >= 0;
+    const auto& target = following ? activeTrack->getProfile (referenceFrame) : targetProfile;
+    
+    if (following)
+        activeTrack->getSpectrum (referenceFrame, s.targetSpectrum);
+    
+    s.current = currentProfile;
+    s.target = target;
+    s.followingReference = following;
+    s.referenceSeconds = following ? (float) referenceSeconds : 0.0f;
+    s.referenceAligned = referenceAligned;
+    s.referenceOffsetSeconds = referenceAligned ? (float) (referenceMapping.alignment.offsetSeconds - referenceMapping.hostStartSeconds) : 0.0f;
+    s.referenceDrift = referenceAligned ? (float) referenceMapping.alignment.drift : 0.0f;
+    s.currentLoudness = loudnessMeter.getReading();
+    s.targetLoudness = targetLoudness;
+    s.targetReady = targetReady;
+    
+    const auto targetArr = target.toArray();
+    const auto currentArr = currentProfile.toArray();
+    for (size_t i = 0; i < 8; ++i)
+        s.diff[i] = targetReady ? targetArr[i] - currentArr[i] : 0.0f;
+    
+    using CS = AnalysisWorker::CaptureState;
+    switch (captureState)
     {
-        int bin = (int) (i * (size_t) nyquistBin / kBands) + 1;
-        previousFrameEnergy[i] = currentMags[(size_t) bin];
+        case CS::StartRequested:  s.status = AnalysisSnapshot::Status::WaitingForCapture; break;
+        case CS::Capturing:
+        case CS::StopRequested:
+        case CS::Finished:
+            if (analysisWorker.isAligning())        s.status = AnalysisSnapshot::Status::Aligning;
+            else if (captureState == CS::Finished)  s.status = AnalysisSnapshot::Status::Analysing;
+            else                                    s.status = AnalysisSnapshot::Status::Capturing;
+            break;
+        case CS::Importing:       s.status = AnalysisSnapshot::Status::Importing; break;
+        case CS::Idle:
+        case CS::Aborted:
+        default:
+            if (targetReady)          s.status = AnalysisSnapshot::Status::TargetReady;
+            else if (captureStopped)  s.status = AnalysisSnapshot::Status::Stopped;
+            else                      s.status = AnalysisSnapshot::Status::Idle;
+            break;
     }
-    hasPreviousFrame = true;
+    s.captureProgress = analysisWorker.getCaptureProgress();
+    s.error = analysisWorker.getCaptureError();
     
-    return p;
+    snapshotBuffer.publish();
+    snapshotDirty = false;
 }
 
+AnalysisSnapshot AudioPluginAudioProcessor::getSnapshot() const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    snapshotBuffer.fetch();
+    return snapshotBuffer.getReadBuffer();
+}
 
 
 //
 void AudioPluginAudioProcessor::beginCaptureSeconds (double seconds)
 {
-    // 1. 计算要抓多少 samples
-        captureLengthSamples = (int) (seconds * lastSampleRate);
+    // 上一次 capture 还在录/分析时不能重新开始；
+    // 真正开始由音频线程在下一个 block 边界接手
+    analysisWorker.startCapture ((int) (seconds * lastSampleRate));
+}
 
-        // 2. 重置写指针 & 状态
-        captureWritePos = 0;
-        isCapturing = true;
+void AudioPluginAudioProcessor::stopCapture()
+{
+    if (! isCaptureActive())
+        return;
+    
+    analysisWorker.stopCapture();
+}
+
+bool AudioPluginAudioProcessor::beginAlignmentSeconds (double seconds)
+{
+    return analysisWorker.startAlignment ((int) (seconds * lastSampleRate));
+}
 
-        // 3. 准备 buffer（单声道）
-        captureBuffer.setSize (1, captureLengthSamples);
-        captureBuffer.clear();
+bool AudioPluginAudioProcessor::canAlignReference() const
+{
+    return analysisWorker.hasReference();
+}
 
-        // 4. UI / 状态
-        statusText = "Capturing target...";
-        targetReady.store (false);
-    statusText = "Capturing target... " + juce::String (seconds, 1) + "s";
-    targetReady.store (false);
+bool AudioPluginAudioProcessor::isCaptureActive() const
+{
+    const auto state = analysisWorker.getCaptureState();
+    return state == AnalysisWorker::CaptureState::StartRequested
+        || state == AnalysisWorker::CaptureState::Capturing;
+}
+
+bool AudioPluginAudioProcessor::importTargetFile (const juce::File& file)
+{
+    // 正在录 / 分析 / 导入时不接；结果和 capture 一样经 targetHandoff 交给音频线程
+    return analysisWorker.importFile (file);
+}
+
+bool AudioPluginAudioProcessor::canImportTargetFile (const juce::File& file) const
+{
+    return analysisWorker.canImportFile (file);
+}
+
+bool AudioPluginAudioProcessor::isImportingTarget() const
+{
+    return analysisWorker.getCaptureState() == AnalysisWorker::CaptureState::Importing;
+}
+
+float AudioPluginAudioProcessor::getImportProgress() const
+{
+    return isImportingTarget() ? analysisWorker.getCaptureProgress() : 0.0f;
 }
 
 
 bool AudioPluginAudioProcessor::hasTarget() const
 {
-    return targetReady.load();
+    return getSnapshot().targetReady;
+}
+
+bool AudioPluginAudioProcessor::saveTargetToLibrary (const juce::String& name)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    const auto snapshot = getSnapshot();
+
+    if (! snapshot.targetReady)
+        return false;
+
+    ProfileLibrary::Entry entry;
+    entry.name = name;
+    entry.profile = snapshot.target;
+    entry.spectrumDb = snapshot.targetSpectrum;
+    return profileLibrary.add (entry);
+}
+
+int AudioPluginAudioProcessor::findLibraryMatches (const TimbreProfile& query, ProfileLibrary::MatchArray& matches, int k)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    // 别的实例存过之后重新 map (只比修改时间和大小，每次刷新一次 stat)
+    profileLibrary.refresh();
+    return profileLibrary.findNearest (query, matches, k);
+}
+
+juce::String AudioPluginAudioProcessor::getLibraryEntryName (int index) const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    return profileLibrary.getName (index);
+}
+
+int AudioPluginAudioProcessor::getLibrarySize() const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    return profileLibrary.getNumEntries();
+}
+
+bool AudioPluginAudioProcessor::isLibraryUnreadable() const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    return profileLibrary.isUnreadable();
 }
 
 
     juce::String AudioPluginAudioProcessor::getStatusText() const
     {
-        return statusText;
-   
-
+        // 文字只在消息线程里拼，音频线程只发布状态码、进度和错误码
+        
+        // 已请求但音频线程还没接手 (这个状态不会出现在 snapshot 里)
+        if (analysisWorker.getCaptureState() == AnalysisWorker::CaptureState::StartRequested)
+        {
+            const double seconds = analysisWorker.getRequestedCaptureSamples() / lastSampleRate;
+            return "Capturing target... " + juce::String (seconds, 1) + "s";
+        }
+        
+        const auto snapshot = getSnapshot();
+        
+        switch (snapshot.error)
+        {
+            case AnalysisSnapshot::Error::NoInput:          return "Capture failed: no input channels";
+            case AnalysisSnapshot::Error::CaptureTooShort:  return "Capture failed: too short to analyse";
+            case AnalysisSnapshot::Error::ImportFailed:     return "Import failed: unsupported or unreadable file";
+            case AnalysisSnapshot::Error::AlignmentFailed:  return "Alignment failed: capture not found in reference";
+            case AnalysisSnapshot::Error::NoTransport:      return "Alignment needs the host transport playing";
+            case AnalysisSnapshot::Error::RingOverflow:
+                if (snapshot.status == AnalysisSnapshot::Status::TargetReady)
+                    return "Target Captured (some audio was dropped)";
+                break;
+            case AnalysisSnapshot::Error::None:
+            default:
+                break;
+        }
+        
+        switch (snapshot.status)
+        {
+            case AnalysisSnapshot::Status::WaitingForCapture:
+                return "Capturing target...";
+            case AnalysisSnapshot::Status::Capturing:
+                return "Capturing: " + juce::String ((int) (snapshot.captureProgress * 100.0f)) + "%";
+            case AnalysisSnapshot::Status::Analysing:
+                return "Analysing target...";
+            case AnalysisSnapshot::Status::TargetReady:
+                if (snapshot.referenceAligned)
+                {
+                    const juce::String offset = juce::String (snapshot.referenceOffsetSeconds >= 0.0f ? "+" : "")
+                                              + juce::String (snapshot.referenceOffsetSeconds, 3) + " s";
+                    const juce::String drift = juce::String (snapshot.referenceDrift * 100.0f, 3) + "%";
+
+                    return (snapshot.followingReference ? "Following reference (aligned " : "Reference aligned (")
+                           + offset + ", drift " + drift + ")";
+                }
+                if (snapshot.followingReference)
+                    return "Following reference";
+                return "Target Captured";
+            case AnalysisSnapshot::Status::Stopped:
+                return "Capture stopped";
+            case AnalysisSnapshot::Status::Importing:
+                return "Importing reference: " + juce::String ((int) (snapshot.captureProgress * 100.0f)) + "%";
+            case AnalysisSnapshot::Status::Aligning:
+                return "Aligning to reference: " + juce::String ((int) (snapshot.captureProgress * 100.0f)) + "%";
+            case AnalysisSnapshot::Status::Idle:
+            default:
+                return "Ready";
+        }
     }
 
 std::array<float, 8> AudioPluginAudioProcessor::getCurrentProfileArray() const
 {
-    std::array<float, 8> out{};
-    for (int i = 0; i < 8; ++i)
-        out[i] = current01[i].load(std::memory_order_relaxed);   // 关键：load atomic
-    return out;
+    return getSnapshot().current.toArray();
 }
 
 // 1. isTargetReady() - 检查是否已捕获目标音色
 bool AudioPluginAudioProcessor::isTargetReady() const
 {
-    return targetReady.load();
+    return hasTarget();
+}
+
+bool AudioPluginAudioProcessor::isAnalysingTarget() const
+{
+    return analysisWorker.isBusy();
 }
 
 // 2. getDiff() - 获取第 index 个维度的差值 (target - current)
@@ -351,30 +335,20 @@ float AudioPluginAudioProcessor::getDiff(int index) const
     if (index < 0 || index >= 8)
         return 0.0f;
     
-    auto targetArr = targetProfile.toArray();
-    float currentVal = current01[index].load(std::memory_order_relaxed);
-    
-    return targetArr[index] - currentVal;
-    
+    return getSnapshot().diff[(size_t) index];
 }
 
-// 3. getSuggestionA() - 获取差异最大的维度索引（最需要调整的）
-int AudioPluginAudioProcessor::getSuggestionA() const
+// 差异绝对值最大的维度 (跳过 excludeIndex)；全部为 0 时返回 -1
+int AudioPluginAudioProcessor::findLargestDiffIndex (const std::array<float, 8>& diff, int excludeIndex)
 {
-    if (!targetReady.load())
-        return -1;
-    
-    auto targetArr = targetProfile.toArray();
-    
-    int maxIndex = 0;
+    int maxIndex = -1;
     float maxDiff = 0.0f;
     
     for (int i = 0; i < 8; ++i)
     {
-        float currentVal = current01[i].load(std::memory_order_relaxed);
-        float absDiff = std::abs(targetArr[i] - currentVal);
+        float absDiff = std::abs (diff[(size_t) i]);
         
-        if (absDiff > maxDiff)
+        if (i != excludeIndex && absDiff > maxDiff)
         {
             maxDiff = absDiff;
             maxIndex = i;
@@ -384,70 +358,39 @@ int AudioPluginAudioProcessor::getSuggestionA() const
     return maxIndex;
 }
 
+// 3. getSuggestionA() - 获取差异最大的维度索引（最需要调整的）
+int AudioPluginAudioProcessor::getSuggestionA() const
+{
+    const auto snapshot = getSnapshot();
+    if (! snapshot.targetReady)
+        return -1;
+    
+    return juce::jmax (0, findLargestDiffIndex (snapshot.diff, -1));
+}
+
 // 4. getSuggestionB() - 获取差异第二大的维度索引
 int AudioPluginAudioProcessor::getSuggestionB() const
 {
-    if (!targetReady.load())
+    const auto snapshot = getSnapshot();
+    if (! snapshot.targetReady)
         return -1;
     
-    auto targetArr = targetProfile.toArray();
-    
-    int firstIndex = -1;
-    int secondIndex = -1;
-    float firstDiff = 0.0f;
-    float secondDiff = 0.0f;
-    
-    for (int i = 0; i < 8; ++i)
-    {
-        float currentVal = current01[i].load(std::memory_order_relaxed);
-        float absDiff = std::abs(targetArr[i] - currentVal);
-        
-        if (absDiff > firstDiff)
-        {
-            // 原来的第一名变成第二名
-            secondDiff = firstDiff;
-            secondIndex = firstIndex;
-            // 更新第一名
-            firstDiff = absDiff;
-            firstIndex = i;
-        }
-        else if (absDiff > secondDiff)
-        {
-            // 更新第二名
-            secondDiff = absDiff;
-            secondIndex = i;
-        }
-    }
-    
-    return secondIndex;
+    return findLargestDiffIndex (snapshot.diff, findLargestDiffIndex (snapshot.diff, -1));
 }
 
 std::array<float, 8> AudioPluginAudioProcessor::getTargetProfileArray() const
 {
-    // 你 targetProfile 是普通 struct，但它只在 capture 完成时改一次，
-    // UI 读它风险不大；更严谨也可以像 current 一样搞个 target01 atomic。
-    return targetProfile.toArray();
+    return getSnapshot().target.toArray();
 }
 
-std::array<float, 512> AudioPluginAudioProcessor::getSpectrumData() const
+AnalysisSnapshot::SpectrumArray AudioPluginAudioProcessor::getSpectrumData() const
 {
-    std::array<float, 512> out {};
-    for (size_t i = 0; i < 512; ++i)
-    {
-        // 从 FFT buffer 获取数据
-        if (i < kFFTSize / 2)
-        {
-            float re = fftBuffer[i * 2];
-            float im = fftBuffer[i * 2 + 1];
-            out[i] = std::sqrt (re * re + im * im);
-        }
-    }
-    return out;
+    return getSnapshot().spectrum;
 }
 
-std::array<float, 512> AudioPluginAudioProcessor::getTargetSpectrumData() const
+AnalysisSnapshot::SpectrumArray AudioPluginAudioProcessor::getTargetSpectrumData() const
 {
-    return targetSpectrumData;
+    return getSnapshot().targetSpectrum;
 }
 
 
@@ -522,65 +465,183 @@ void AudioPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
 {
     juce::ignoreUnused (samplesPerBlock);
 
-    lastSampleRate = sampleRate;
+    // 多声道输入先下混成 L/R (增益表按当前 bus 布局算)
+    channelFold.prepare (getChannelLayoutOfBus (true, 0));
+    loudnessMeter.prepare (sampleRate, getChannelLayoutOfBus (true, 0));
+
+    {
+        // 音频线程这时不在跑：直接在这里选好 plan，采样率变了的 plan 全部作废
+        const juce::ScopedLock sl (planLock);
+
+        lastSampleRate = sampleRate;
 
-    buildBandBinMapping();
+        planCache.erase (std::remove_if (planCache.begin(), planCache.end(),
+                                         [sampleRate] (const auto& plan) { return plan->getSampleRate() != sampleRate; }),
+                         planCache.end());
 
-    // FFT buffers init
-    fifoIndex = 0;
-    fifo.fill (0.0f);
-    fftBuffer.fill (0.0f);
+        AnalysisPlan* plan = nullptr;
 
-    // Capture buffer init (2 seconds default)
-    captureLengthSamples = (int) (2.0 * sampleRate);
-    captureWritePos = 0;
-    isCapturing = false;
+        for (auto& cached : planCache)
+            if (cached->matches (analysisConfig, sampleRate))
+                plan = cached.get();
 
-    captureBuffer.setSize (1, captureLengthSamples);
-    captureBuffer.clear();
+        if (plan == nullptr)
+        {
+            planCache.push_back (std::make_unique<AnalysisPlan> (analysisConfig, sampleRate));
+            plan = planCache.back().get();
+        }
+
+        plan->reset();
+        activePlan = plan;
+        requestedPlan.store (plan, std::memory_order_release);
+        acknowledgedPlan.store (plan, std::memory_order_release);
+        trimPlanCache();
+    }
+
+    // Capture ring 和流式分析的资源只在这里分配 (和 capture 长度无关)
+    analysisWorker.prepare (sampleRate);
+    lastCaptureState = AnalysisWorker::CaptureState::Idle;
 }
 
-void AudioPluginAudioProcessor::buildBandBinMapping()
+void AudioPluginAudioProcessor::setAnalysisConfig (const AnalysisConfig& newConfig)
 {
-    const float fMin = 20.0f;
-    const float fMax = (float) juce::jmin (20000.0, lastSampleRate * 0.5);
+    const auto config = newConfig.withValidatedRanges();
+
+    // capture 后的整段分析也用同一份配置
+    analysisWorker.setAnalysisConfig (config);
+
+    const juce::ScopedLock sl (planLock);
+
+    analysisConfig = config;
+
+    // 还没 prepareToPlay：等拿到采样率再建
+    if (planCache.empty())
+        return;
+
+    auto* requested = requestedPlan.load (std::memory_order_acquire);
+
+    if (requested != nullptr && requested->matches (config, lastSampleRate))
+        return;
+
+    trimPlanCache();
 
-    const int nyquistBin = kFFTSize / 2;
-    auto hzToBin = [this](float hz)
+    // 音频线程已经切到 requested：cache 里其它 plan 都没人用，可以 reset 后复用
+    AnalysisPlan* next = nullptr;
+
+    if (acknowledgedPlan.load (std::memory_order_acquire) == requested)
     {
-        const float clamped = juce::jlimit(0.0f, (float)(lastSampleRate * 0.5), hz);
-        return (int) std::floor(clamped * (float)kFFTSize / (float)lastSampleRate);
-    };
+        for (auto& cached : planCache)
+        {
+            if (cached.get() != requested && cached->matches (config, lastSampleRate))
+            {
+                cached->reset();
+                next = cached.get();
+                break;
+            }
+        }
+    }
 
-    for (int b = 0; b < kBands; ++b)
+    if (next == nullptr)
     {
-        const float t0 = (float)b / (float)kBands;
-        const float t1 = (float)(b + 1) / (float)kBands;
+        planCache.push_back (std::make_unique<AnalysisPlan> (config, lastSampleRate));
+        next = planCache.back().get();
+    }
+
+    requestedPlan.store (next, std::memory_order_release);
+}
 
-        // log spacing
-        const float f0 = fMin * std::pow(fMax / fMin, t0);
-        const float f1 = fMin * std::pow(fMax / fMin, t1);
+AnalysisConfig AudioPluginAudioProcessor::getAnalysisConfig() const
+{
+    const juce::ScopedLock sl (planLock);
+    return analysisConfig;
+}
 
-        int start = juce::jlimit(1, nyquistBin, hzToBin(f0));
-        int end   = juce::jlimit(1, nyquistBin, hzToBin(f1));
+// planLock 已持有：音频线程追上最新 request 之后，回收最早建的、没在用的 plan
+void AudioPluginAudioProcessor::trimPlanCache()
+{
+    auto* requested = requestedPlan.load (std::memory_order_acquire);
 
-        if (end <= start) end = juce::jmin(start + 1, nyquistBin);
+    // 还没追上时不知道音频线程手上是哪一个，下次再回收
+    if (acknowledgedPlan.load (std::memory_order_acquire) != requested)
+        return;
 
-        bandBins[(size_t)b] = { start, end };
+    for (auto it = planCache.begin(); it != planCache.end() && (int) planCache.size() > kMaxCachedPlans;)
+    {
+        if (it->get() != requested)
+            it = planCache.erase (it);
+        else
+            ++it;
+    }
+}
+
+// worker 线程：新的 target 带来的 track (capture 是 nullptr)，音频线程下一个 block 换过去
+void AudioPluginAudioProcessor::publishTrack (std::unique_ptr<ReferenceTrack> track)
+{
+    const juce::ScopedLock sl (trackLock);
+
+    // 和 trimPlanCache 一样：音频线程追上了上一次的 request，其它 track 都没人用了
+    auto* requested = requestedTrack.load (std::memory_order_acquire);
+
+    if (acknowledgedTrack.load (std::memory_order_acquire) == requested)
+    {
+        trackCache.erase (std::remove_if (trackCache.begin(), trackCache.end(),
+                                          [requested] (const auto& cached) { return cached.get() != requested; }),
+                          trackCache.end());
     }
 
-    bandBinsReady = true;
+    auto* next = track.get();
+
+    if (track != nullptr)
+        trackCache.push_back (std::move (track));
+
+    requestedTrack.store (next, std::memory_order_release);
 }
 
-//辅助函数
-int AudioPluginAudioProcessor::frequencyToBin (float freqHz) const
+// 音频线程：host 正在播放时这个 block 开头的时间 (秒)；停着或者没有 playhead 时返回 -1
+double AudioPluginAudioProcessor::getHostSeconds() const
 {
-    const float nyquist = (float) lastSampleRate * 0.5f;
-    const float clampedFreq = juce::jlimit (0.0f, nyquist, freqHz);
-    return (int) std::round (clampedFreq * (float) kFFTSize / (float) lastSampleRate);
+    if (auto* playHead = getPlayHead())
+    {
+        if (const auto position = playHead->getPosition(); position.hasValue() && position->getIsPlaying())
+        {
+            if (const auto time = position->getTimeInSeconds())
+                return *time;
+
+            if (const auto samples = position->getTimeInSamples())
+                return (double) *samples / lastSampleRate;
+        }
+    }
+
+    return -1.0;
 }
 
+// 音频线程：host 在播放时按 playhead 的时间直接算出 reference 的那一格 (O(1))；
+// 对齐过就先按对齐结果换到 reference 的时间轴。
+// 停着、没有 playhead、或者播到 reference 范围以外时不跟随，target 退回整段平均
+void AudioPluginAudioProcessor::followReference (double hostSeconds)
+{
+    int frame = -1;
+
+    if (activeTrack != nullptr && targetReady && hostSeconds >= 0.0)
+    {
+        const auto& alignment = referenceMapping.alignment;
+        const double seconds = referenceAligned
+            ? alignment.offsetSeconds + (hostSeconds - referenceMapping.hostStartSeconds) * (1.0 + alignment.drift)
+            : hostSeconds;
 
+        if (seconds >= 0.0 && seconds < activeTrack->getDurationSeconds())
+        {
+            frame = activeTrack->getFrameIndex (seconds);
+            referenceSeconds = seconds;
+        }
+    }
+
+    if (frame != referenceFrame)
+    {
+        referenceFrame = frame;
+        snapshotDirty = true;
+    }
+}
 
 void AudioPluginAudioProcessor::releaseResources()
 {
@@ -594,9 +655,13 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     juce::ignoreUnused (layouts);
     return true;
  #else
-    // 只允许 mono 或 stereo
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // mono / stereo，以及整轨送进来的 5.1 / 7.1 (分析时下混成 L/R)
+    const auto mainOut = layouts.getMainOutputChannelSet();
+    
+    if (mainOut != juce::AudioChannelSet::mono()
+     && mainOut != juce::AudioChannelSet::stereo()
+     && mainOut != juce::AudioChannelSet::create5point1()
+     && mainOut != juce::AudioChannelSet::create7point1())
         return false;
 
     // 如果不是 synth，输入输出要一致
@@ -617,6 +682,38 @@ void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     juce::ignoreUnused (midiMessages);
     juce::ScopedNoDenormals noDenormals;
     
+    // Debug 构建：capture 期间 processBlock 里一旦分配内存就断言
+    const RealtimeAllocationGuard::ScopedDisallow noAllocations (isCaptureActive());
+    
+    // 消息线程换了分析配置：在 block 边界切到新的 plan (只换指针，不分配)
+    if (auto* plan = requestedPlan.load (std::memory_order_acquire); plan != activePlan)
+    {
+        activePlan = plan;
+        acknowledgedPlan.store (plan, std::memory_order_release);
+    }
+    
+    // 对齐结果：之后的 block 按它把 host 时间换到 reference 时间。
+    // 先取对齐再换 track：worker 上对齐总是在下一次导入 / capture 发布新 track 之前发布，
+    // 同一个 block 里两样都到了时，换 track 把旧 reference 的对齐作废，不会反过来把它套到新 track 上
+    if (alignmentHandoff.fetch())
+    {
+        referenceMapping = alignmentHandoff.getReadBuffer();
+        referenceAligned = true;
+        snapshotDirty = true;
+    }
+    
+    // 新导入的 reference track 同样只换指针
+    if (auto* track = requestedTrack.load (std::memory_order_acquire); track != activeTrack)
+    {
+        activeTrack = track;
+        acknowledgedTrack.store (track, std::memory_order_release);
+        referenceFrame = -1;
+        referenceAligned = false;   // 换了 reference，之前的对齐不算数
+        snapshotDirty = true;
+    }
+    
+    const double hostSeconds = getHostSeconds();
+    
     // 1. 获取输入输出信息
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -626,129 +723,90 @@ void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         buffer.clear (i, 0, buffer.getNumSamples());
     
     // 2. --- 关键：捕获逻辑 ---
-    // 这里使用 atomic 的 load 确保线程安全
-    if (isCapturing)
+    // start/stop 命令在 block 边界生效，数据写进 worker 的 SPSC ring (不分配、不加锁)
+    // 录的是所有输入声道下混后的 Mid
+    const int numAnalysisChannels = juce::jmin (totalNumInputChannels, buffer.getNumChannels());
+    const auto captureState = analysisWorker.processCaptureBlock (buffer.getArrayOfReadPointers(), numAnalysisChannels,
+                                                                  buffer.getNumSamples(), channelFold, hostSeconds);
+    
+    using CS = AnalysisWorker::CaptureState;
+    
+    // 新的 capture 开始：旧 target 作废 (对齐用的 capture 不动 target)
+    if (captureState == CS::Capturing && lastCaptureState != CS::Capturing && ! analysisWorker.isAligning())
     {
-        int numSamples = buffer.getNumSamples();
-        int remaining = captureLengthSamples - captureWritePos;
-        int toCopy = std::min(numSamples, remaining);
-        
-        if (toCopy > 0)
-        {
-            // 写入 captureBuffer (单声道)
-            captureBuffer.copyFrom(0, captureWritePos, buffer, 0, 0, toCopy);
-            captureWritePos += toCopy;
-        }
-        
-        // 检查是否录制结束
-        if (captureWritePos >= captureLengthSamples)
-        {
-            isCapturing = false; // 停止录制
-            
-            // 执行捕获后的分析
-            targetProfile = analyseBufferToProfile(captureBuffer, lastSampleRate);
-            targetReady.store(true);
-            statusText = "Target Captured";
-            
-            // 保存 target 频谱数据
-            for (size_t i = 0; i < 512 && i < kFFTSize / 2; ++i)
-            {
-                float re = fftBuffer[i * 2];
-                float im = fftBuffer[i * 2 + 1];
-                targetSpectrumData[i] = std::sqrt(re * re + im * im);
-            }
-        }
-        else
-        {
-            // 更新 UI 进度提示
-            statusText = "Capturing: " + juce::String((int)((float)captureWritePos / captureLengthSamples * 100)) + "%";
-        }
+        targetReady = false;
+        captureStopped = false;
+    }
+    
+    if (captureState == CS::Aborted)
+        captureStopped = true;
+    
+    if (captureState != lastCaptureState || captureState == CS::Capturing || captureState == CS::Importing)
+        snapshotDirty = true;
+    
+    lastCaptureState = captureState;
+    
+    // worker 分析完的 target (无锁交接)：频谱是整段 capture 的长时平均，不是录完那一刻的实时帧
+    if (targetHandoff.fetch())
+    {
+        const auto& result = targetHandoff.getReadBuffer();
+        targetProfile = result.profile;
+        targetLoudness = result.loudness;
+        targetOnsetDensity = result.onsetDensity;
+        targetSpectrumData = result.spectrum;
+        targetSpectrumLow = result.spectrumLow;
+        targetSpectrumMedian = result.spectrumMedian;
+        targetSpectrumHigh = result.spectrumHigh;
+        targetBands = result.bands;
+        targetReady = true;
+        snapshotDirty = true;
     }
     
+    followReference (hostSeconds);
+    
     
     // 3. --- 实时分析逻辑 (Current 列) ---
     // 即使不在录音，我们也需要实时更新 UI 的 Current 数值
-    if (totalNumInputChannels > 0)
+    if (numAnalysisChannels > 0 && activePlan != nullptr)
     {
-        auto* channelData = buffer.getReadPointer(0);
-        
-        // 推入 FFT 队列
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-            pushSampleForEnvelope(channelData[i]);
+        auto* const* channels = buffer.getArrayOfReadPointers();
         
-        // 更新实时 Profile
-        currentProfile = analyseCurrentBlockToProfile(buffer, lastSampleRate);
-        auto arr = currentProfile.toArray();
-        // 在 processBlock 里的最后一行循环改为：
-        for (int i = 0; i < kBands; ++i)
+        for (int offset = 0; offset < buffer.getNumSamples(); offset += ChannelFold::kBlockSize)
         {
-            // 直接读你在 computeCurrentEnvelopeFromFFT 里存进去的 FFT 能量
-            float val = currentEnvAtomic[i].load();
-            current01[i].store(juce::jlimit(0.0f, 1.0f, val * 10.0f), std::memory_order_relaxed);
+            const int numSamples = juce::jmin (ChannelFold::kBlockSize, buffer.getNumSamples() - offset);
+            
+            // 所有输入声道下混成一对 L/R
+            channelFold.process (channels, numAnalysisChannels, offset, numSamples, foldLeft.data(), foldRight.data());
+            
+            // 整段推入当前 plan 的分帧器，每个完整的 hop 都会出一帧 (L/R 打包成一次 FFT)；
+            // 音色特征只在新帧出来时算一次，没有新帧的 block 什么都不做
+            activePlan->process (foldLeft.data(), foldRight.data(), numSamples, [this] (TimbreProfile profile)
+            {
+                // 8 段包络用这一帧的累积数组 (每个 band O(1))，96 个 ERB band 走稀疏权重；
+                // 都随下一份 snapshot 发布给 UI
+                activePlan->getEnvelope (currentEnv);
+                activePlan->getStreamEnvelopes (streamEnvelopes);
+                activePlan->getFilterbankEnvelope (currentBands);
+                activePlan->getStereoCorrelations (bandCorrelation);
+                activePlan->getStereoCoherences (bandCoherence);
+                activePlan->getDecayTimes (bandDecaySeconds);
+                numOnsets = activePlan->getOnsetTimes (onsetTimes);
+                onsetDensity = activePlan->getOnsetDensity();
+                
+                // Width 来自平滑后的 L/R 互谱 (约 0.3 秒)，不再随 host block 大小跳动
+                profile.width = channelFold.hasStereoImage() ? activePlan->getStereoWidth() : 0.5f;
+                publishCurrentProfile (profile);
+            });
         }
-    }
-}
-
-//
-void AudioPluginAudioProcessor::pushSampleForEnvelope(float s)
-{
-    fifo[(size_t)fifoIndex++] = s;
-
-    if (fifoIndex >= kFFTSize)
-    {
-        // 复制到 fftBuffer 并加窗
-        for (int i = 0; i < kFFTSize; ++i)
-            fftBuffer[(size_t)i] = fifo[(size_t)i];
-        
-        window.multiplyWithWindowingTable(fftBuffer.data(), kFFTSize);
-        
-        // JUCE: real-only forward
-        fft.performRealOnlyForwardTransform(fftBuffer.data());
         
-        // 计算 bands（power -> 0..1）
-        if (bandBinsReady)
-            computeCurrentEnvelopeFromFFT();
-        
-        // hop: 把 fifo 左移 kHop
-        const int remain = kFFTSize - kHop;
-        for (int i = 0; i < remain; ++i)
-            fifo[(size_t)i] = fifo[(size_t)(i + kHop)];
-        
-        fifoIndex = remain;
+        // BS.1770 响度 / true-peak / crest factor (每 100 ms 更新一次读数)
+        loudnessMeter.process (channels, numAnalysisChannels, buffer.getNumSamples());
     }
-}
-//
-void AudioPluginAudioProcessor::computeCurrentEnvelopeFromFFT()
-{
-    if (! bandBinsReady)
-        buildBandBinMapping();
-
-    std::array<float, kBands> env {};
-    env.fill (0.0f);
-
-    for (int b = 0; b < kBands; ++b)
-    {
-        float sum = 0.0f;
-        int count = 0;
-
-        for (int bin = bandBins[b].startBin;
-             bin <= bandBins[b].endBin;
-             ++bin)
-        {
-            float mag = std::abs (fftBuffer[(size_t) bin]);
-            sum += mag;
-            ++count;
-        }
-
-        env[b] = (count > 0 ? sum / (float) count : 0.0f);
-    }
-
-    // 写入 atomic（给 UI 用）
-    for (int i = 0; i < kBands; ++i)
-        currentEnvAtomic[i].store (env[i], std::memory_order_relaxed);
-}
     
-
+    // 4. --- 有变化才发布一份新的 snapshot 给 UI ---
+    if (snapshotDirty)
+        publishSnapshot (captureState);
+}
 
 //==============================================================================
 bool AudioPluginAudioProcessor::hasEditor() const
@@ -764,17 +822,32 @@ juce::AudioProcessorEditor* AudioPluginAudioProcessor::createEditor()
 //==============================================================================
 void AudioPluginAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    juce::ignoreUnused (destData);
+    // 每个实例保存自己的分析设置
+    const auto config = getAnalysisConfig();
+
+    juce::XmlElement xml ("TimbreLabState");
+    xml.setAttribute ("fftOrder", config.fftOrder);
+    xml.setAttribute ("overlap", (double) config.overlap);
+    xml.setAttribute ("window", (int) config.window);
+    xml.setAttribute ("resampleToCanonicalRate", config.resampleToCanonicalRate);
+
+    copyXmlToBinary (xml, destData);
 }
 
 void AudioPluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    juce::ignoreUnused (data, sizeInBytes);
+    const auto xml = getXmlFromBinary (data, sizeInBytes);
+
+    if (xml == nullptr || ! xml->hasTagName ("TimbreLabState"))
+        return;
+
+    AnalysisConfig config;
+    config.fftOrder = xml->getIntAttribute ("fftOrder", config.fftOrder);
+    config.overlap = (float) xml->getDoubleAttribute ("overlap", (double) config.overlap);
+    config.window = (AnalysisConfig::Window) xml->getIntAttribute ("window", (int) config.window);
+    config.resampleToCanonicalRate = xml->getBoolAttribute ("resampleToCanonicalRate", config.resampleToCanonicalRate);
+
+    setAnalysisConfig (config);
 }
 
 //==============================================================================
@@ -804,25 +877,22 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 // 执行比较分析
 void AudioPluginAudioProcessor::performCompare()
 {
-    if (!targetReady.load())
+    // 同一份 snapshot 里的 target / current / diff，保证一致
+    const auto snapshot = getSnapshot();
+    
+    if (!snapshot.targetReady)
     {
         compareResultText = "No target captured yet!";
         return;
     }
     
-    auto targetArr = targetProfile.toArray();
-    
-    // 计算每个维度的差值
+    // 每个维度的差值
     for (int i = 0; i < 8; ++i)
-    {
-        float currentVal = current01[i].load(std::memory_order_relaxed);
-        float diff = targetArr[i] - currentVal;
-        diffValues[i].store(diff, std::memory_order_relaxed);
-    }
+        diffValues[i].store(snapshot.diff[(size_t) i], std::memory_order_relaxed);
     
     // 获取建议
-    int suggA = getSuggestionA();
-    int suggB = getSuggestionB();
+    int suggA = juce::jmax (0, findLargestDiffIndex (snapshot.diff, -1));
+    int suggB = findLargestDiffIndex (snapshot.diff, suggA);
     
     static const char* dimNames[8] = {
         "Bright", "Body", "Bite", "Air", "Noise", "Width", "Motion", "Space"
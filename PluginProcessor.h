@@ -8,6 +8,20 @@
 #include <atomic>
 #include <array>
 #include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "TimbreProfile.h"
+#include "AnalysisWorker.h"
+#include "AnalysisConfig.h"
+#include "AnalysisPlan.h"
+#include "AnalysisSnapshot.h"
+#include "ChannelFold.h"
+#include "LoudnessMeter.h"
+#include "ProfileLibrary.h"
+#include "ReferenceTrack.h"
+#include "TripleBuffer.h"
+#include "RealtimeAllocationGuard.h"
 
 //==============================================================================
 class AudioPluginAudioProcessor final : public juce::AudioProcessor
@@ -22,14 +36,43 @@ public:
     //==============================================================================
     
         bool isTargetReady() const;
+        bool isAnalysingTarget() const;
 
         void beginCaptureSeconds (double seconds);
+        void stopCapture();
+        bool isCaptureActive() const;
+
+        // 拖进来的 reference 文件当 target：消息线程调用，读文件和分析都在 worker 上
+        bool importTargetFile (const juce::File& file);
+        bool canImportTargetFile (const juce::File& file) const;
+        bool isImportingTarget() const;
+        float getImportProgress() const;   // 0..1
+
+        // 导入 reference 之后：host 播放时录一段，和 reference 对齐 (target 不变)
+        bool beginAlignmentSeconds (double seconds);
+        bool canAlignReference() const;
         bool hasTarget() const;
         juce::String getStatusText() const;
 
+        // target 库 (磁盘上，所有实例共用一个文件)：消息线程调用
+        bool saveTargetToLibrary (const juce::String& name);   // 当前显示的 target (profile + 谱)
+        int findLibraryMatches (const TimbreProfile& query, ProfileLibrary::MatchArray& matches, int k);   // 先跟上别的实例存的
+        juce::String getLibraryEntryName (int index) const;
+        int getLibrarySize() const;
+        bool isLibraryUnreadable() const;   // 库文件在但读不了：不会被覆盖，也存不进去
+
         std::array<float, 8> getTargetProfileArray() const;
         std::array<float, 8> getCurrentProfileArray() const;
 
+        // UI 读 processor 状态的唯一入口：一次拿到同一时刻的完整拷贝
+        // 只能在消息线程调用 (triple buffer 只有一个读端)
+        AnalysisSnapshot getSnapshot() const;
+
+        // 分析分辨率 (FFT 点数 / overlap / 窗)：消息线程调用，plan 在这里建好后
+        // 音频线程在下一个 block 边界切过去
+        void setAnalysisConfig (const AnalysisConfig& config);
+        AnalysisConfig getAnalysisConfig() const;
+
         float getDiff (int index) const;
         int getSuggestionA() const;
         int getSuggestionB() const;
@@ -68,9 +111,9 @@ public:
     ~AudioPluginAudioProcessor() override = default;
     
 
-    // 频谱数据获取函数
-    std::array<float, 512> getSpectrumData() const;
-    std::array<float, 512> getTargetSpectrumData() const;
+    // 频谱数据获取函数 (1/24 倍频程的 dB 显示谱)
+    AnalysisSnapshot::SpectrumArray getSpectrumData() const;
+    AnalysisSnapshot::SpectrumArray getTargetSpectrumData() const;
 
 
 
@@ -79,7 +122,6 @@ public:
 
 private:
 
-    juce::String statusText { "Ready" };
     
     // ====== UI: Two-column table ======
 
@@ -90,65 +132,47 @@ private:
 
 
 //
-    static constexpr int kBands = 8;
-    std::array<std::atomic<float>, kBands> currentEnvAtomic;
-    
-    //Timbre Compare MVP
-    //8个对新手友好的维度 (0..1)
-    struct TimbreProfile
-    {
-        float bright = 0.0f;  // 亮度
-        float body   = 0.0f;  // 厚度(低中频)
-        float bite   = 0.0f;  // 锐度(存在感)
-        float air    = 0.0f;  // 空气感
-        float noise  = 0.0f;  // 颗粒/噪声
-        float width  = 0.0f;  // 宽度(立体声)
-        float motion = 0.0f;  // 起伏/抖动
-        float space  = 0.0f;  // 空间感(尾巴)
-        
-        std::array<float, 8> toArray() const
-        {
-            return { bright, body, bite, air, noise, width, motion, space};
-        }
-    };
-    
-    enum class TimbreDim : int
-    {
-        Bright = 0, Body, Bite, Air, Noise, Width, Motion, Space
-    };
-    
-    // 给UI读的共享状态 (原子变量: 线程安全)
-    std::atomic<bool> targetReady { false };
-    std::array<std::atomic<float>, 8> diff01;  //target - current 范围大约 -1..+1)
-    std::atomic<int> topSuggestionA { -1 };
-    std::atomic<int> topSuggestionB { -1 };
+    static constexpr int kBands = AnalysisSnapshot::kEnvelopeBands;
     
+    // ====== 音频线程私有状态 (UI 只通过 snapshot 读) ======
     TimbreProfile currentProfile;
-    std::array<std::atomic<float>, 8> current01; // 0..1
-    
-    // 频谱数据获取函数
-    std::array<std::atomic<float>, 512> spectrumDataAtomic {};
-    std::array<float, 512> targetSpectrumData {};
-
-    
-    //Capture相关: 抓2秒音频（先只声明，后面实现)
-    std::atomic<bool> isCapturing {false};
-    int captureWritePos = 0;
-    double lastSampleRate = 44100.0;
-    int captureLengthSamples = 0;
-    juce::AudioBuffer<float> captureBuffer; //单声道抓取
-    
     TimbreProfile targetProfile;
+    bool targetReady = false;
+    bool captureStopped = false;   // 上一次 capture 被中途停止 (状态码用)
+    std::array<float, kBands> currentEnv {};
+    AnalysisSnapshot::StreamEnvelopes streamEnvelopes {};   // L / R / Mid / Side
+    AnalysisSnapshot::EnvelopeArray bandCorrelation {};
+    AnalysisSnapshot::EnvelopeArray bandCoherence {};
+    AnalysisSnapshot::EnvelopeArray bandDecaySeconds {};
+    AnalysisSnapshot::OnsetArray onsetTimes {};
+    int numOnsets = 0;
+    float onsetDensity = 0.0f;
+    float targetOnsetDensity = 0.0f;
+    AnalysisSnapshot::BandArray currentBands {};   // kFtBands 个 ERB band
+    AnalysisSnapshot::BandArray targetBands {};
+    AnalysisSnapshot::SpectrumArray targetSpectrumData {};   // capture 整段的 Welch 平均
+    AnalysisSnapshot::SpectrumArray targetSpectrumLow {}, targetSpectrumMedian {}, targetSpectrumHigh {};
+    
+    LoudnessMeter::Reading targetLoudness;
+    
+    // worker -> 音频线程：分析好的 target profile + 响度 + 长时平均谱
+    TripleBuffer<AnalysisWorker::CaptureResult> targetHandoff;
+    
+    // 音频线程 -> UI：版本化的完整 snapshot
+    mutable TripleBuffer<AnalysisSnapshot> snapshotBuffer;
+    uint32_t snapshotVersion = 0;
+    bool snapshotDirty = false;
+    
+    void publishSnapshot (AnalysisWorker::CaptureState captureState);
+    static int findLargestDiffIndex (const std::array<float, 8>& diff, int excludeIndex);
+
+    
+    //Capture相关: 数据经 AnalysisWorker 的 SPSC ring 流出，音频线程不碰会被 resize 的内存
+    double lastSampleRate = 44100.0;
+    AnalysisWorker::CaptureState lastCaptureState = AnalysisWorker::CaptureState::Idle; // 音频线程私有
     
-    //下面这些函数在PluginProcessor.cpp 里实现
-    TimbreProfile analyseBufferToProfile (const juce::AudioBuffer<float>& monoBuffer, double sampleRate);
-    TimbreProfile analyseCurrentBlockToProfile (const juce::AudioBuffer<float>& buffer, double sampleRate);
     //
-    static constexpr int kFtBands = 96;
-
-    static constexpr int kFFTOrder = 11;
-    static constexpr int kFFTSize  = 1 << kFFTOrder;
-    static constexpr int kHop      = 512;
+    static constexpr int kFtBands = AnalysisSnapshot::kFilterbankBands;
     
     //
 
@@ -156,36 +180,59 @@ private:
     juce::SpinLock targetEnvLock;
     
     // ====== 音色分析相关 ======
-    // 用于 Motion 计算（帧间变化）
-    std::array<float, kBands> previousFrameEnergy {};
-    bool hasPreviousFrame = false;
-    
-    // 辅助函数
-    int frequencyToBin (float freqHz) const;
-
-
-    //
-
-    juce::dsp::FFT fft { kFFTOrder };
-    juce::dsp::WindowingFunction<float> window { (size_t)kFFTSize,
-        juce::dsp::WindowingFunction<float>::hann };
-
-    std::array<float, kFFTSize> fifo {};
-    int fifoIndex = 0;
-    std::array<float, kFFTSize * 2> fftBuffer {};
-
-    struct BandBinRange { int startBin=0, endBin=0; };
-    std::array<BandBinRange, kBands> bandBins;
-    bool bandBinsReady = false;
-
-
-
-    void buildBandBinMapping();
-    void pushSampleForEnvelope(float s);
-    void computeCurrentEnvelopeFromFFT();
+    // 输入声道 (mono / stereo / 5.1 / 7.1) 下混成一对 L/R 分析流，按 ChannelFold::kBlockSize 分段处理
+    ChannelFold channelFold;
+    std::array<float, ChannelFold::kBlockSize> foldLeft {}, foldRight {};   // 音频线程私有
+
+    // 响度表直接吃原始输入声道 (按布局加权)，不走下混
+    LoudnessMeter loudnessMeter;
+
+    void publishCurrentProfile (const TimbreProfile& profile);
+
+
+    // ====== STFT 分析 plan (FFT / 分帧 / 窗 / 特征提取整套) ======
+    // plan 只在消息线程上创建和释放。音频线程每个 block 读一次 requestedPlan，
+    // 切过去之后写 acknowledgedPlan；消息线程看到 ack 追上 request 之后才回收其它 plan，
+    // 切回用过的配置时直接复用 cache 里的 plan
+    static constexpr int kMaxCachedPlans = 4;
+
+    mutable juce::CriticalSection planLock;                  // 消息线程侧互斥，音频线程不碰
+    AnalysisConfig analysisConfig;                           // planLock
+    std::vector<std::unique_ptr<AnalysisPlan>> planCache;    // planLock
+    std::atomic<AnalysisPlan*> requestedPlan { nullptr };
+    std::atomic<AnalysisPlan*> acknowledgedPlan { nullptr };
+    AnalysisPlan* activePlan = nullptr;                      // 音频线程私有
+
+    void trimPlanCache();
+
+    // ====== 导入 reference 的特征轨 ======
+    // track 在 worker 上建好交过来 (trackLock 下进 trackCache)。音频线程每个 block 读一次 requestedTrack，
+    // 切过去之后写 acknowledgedTrack；下一条 track 交过来时，ack 追上了才释放旧的，音频线程从不释放
+    mutable juce::CriticalSection trackLock;                   // worker 侧互斥，音频线程不碰
+    std::vector<std::unique_ptr<ReferenceTrack>> trackCache;   // trackLock
+    std::atomic<ReferenceTrack*> requestedTrack { nullptr };
+    std::atomic<ReferenceTrack*> acknowledgedTrack { nullptr };
+    ReferenceTrack* activeTrack = nullptr;                     // 音频线程私有
+    int referenceFrame = -1;                                   // 音频线程私有：播放位置那一格，-1 = 不跟随
+    double referenceSeconds = 0.0;
+
+    // worker -> 音频线程：对齐结果 (host 时间 -> reference 时间)；没对齐过时 reference 时间就是 host 时间
+    TripleBuffer<AnalysisWorker::ReferenceMapping> alignmentHandoff;
+    AnalysisWorker::ReferenceMapping referenceMapping;         // 音频线程私有
+    bool referenceAligned = false;
+
+    void publishTrack (std::unique_ptr<ReferenceTrack> track);
+    double getHostSeconds() const;
+    void followReference (double hostSeconds);
+
+    // 只在消息线程上用
+    ProfileLibrary profileLibrary;
 
     std::array<float, kBands> analyseBufferToTargetEnvelope (const juce::AudioBuffer<float>& mono,
                                                              double sampleRate);
+
+    // capture 完成后的整段分析 (最后声明：析构时最先停线程)
+    AnalysisWorker analysisWorker;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessor)
 };
@@ -0,0 +1,254 @@
+#include "PolyphaseResampler.h"
+#include "SpectralKernels.h"
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <cstring>
+#include <numeric>
+
+void PolyphaseResampler::prepare (double inputRate, double newOutputRate, int baseTapsPerPhase)
+{
+    const int inRate = juce::roundToInt (inputRate);
+    const int outRate = juce::roundToInt (newOutputRate);
+    const int divisor = std::gcd (inRate, outRate);
+
+    upFactor = outRate / divisor;
+    downFactor = inRate / divisor;
+    outputRate = newOutputRate;
+
+    // 常见的采样率组合 L 都在几百以内
+    jassert (upFactor <= 4096);
+
+    buildFilter (baseTapsPerPhase);
+}
+
+void PolyphaseResampler::prepareDecimator (double inputRate, int factor, int baseTapsPerPhase)
+{
+    jassert (factor >= 1);
+
+    upFactor = 1;
+    downFactor = factor;
+    outputRate = inputRate / (double) factor;
+
+    buildFilter (baseTapsPerPhase);
+}
+
+bool PolyphaseResampler::buildHalfBandStages()
+{
+    halfBandStages.clear();
+
+    if (upFactor != 1 || downFactor < 2 || downFactor > 8 || ! juce::isPowerOfTwo (downFactor))
+        return false;
+
+    // 每一级都保护同一个通带 (最终输出采样率的 kHalfBandPassband)
+    const double passbandHz = kHalfBandPassband * outputRate;
+    double stageRate = outputRate * (double) downFactor;
+    int span = 1;
+    maxPhaseGain = 1.0f;
+
+    for (int factor = downFactor; factor > 1; factor /= 2)
+    {
+        halfBandStages.emplace_back();
+        auto& stage = halfBandStages.back();
+        stage.prepare (stageRate, passbandHz);
+
+        // 这一级的 2 numEven - 1 个系数在原始输入上跨 (downFactor / factor) 倍
+        span += (2 * stage.getNumEvenTaps() - 2) * (downFactor / factor);
+        maxPhaseGain *= stage.getAbsoluteGain();
+        stageRate *= 0.5;
+    }
+
+    tapsPerPhase = span;
+
+    for (auto& b : stageBuffers)
+        b.assign ((size_t) (kChunkSize / 2 + 1), 0.0f);
+
+    coefficients.clear();
+    interleavedCoefficients.clear();
+    history.clear();
+    return true;
+}
+
+void PolyphaseResampler::buildFilter (int baseTapsPerPhase)
+{
+    if (buildHalfBandStages())
+        return;
+
+    tapsPerPhase = baseTapsPerPhase * juce::jmax (1, (downFactor + upFactor - 1) / upFactor);
+
+    // 原型低通在 L 倍上采样后的采样率上设计：截止 = 较低 nyquist 的 90%，增益 L
+    // (只和 L / M 有关：输入率 = M 份，输出率 = L 份，上采样后 = M * L 份)
+    const int length = upFactor * tapsPerPhase;
+    const double cutoff = 0.45 * (double) juce::jmin (upFactor, downFactor) / ((double) downFactor * upFactor);   // cycles / sample
+    const double centre = 0.5 * (double) (length - 1);
+
+    std::vector<float> window ((size_t) length);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables (window.data(), (size_t) length,
+                                                              juce::dsp::WindowingFunction<float>::kaiser,
+                                                              false, 8.0f);
+
+    coefficients.assign ((size_t) length, 0.0f);
+
+    for (int j = 0; j < length; ++j)
+    {
+        const double x = 2.0 * cutoff * ((double) j - centre);
+        const double sinc = std::abs (x) < 1e-12 ? 1.0 : std::sin (juce::MathConstants<double>::pi * x)
+                                                         / (juce::MathConstants<double>::pi * x);
+        const double h = (double) upFactor * 2.0 * cutoff * sinc * (double) window[(size_t) j];
+
+        // 原型第 j = k * L + p 个系数 -> 相位 p 的第 (T - 1 - k) 个 (反序，和 history 顺序点积)
+        const int p = j % upFactor;
+        const int k = j / upFactor;
+        coefficients[(size_t) (p * tapsPerPhase + tapsPerPhase - 1 - k)] = (float) h;
+    }
+
+    maxPhaseGain = 0.0f;
+
+    for (int p = 0; p < upFactor; ++p)
+    {
+        float gain = 0.0f;
+        for (int k = 0; k < tapsPerPhase; ++k)
+            gain += std::abs (coefficients[(size_t) (p * tapsPerPhase + k)]);
+
+        maxPhaseGain = juce::jmax (maxPhaseGain, gain);
+    }
+
+    // 4x 上采样 (true-peak)：另存一份按 tap 排的系数，一次出一个输入对应的 4 个输出
+    interleavedCoefficients.clear();
+
+    if (isFourTimesUpsampler())
+    {
+        interleavedCoefficients.resize (coefficients.size());
+
+        for (int p = 0; p < upFactor; ++p)
+            for (int k = 0; k < tapsPerPhase; ++k)
+                interleavedCoefficients[(size_t) (k * upFactor + p)] = coefficients[(size_t) (p * tapsPerPhase + k)];
+    }
+
+    history.assign ((size_t) (tapsPerPhase - 1 + kChunkSize), 0.0f);
+    reset();
+}
+
+void PolyphaseResampler::reset()
+{
+    for (auto& stage : halfBandStages)
+        stage.reset();
+
+    std::fill (history.begin(), history.end(), 0.0f);
+    phase = 0;
+    inputIndex = 0;
+}
+
+int PolyphaseResampler::process (const float* input, int numInput, float* output) noexcept
+{
+    if (isPassThrough())
+    {
+        juce::FloatVectorOperations::copy (output, input, numInput);
+        return numInput;
+    }
+
+    if (! halfBandStages.empty())
+        return processHalfBand (input, numInput, output);
+
+    int numOutput = 0;
+
+    while (numInput > 0)
+    {
+        const int chunk = juce::jmin (numInput, kChunkSize);
+        numOutput += processChunk (input, chunk, output + numOutput);
+        input += chunk;
+        numInput -= chunk;
+    }
+
+    return numOutput;
+}
+
+int PolyphaseResampler::skip (const float* input, int numInput) noexcept
+{
+    if (isPassThrough())
+        return numInput;
+
+    if (! halfBandStages.empty())
+        return processHalfBand (input, numInput, nullptr);
+
+    int numOutput = 0;
+
+    while (numInput > 0)
+    {
+        const int chunk = juce::jmin (numInput, kChunkSize);
+        numOutput += processChunk (input, chunk, nullptr);
+        input += chunk;
+        numInput -= chunk;
+    }
+
+    return numOutput;
+}
+
+int PolyphaseResampler::processHalfBand (const float* input, int numInput, float* output) noexcept
+{
+    int numOutput = 0;
+
+    while (numInput > 0)
+    {
+        const int chunk = juce::jmin (numInput, kChunkSize);
+        const float* stageInput = input;
+        int n = chunk;
+
+        // 每一级的输出是下一级的输入；最后一级直接写进 output (skip 时写进中间 buffer 扔掉)
+        for (size_t s = 0; s < halfBandStages.size(); ++s)
+        {
+            const bool last = s + 1 == halfBandStages.size();
+            float* stageOutput = last && output != nullptr ? output + numOutput : stageBuffers[s % 2].data();
+            n = halfBandStages[s].process (stageInput, n, stageOutput);
+            stageInput = stageOutput;
+        }
+
+        numOutput += n;
+        input += chunk;
+        numInput -= chunk;
+    }
+
+    return numOutput;
+}
+
+int PolyphaseResampler::processChunk (const float* input, int numInput, float* output) noexcept
+{
+    // history[T - 1 + i] = 这一块的第 i 个输入，前面 T - 1 个是上一块的尾巴
+    const int tail = tapsPerPhase - 1;
+    juce::FloatVectorOperations::copy (history.data() + tail, input, numInput);
+
+    int numOutput = 0;
+
+    if (isFourTimesUpsampler())
+    {
+        // M = 1 时块边界上 phase 总是 0：剩下的每个输入正好出 4 个输出
+        numOutput = 4 * (numInput - inputIndex);
+
+        if (output != nullptr)
+            SpectralKernels::interpolate4 (interleavedCoefficients.data(), history.data() + inputIndex,
+                                           tapsPerPhase, numInput - inputIndex, output);
+
+        inputIndex = numInput;
+    }
+
+    while (inputIndex < numInput)
+    {
+        // 输出 n 在上采样时间轴上的位置是 n * M：inputIndex = 它 / L，phase = 它 % L
+        if (output != nullptr)
+            output[numOutput] = SpectralKernels::dot (coefficients.data() + phase * tapsPerPhase,
+                                                      history.data() + inputIndex, tapsPerPhase);
+
+        ++numOutput;
+
+        phase += downFactor;
+        inputIndex += phase / upFactor;
+        phase %= upFactor;
+    }
+
+    inputIndex -= numInput;
+
+    // 最后 T - 1 个输入留给下一块
+    std::memmove (history.data(), history.data() + numInput, (size_t) tail * sizeof (float));
+
+    return numOutput;
+}
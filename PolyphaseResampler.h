@@ -0,0 +1,83 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <vector>
+
+#include "HalfBandDecimator.h"
+
+// 有理数倍率 L/M 的多相 FIR 重采样器 (单声道)
+// 原型低通是 Kaiser 窗 sinc，截止在两边较低 nyquist 的 90%，按相位拆成 L 组系数，
+// 每个输出 sample 只做一次 tapsPerPhase 长的点积。
+// 44.1k -> 48k 是 160/147，96k -> 48k 是 1/2，192k -> 48k 是 1/4。
+// 2 / 4 / 8 倍的整数抽取 (L = 1) 不走多相表，改成 HalfBandDecimator 级联：
+// 只保留到输出采样率的 kHalfBandPassband (48k 下约 20 kHz，再往上分析也不用)，
+// 靠前的级过渡带很宽、阶数很短；96k -> 48k 每个输出 32 次乘加，192k -> 48k 约 56 次
+// (单级多相是 128 / 256 次)。
+class PolyphaseResampler
+{
+public:
+    // 每个相位的基础阶数；降采样时按 M/L 加长，保持过渡带宽度不变
+    static constexpr int kBaseTapsPerPhase = 64;
+
+    // 半带级联保留的通带 (相对输出采样率)
+    static constexpr double kHalfBandPassband = 0.42;
+
+    // 非音频线程：建滤波器表和 history buffer
+    // baseTapsPerPhase 可以调小换速度 (比如 true-peak 的 4x 过采样只要 12)
+    void prepare (double inputRate, double outputRate, int baseTapsPerPhase = kBaseTapsPerPhase);
+
+    // 整数倍抽取 (L = 1, M = factor)：输出率不是整数时也能用 (比如 44.1k / 8)
+    void prepareDecimator (double inputRate, int factor, int baseTapsPerPhase = kBaseTapsPerPhase);
+    void reset();
+
+    // 两边采样率一样：不用重采样
+    bool isPassThrough() const noexcept { return upFactor == downFactor; }
+
+    double getOutputRate() const noexcept { return outputRate; }
+
+    // numInput 个输入最多产生多少个输出
+    int getMaxOutputSamples (int numInput) const noexcept
+    {
+        return (int) (((juce::int64) numInput * upFactor) / downFactor) + 1;
+    }
+
+    // 实时安全：不分配。output 至少 getMaxOutputSamples (numInput) 个 float，返回写出的个数
+    int process (const float* input, int numInput, float* output) noexcept;
+
+    // 和 process 一样推进内部状态，但不算输出 (调用方确定这一段输出用不上时)；返回本该输出的个数
+    int skip (const float* input, int numInput) noexcept;
+
+    // 所有相位里 sum |h| 的最大值：|输出| <= 最近 tapsPerPhase 个输入的峰值 x 这个数
+    // (半带级联时是各级 sum |h| 的乘积，tapsPerPhase 是整个级联跨过的输入个数)
+    float getMaxPhaseGain() const noexcept { return maxPhaseGain; }
+    int getTapsPerPhase() const noexcept { return tapsPerPhase; }
+
+private:
+    // history 一次接收的输入块大小，和 host block 大小无关
+    static constexpr int kChunkSize = 256;
+
+    // upFactor / downFactor 定好之后建原型低通、拆相位、分配 history
+    void buildFilter (int baseTapsPerPhase);
+    int processChunk (const float* input, int numInput, float* output) noexcept;   // output == nullptr: 只推进
+    int processHalfBand (const float* input, int numInput, float* output) noexcept;
+    bool buildHalfBandStages();
+    bool isFourTimesUpsampler() const noexcept { return upFactor == 4 && downFactor == 1; }
+
+    int upFactor = 1;      // L
+    int downFactor = 1;    // M
+    int tapsPerPhase = 0;
+    double outputRate = 44100.0;
+    float maxPhaseGain = 1.0f;
+
+    std::vector<float> coefficients;   // L 组，每组 tapsPerPhase 个，已经反序 (直接和 history 点积)
+    std::vector<float> interleavedCoefficients;   // 4x 上采样时按 tap 排：[k * 4 + p]
+    std::vector<float> history;        // 前 tapsPerPhase - 1 个是上一块的尾巴
+
+    std::vector<HalfBandDecimator> halfBandStages;        // 非空时 process 走级联，不用上面的多相表
+    std::array<std::vector<float>, 2> stageBuffers;       // 级联中间结果 (两块轮流用)
+
+    int phase = 0;                     // 下一个输出 sample 的相位 (0..L-1)
+    int inputIndex = 0;                // 下一个输出对应的最新输入 sample，相对当前块
+};
@@ -0,0 +1,315 @@
+#include "ProfileLibrary.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "SpectralKernels.h"
+
+namespace
+{
+    TimbreProfile makeProfile (const std::array<float, ProfileLibrary::kDims>& values) noexcept
+    {
+        TimbreProfile p;
+        p.bright = values[0];
+        p.body   = values[1];
+        p.bite   = values[2];
+        p.air    = values[3];
+        p.noise  = values[4];
+        p.width  = values[5];
+        p.motion = values[6];
+        p.space  = values[7];
+        return p;
+    }
+
+    uint32_t roundUpToMultiple (uint32_t value, uint32_t multiple) noexcept
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+}
+
+ProfileLibrary::Header ProfileLibrary::makeHeader (int count, uint64_t namesBytes) noexcept
+{
+    Header h {};
+    std::memcpy (h.magic, "TLIB", 4);
+    h.version = kVersion;
+    h.numEntries = (uint32_t) count;
+    h.numDims = kDims;
+    h.spectrumPoints = kPoints;
+    h.columnStride = roundUpToMultiple ((uint32_t) count, kColumnAlignment);
+    h.spectraOffset = sizeof (Header) + (uint64_t) kDims * h.columnStride * sizeof (float);
+    h.nameOffsetsOffset = h.spectraOffset + (uint64_t) count * kPoints;
+    h.namesOffset = h.nameOffsetsOffset + ((uint64_t) count + 1) * sizeof (uint32_t);
+    h.fileSize = h.namesOffset + namesBytes;
+    return h;
+}
+
+bool ProfileLibrary::validate (const Header& header, size_t mappedSize) const noexcept
+{
+    if (std::memcmp (header.magic, "TLIB", 4) != 0 || header.version != kVersion
+        || header.numDims != (uint32_t) kDims || header.spectrumPoints != (uint32_t) kPoints
+        || header.numEntries > (uint32_t) std::numeric_limits<int>::max() / kPoints)
+        return false;
+
+    // 各段偏移必须和条数算出来的一致 (名字段长度由文件大小决定)
+    const auto expected = makeHeader ((int) header.numEntries, 0);
+
+    return header.columnStride == expected.columnStride
+        && header.spectraOffset == expected.spectraOffset
+        && header.nameOffsetsOffset == expected.nameOffsetsOffset
+        && header.namesOffset == expected.namesOffset
+        && header.fileSize >= header.namesOffset
+        && header.fileSize == (uint64_t) mappedSize;
+}
+
+bool ProfileLibrary::fail()
+{
+    close();
+    unreadable = true;
+    return false;
+}
+
+bool ProfileLibrary::open (const juce::File& newFile)
+{
+    close();
+    file = newFile;
+    unreadable = false;
+    mappedModificationTime = file.getLastModificationTime();
+    mappedFileSize = file.existsAsFile() ? file.getSize() : -1;
+
+    if (mappedFileSize <= 0)
+        return true;
+
+    map = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*> (map->getData());
+    const size_t size = map->getSize();
+
+    if (data == nullptr || size < sizeof (Header))
+        return fail();
+
+    Header header;
+    std::memcpy (&header, data, sizeof (Header));
+
+    if (! validate (header, size))
+        return fail();
+
+    // 名字偏移要单调，最后一个不能超出文件
+    const auto* nameOffsets = reinterpret_cast<const uint32_t*> (data + header.nameOffsetsOffset);
+    const uint64_t namesBytes = header.fileSize - header.namesOffset;
+
+    for (uint32_t i = 0; i < header.numEntries; ++i)
+        if (nameOffsets[i] > nameOffsets[i + 1])
+            return fail();
+
+    if (nameOffsets[0] != 0 || nameOffsets[header.numEntries] > namesBytes)
+        return fail();
+
+    numEntries = (int) header.numEntries;
+
+    for (int d = 0; d < kDims; ++d)
+        columns[(size_t) d] = reinterpret_cast<const float*> (data + sizeof (Header)) + (size_t) d * header.columnStride;
+
+    spectra = reinterpret_cast<const uint8_t*> (data + header.spectraOffset);
+    names = data + header.namesOffset;
+    distances.assign ((size_t) numEntries, 0.0f);
+    return true;
+}
+
+void ProfileLibrary::close()
+{
+    map.reset();
+    numEntries = 0;
+    columns.fill (nullptr);
+    spectra = nullptr;
+    names = nullptr;
+    distances.clear();
+    distances.shrink_to_fit();
+}
+
+bool ProfileLibrary::refresh()
+{
+    if (file == juce::File())
+        return false;
+
+    const juce::int64 size = file.existsAsFile() ? file.getSize() : -1;
+
+    if (size == mappedFileSize && file.getLastModificationTime() == mappedModificationTime)
+        return false;
+
+    open (file);
+    return true;
+}
+
+const uint32_t* ProfileLibrary::getNameOffsets() const noexcept
+{
+    // 名字偏移紧跟在谱后面
+    return reinterpret_cast<const uint32_t*> (spectra + (size_t) numEntries * kPoints);
+}
+
+juce::String ProfileLibrary::getName (int index) const
+{
+    jassert (juce::isPositiveAndBelow (index, numEntries));
+
+    const auto* offsets = getNameOffsets();
+    return juce::String::fromUTF8 (names + offsets[index], (int) (offsets[index + 1] - offsets[index]));
+}
+
+TimbreProfile ProfileLibrary::getProfile (int index) const noexcept
+{
+    jassert (juce::isPositiveAndBelow (index, numEntries));
+
+    std::array<float, kDims> values;
+    for (int d = 0; d < kDims; ++d)
+        values[(size_t) d] = columns[(size_t) d][index];
+
+    return makeProfile (values);
+}
+
+void ProfileLibrary::getSpectrum (int index, AnalysisSnapshot::SpectrumArray& levelsDbOut) const noexcept
+{
+    jassert (juce::isPositiveAndBelow (index, numEntries));
+
+    const uint8_t* levels = spectra + (size_t) index * kPoints;
+
+    for (int i = 0; i < kPoints; ++i)
+        levelsDbOut[(size_t) i] = AnalysisSnapshot::kSpectrumFloorDb + (float) levels[i] * kStepDb;
+}
+
+bool ProfileLibrary::add (const Entry& entry)
+{
+    if (! file.getParentDirectory().createDirectory())
+        return false;
+
+    // 别的实例可能在我们 map 之后存过：锁住之后按磁盘上现在的内容重新 open 再追加，
+    // 否则会拿过时的 map 把别人刚存的条目盖掉。文件校验不过时不写 (不覆盖用户的库)
+    const juce::InterProcessLock::ScopedLockType scopedLock (fileLock);
+
+    if (! scopedLock.isLocked() || ! open (file))
+        return false;
+
+    if (numEntries >= std::numeric_limits<int>::max() / kPoints - 1)
+        return false;
+
+    const int count = numEntries + 1;
+    const auto* offsets = numEntries > 0 ? getNameOffsets() : nullptr;
+    const uint32_t oldNamesBytes = numEntries > 0 ? offsets[numEntries] : 0;
+
+    const char* nameUtf8 = entry.name.toRawUTF8();
+    const auto nameBytes = (uint32_t) entry.name.getNumBytesAsUTF8();
+    const auto header = makeHeader (count, (uint64_t) oldNamesBytes + nameBytes);
+
+    // 先写临时文件 (和库在同一个目录)，写完整了再替换，中途失败时原库不动
+    juce::TemporaryFile temp (file);
+
+    {
+        juce::FileOutputStream out (temp.getFile());
+
+        if (! out.openedOk())
+            return false;
+
+        out.write (&header, sizeof (Header));
+
+        // 每列：旧值 + 新值 + 补齐
+        const auto values = entry.profile.toArray();
+        const std::vector<float> padding (header.columnStride - (uint32_t) count, 0.0f);
+
+        for (int d = 0; d < kDims; ++d)
+        {
+            if (numEntries > 0)
+                out.write (columns[(size_t) d], (size_t) numEntries * sizeof (float));
+
+            out.write (&values[(size_t) d], sizeof (float));
+
+            if (! padding.empty())
+                out.write (padding.data(), padding.size() * sizeof (float));
+        }
+
+        if (numEntries > 0)
+            out.write (spectra, (size_t) numEntries * kPoints);
+
+        std::array<uint8_t, kPoints> quantised;
+        for (int i = 0; i < kPoints; ++i)
+        {
+            const float db = entry.spectrumDb[(size_t) i];
+            quantised[(size_t) i] = (uint8_t) juce::jlimit (0, 255, juce::roundToInt ((db - AnalysisSnapshot::kSpectrumFloorDb) / kStepDb));
+        }
+        out.write (quantised.data(), quantised.size());
+
+        if (numEntries > 0)
+            out.write (offsets, ((size_t) numEntries + 1) * sizeof (uint32_t));
+        else
+            out.write (&oldNamesBytes, sizeof (uint32_t));
+
+        const uint32_t end = oldNamesBytes + nameBytes;
+        out.write (&end, sizeof (uint32_t));
+
+        if (oldNamesBytes > 0)
+            out.write (names, oldNamesBytes);
+
+        out.write (nameUtf8, nameBytes);
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    // 替换前先解除映射 (Windows 上映射着的文件不能覆盖)
+    const auto target = file;
+    close();
+
+    if (! temp.overwriteTargetFileWithTemporary())
+    {
+        open (target);
+        return false;
+    }
+
+    return open (target);
+}
+
+int ProfileLibrary::findNearest (const TimbreProfile& query, MatchArray& matches, int k) const noexcept
+{
+    k = juce::jmin (k, kMaxMatches, numEntries);
+
+    if (k <= 0)
+        return 0;
+
+    const auto point = query.toArray();
+    SpectralKernels::squaredDistances (columns.data(), point.data(), kDims, distances.data(), numEntries);
+
+    // 前 k 个按距离从小到大排着；只有比第 k 个近的才插进来
+    std::array<float, kMaxMatches> best;
+    std::array<int, kMaxMatches> bestIndex;
+    int found = 0;
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        const float d = distances[(size_t) i];
+
+        if (found == k && d >= best[(size_t) k - 1])
+            continue;
+
+        int slot = found < k ? found++ : k - 1;
+
+        while (slot > 0 && best[(size_t) slot - 1] > d)
+        {
+            best[(size_t) slot] = best[(size_t) slot - 1];
+            bestIndex[(size_t) slot] = bestIndex[(size_t) slot - 1];
+            --slot;
+        }
+
+        best[(size_t) slot] = d;
+        bestIndex[(size_t) slot] = i;
+    }
+
+    for (int i = 0; i < found; ++i)
+        matches[(size_t) i] = { bestIndex[(size_t) i], std::sqrt (best[(size_t) i]) };
+
+    return found;
+}
+
+juce::File ProfileLibrary::getDefaultFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("TimbreLab")
+               .getChildFile ("ProfileLibrary.tlib");
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AnalysisSnapshot.h"
+#include "TimbreProfile.h"
+
+// 存在磁盘上的 target 库：每条是名字 + 8 维 profile + 1/24 倍频程 dB 谱。
+// 文件按列存 (SoA)：8 个 profile 维度各一列 float，谱按 0.5 dB 一格存成 uint8，名字最后。
+// 打开时整个文件 memory-map (只读)，不拷贝：10 万条 profile 列一共 3.2 MB，
+// 最近邻是对 8 列做一次 SIMD 扫描 (SpectralKernels::squaredDistances) 再挑前 k 个。
+// 只在消息线程上用 (扫描会碰 mmap 的页，可能缺页，不放音频线程)。
+// 所有实例 (包括别的进程里的) 共用一个文件：add 在跨进程锁里按磁盘上现在的内容追加，
+// 别的实例存过之后 refresh 会重新 map。
+class ProfileLibrary
+{
+public:
+    static constexpr int kDims = 8;
+    static constexpr int kMaxMatches = 8;
+
+    struct Entry
+    {
+        juce::String name;
+        TimbreProfile profile;
+        AnalysisSnapshot::SpectrumArray spectrumDb {};
+    };
+
+    struct Match
+    {
+        int index = -1;
+        float distance = 0.0f;      // 8 维欧氏距离
+    };
+
+    using MatchArray = std::array<Match, kMaxMatches>;
+
+    ProfileLibrary() = default;
+
+    // 文件不存在时是空库 (第一次 add 时创建)；文件损坏 / 版本不对时返回 false，库保持为空
+    bool open (const juce::File& file);
+    void close();
+
+    // 文件被别的实例改过 (修改时间 / 大小和 map 时不一样) 时重新 open；返回是否重新 open 了
+    bool refresh();
+
+    // 文件在但打不开 / 校验不过：add 拒绝写，不拿一个空库覆盖用户的文件
+    bool isUnreadable() const noexcept { return unreadable; }
+
+    const juce::File& getFile() const noexcept { return file; }
+    int getNumEntries() const noexcept { return numEntries; }
+
+    juce::String getName (int index) const;
+    TimbreProfile getProfile (int index) const noexcept;
+    void getSpectrum (int index, AnalysisSnapshot::SpectrumArray& levelsDbOut) const noexcept;
+
+    // 追加一条：加跨进程锁，重新读一遍磁盘上的库，写一个新文件 (临时文件写完再替换)，
+    // 然后重新 map；失败 / 文件校验不过时原文件不变
+    bool add (const Entry& entry);
+
+    // query 最近的前 k 个 (k <= kMaxMatches)，从近到远写进 matches，返回个数
+    int findNearest (const TimbreProfile& query, MatchArray& matches, int k) const noexcept;
+
+    // 默认位置：用户 application data 目录下
+    static juce::File getDefaultFile();
+
+private:
+    static constexpr int kPoints = AnalysisSnapshot::kSpectrumPoints;
+    static constexpr float kStepDb = 0.5f;
+    static constexpr int kColumnAlignment = 16;     // 每列补齐到 16 个 float (64 字节)
+
+    // 文件头 (64 字节，本机字节序)，后面依次是：
+    // kDims 列 float (每列 columnStride 个) | numEntries x kPoints 个 uint8 谱 |
+    // numEntries + 1 个 uint32 名字偏移 | UTF-8 名字
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t numEntries;
+        uint32_t numDims;
+        uint32_t spectrumPoints;
+        uint32_t columnStride;
+        uint64_t spectraOffset;
+        uint64_t nameOffsetsOffset;
+        uint64_t namesOffset;
+        uint64_t fileSize;
+        uint8_t reserved[8];
+    };
+
+    static_assert (sizeof (Header) == 64, "ProfileLibrary::Header layout");
+
+    static constexpr uint32_t kVersion = 1;
+
+    static Header makeHeader (int numEntries, uint64_t namesBytes) noexcept;
+    bool validate (const Header& header, size_t mappedSize) const noexcept;
+    bool fail();     // open 失败：清空并记下 unreadable
+    const uint32_t* getNameOffsets() const noexcept;
+
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    bool unreadable = false;
+    juce::Time mappedModificationTime;     // open 时文件的状态，refresh 拿来比
+    juce::int64 mappedFileSize = -1;       // -1 = 文件不存在
+
+    juce::InterProcessLock fileLock { "TimbreLabProfileLibrary" };   // add 读-改-写整个文件时拿
+
+    int numEntries = 0;
+    std::array<const float*, kDims> columns {};
+    const uint8_t* spectra = nullptr;
+    const char* names = nullptr;
+
+    // findNearest 的草稿 (open 时按条数分配)
+    mutable std::vector<float> distances;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProfileLibrary)
+};
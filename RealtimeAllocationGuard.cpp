@@ -0,0 +1,95 @@
+#include <juce_core/juce_core.h>
+
+#include "RealtimeAllocationGuard.h"
+
+#if TIMBRE_LAB_CHECK_RT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local int disallowDepth = 0;
+
+    void checkAllocation() noexcept
+    {
+        if (disallowDepth > 0)
+        {
+            // 先退出作用域再断言，jassert 自己记日志时也会分配
+            const int depth = disallowDepth;
+            disallowDepth = 0;
+            jassertfalse;   // 音频线程在 capture 期间分配了内存
+            disallowDepth = depth;
+        }
+    }
+
+    void* allocate (std::size_t size)
+    {
+        checkAllocation();
+
+        if (void* p = std::malloc (size == 0 ? 1 : size))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocateNoThrow (std::size_t size) noexcept
+    {
+        checkAllocation();
+        return std::malloc (size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned (std::size_t size, std::align_val_t alignment)
+    {
+        checkAllocation();
+
+        const auto align = juce::jmax ((std::size_t) alignment, sizeof (void*));
+        const auto rounded = (juce::jmax (size, (std::size_t) 1) + align - 1) / align * align;
+
+       #if JUCE_WINDOWS
+        if (void* p = _aligned_malloc (rounded, align))
+            return p;
+       #else
+        void* p = nullptr;
+        if (posix_memalign (&p, align, rounded) == 0)
+            return p;
+       #endif
+
+        throw std::bad_alloc();
+    }
+
+    void freeAligned (void* p) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free (p);
+       #else
+        std::free (p);
+       #endif
+    }
+}
+
+namespace RealtimeAllocationGuard
+{
+    void enterScope() noexcept { ++disallowDepth; }
+    void exitScope() noexcept  { --disallowDepth; }
+}
+
+void* operator new (std::size_t size)                                  { return allocate (size); }
+void* operator new[] (std::size_t size)                                { return allocate (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept   { return allocateNoThrow (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { return allocateNoThrow (size); }
+void* operator new (std::size_t size, std::align_val_t alignment)       { return allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment)     { return allocateAligned (size, alignment); }
+
+void operator delete (void* p) noexcept                                 { std::free (p); }
+void operator delete[] (void* p) noexcept                               { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept                    { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept                  { std::free (p); }
+void operator delete (void* p, const std::nothrow_t&) noexcept          { std::free (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept        { std::free (p); }
+void operator delete (void* p, std::align_val_t) noexcept               { freeAligned (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept             { freeAligned (p); }
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept  { freeAligned (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept { freeAligned (p); }
+
+#endif
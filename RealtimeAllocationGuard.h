@@ -0,0 +1,48 @@
+#pragma once
+
+// Debug 构建下检查音频线程有没有分配内存。
+// 打开时替换全局 operator new/delete：在 ScopedDisallow 的作用域里 (当前线程) 一旦分配就 jassert。
+// Release 构建默认关闭，ScopedDisallow 什么都不做。
+#ifndef TIMBRE_LAB_CHECK_RT_ALLOCATIONS
+ #if JUCE_DEBUG
+  #define TIMBRE_LAB_CHECK_RT_ALLOCATIONS 1
+ #else
+  #define TIMBRE_LAB_CHECK_RT_ALLOCATIONS 0
+ #endif
+#endif
+
+namespace RealtimeAllocationGuard
+{
+   #if TIMBRE_LAB_CHECK_RT_ALLOCATIONS
+    void enterScope() noexcept;
+    void exitScope() noexcept;
+   #endif
+
+    class ScopedDisallow
+    {
+    public:
+       #if TIMBRE_LAB_CHECK_RT_ALLOCATIONS
+        explicit ScopedDisallow (bool shouldCheck) noexcept : active (shouldCheck)
+        {
+            if (active)
+                enterScope();
+        }
+
+        ~ScopedDisallow() noexcept
+        {
+            if (active)
+                exitScope();
+        }
+       #else
+        explicit ScopedDisallow (bool) noexcept {}
+       #endif
+
+        ScopedDisallow (const ScopedDisallow&) = delete;
+        ScopedDisallow& operator= (const ScopedDisallow&) = delete;
+
+    private:
+       #if TIMBRE_LAB_CHECK_RT_ALLOCATIONS
+        bool active = false;
+       #endif
+    };
+}
@@ -0,0 +1,337 @@
+#include "ReferenceAligner.h"
+#include "OnsetEnvelope.h"
+#include "SpectralKernels.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr float kNoScore = -std::numeric_limits<float>::infinity();
+
+    // 三个相邻的分数拟合抛物线，峰值相对中间那个的位置 (-0.5..0.5)
+    double parabolicOffset (float before, float peak, float after) noexcept
+    {
+        if (before == kNoScore || after == kNoScore)
+            return 0.0;
+
+        const float denominator = before - 2.0f * peak + after;
+        return denominator < 0.0f ? juce::jlimit (-0.5, 0.5, 0.5 * (double) (before - after) / (double) denominator) : 0.0;
+    }
+}
+
+void ReferenceAligner::setReference (const float* envelope, int numValues)
+{
+    jassert (numValues > 0);
+
+    const int maxExcerpt = (int) std::ceil (kMaxExcerptSeconds * OnsetEnvelope::kValuesPerSecond) + 1;
+    const int order = juce::jmax (4, (int) std::ceil (std::log2 ((double) (numValues + maxExcerpt))));
+
+    fftSize = 1 << order;
+
+    if (fft == nullptr || fft->getSize() != fftSize)
+        fft = std::make_unique<juce::dsp::FFT> (order);
+
+    referenceLength = numValues;
+
+    // 去均值：包络整体的高低不算相关
+    double mean = 0.0;
+    for (int i = 0; i < numValues; ++i)
+        mean += envelope[i];
+    mean /= (double) numValues;
+
+    referenceValues.resize ((size_t) numValues);
+    referenceEnergy.assign ((size_t) numValues + 1, 0.0);
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        referenceValues[(size_t) i] = (float) (envelope[i] - mean);
+        referenceEnergy[(size_t) i + 1] = referenceEnergy[(size_t) i] + (double) (referenceValues[(size_t) i] * referenceValues[(size_t) i]);
+    }
+
+    referenceSpectrum.assign ((size_t) fftSize * 2, 0.0f);
+    std::copy (referenceValues.begin(), referenceValues.end(), referenceSpectrum.begin());
+    fft->performRealOnlyForwardTransform (referenceSpectrum.data(), true);
+
+    correlation.assign ((size_t) fftSize * 2, 0.0f);
+    excerptValues.assign ((size_t) maxExcerpt, 0.0f);
+    excerptEnergy.assign ((size_t) maxExcerpt + 1, 0.0);
+}
+
+void ReferenceAligner::clearReference()
+{
+    referenceLength = 0;
+}
+
+ReferenceAligner::Match ReferenceAligner::findLag (const float* envelope, int numValues, int minLag, int maxLag)
+{
+    numValues = juce::jmin (numValues, (int) excerptValues.size());
+
+    if (! hasReference() || numValues < 2)
+        return {};
+
+    double mean = 0.0;
+    for (int i = 0; i < numValues; ++i)
+        mean += envelope[i];
+    mean /= (double) numValues;
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        excerptValues[(size_t) i] = (float) (envelope[i] - mean);
+        excerptEnergy[(size_t) i + 1] = excerptEnergy[(size_t) i] + (double) (excerptValues[(size_t) i] * excerptValues[(size_t) i]);
+    }
+
+    // 互相关 = IFFT (conj (X) * R)；fftSize >= 两边长度之和，负的 lag 在数组末尾，不会绕回来
+    std::fill (correlation.begin(), correlation.end(), 0.0f);
+    std::copy (excerptValues.begin(), excerptValues.begin() + numValues, correlation.begin());
+    fft->performRealOnlyForwardTransform (correlation.data(), true);
+
+    for (int k = 0; k <= fftSize / 2; ++k)
+    {
+        const float xr = correlation[(size_t) k * 2], xi = correlation[(size_t) k * 2 + 1];
+        const float rr = referenceSpectrum[(size_t) k * 2], ri = referenceSpectrum[(size_t) k * 2 + 1];
+
+        correlation[(size_t) k * 2]     = xr * rr + xi * ri;
+        correlation[(size_t) k * 2 + 1] = xr * ri - xi * rr;
+    }
+
+    fft->performRealOnlyInverseTransform (correlation.data());
+
+    // 按重叠部分两边的能量归一化 (FFT 的整体缩放不影响比较)；重叠不到一半的 lag 不算
+    const int minOverlap = (numValues + 1) / 2;
+
+    auto overlapOf = [&] (int lag, int& first, int& last)
+    {
+        first = juce::jmax (0, -lag);
+        last = juce::jmin (numValues, referenceLength - lag);
+        return last - first >= minOverlap;
+    };
+
+    auto score = [&] (int lag)
+    {
+        int first, last;
+        if (lag < minLag || lag > maxLag || ! overlapOf (lag, first, last))
+            return kNoScore;
+
+        const double energy = (excerptEnergy[(size_t) last] - excerptEnergy[(size_t) first])
+                            * (referenceEnergy[(size_t) (last + lag)] - referenceEnergy[(size_t) (first + lag)]);
+
+        return energy > 0.0 ? (float) (correlation[(size_t) ((lag + fftSize) & (fftSize - 1))] / std::sqrt (energy)) : kNoScore;
+    };
+
+    int bestLag = 0;
+    float bestScore = kNoScore;
+
+    for (int lag = minLag; lag <= maxLag; ++lag)
+    {
+        const float s = score (lag);
+
+        if (s > bestScore)
+        {
+            bestScore = s;
+            bestLag = lag;
+        }
+    }
+
+    if (bestScore == kNoScore)
+        return {};
+
+    // 峰值处直接在时域算一次准确的 NCC 当置信度
+    int first, last;
+    overlapOf (bestLag, first, last);
+
+    const double energy = (excerptEnergy[(size_t) last] - excerptEnergy[(size_t) first])
+                        * (referenceEnergy[(size_t) (last + bestLag)] - referenceEnergy[(size_t) (first + bestLag)]);
+    const float confidence = (float) (SpectralKernels::dot (excerptValues.data() + first, referenceValues.data() + first + bestLag, last - first)
+                                      / std::sqrt (energy));
+
+    Match match;
+    match.lag = bestLag + parabolicOffset (score (bestLag - 1), bestScore, score (bestLag + 1));
+    match.confidence = confidence;
+    match.found = confidence >= kMinConfidence;
+    return match;
+}
+
+ReferenceAligner::Alignment ReferenceAligner::alignEnvelope (const float* envelope, int numValues)
+{
+    Alignment alignment;
+    const int half = numValues / 2;
+    const bool canMeasureDrift = half >= (int) (kMinDriftSpanSeconds * OnsetEnvelope::kValuesPerSecond);
+
+    auto whole = findLag (envelope, numValues, -(numValues / 2), referenceLength - (numValues + 1) / 2);
+
+    // 漂移大一些 (0.2% 在 30 秒里就是 60 ms) 时整段的相关峰会被抹平：只用前一半再找一次
+    if (! whole.found && canMeasureDrift)
+        whole = findLag (envelope, half, -(half / 2), referenceLength - (half + 1) / 2);
+
+    alignment.confidence = whole.confidence;
+
+    if (! whole.found)
+        return alignment;
+
+    alignment.found = true;
+    alignment.offsetSeconds = whole.lag / OnsetEnvelope::kValuesPerSecond;
+
+    if (! canMeasureDrift)
+        return alignment;
+
+    // 前后两半分别对齐：每一半的偏移约等于它中点处的偏移
+    const int centre = juce::roundToInt (whole.lag);
+    const auto first = findLag (envelope, half, centre - kDriftSearchValues, centre + kDriftSearchValues);
+    const auto second = findLag (envelope + half, numValues - half, centre + half - kDriftSearchValues, centre + half + kDriftSearchValues);
+
+    if (! first.found || ! second.found)
+        return alignment;
+
+    const double drift = ((second.lag - half) - first.lag) / (double) half;
+
+    if (std::abs (drift) <= kMaxDrift)
+    {
+        alignment.drift = drift;
+        alignment.offsetSeconds = (first.lag - drift * (double) half * 0.5) / OnsetEnvelope::kValuesPerSecond;
+    }
+
+    return alignment;
+}
+
+void ReferenceAligner::refine (Alignment& alignment, const float* capture, int numSamples, double captureRate,
+                               const float* envelope, int numValues, juce::AudioFormatReader& reference)
+{
+    if (! alignment.found || reference.sampleRate <= 0.0)
+        return;
+
+    // 前后两半各取一个点：两个都找到时顺便把漂移算准
+    const int half = numValues / 2;
+    const int starts[2] = { pickExcerptStart (envelope, 0, half, numSamples, captureRate),
+                            pickExcerptStart (envelope, half, numValues, numSamples, captureRate) };
+
+    double captureTimes[2] {}, referenceTimes[2] {};
+    int numPoints = 0;
+
+    for (const int start : starts)
+    {
+        if (start < 0)
+            continue;
+
+        const double referenceTime = refineAt (capture, start, captureRate, alignment, reference);
+
+        if (referenceTime >= 0.0)
+        {
+            captureTimes[numPoints] = (double) start / captureRate;
+            referenceTimes[numPoints] = referenceTime;
+            ++numPoints;
+        }
+    }
+
+    if (numPoints == 0)
+        return;
+
+    if (numPoints == 2 && captureTimes[1] - captureTimes[0] >= kMinDriftSpanSeconds)
+    {
+        const double drift = (referenceTimes[1] - referenceTimes[0]) / (captureTimes[1] - captureTimes[0]) - 1.0;
+
+        if (std::abs (drift) <= kMaxDrift)
+            alignment.drift = drift;
+    }
+
+    alignment.offsetSeconds = referenceTimes[0] - captureTimes[0] * (1.0 + alignment.drift);
+    alignment.sampleAccurate = true;
+}
+
+int ReferenceAligner::pickExcerptStart (const float* envelope, int first, int last, int numSamples, double captureRate) const
+{
+    constexpr double preRollSeconds = 0.05;   // 片段从音头前一点开始
+    const int length = juce::roundToInt (kRefineSeconds * captureRate);
+
+    int bestStart = -1;
+    float bestValue = 0.0f;
+
+    for (int k = first; k < last; ++k)
+    {
+        const int start = juce::roundToInt (((double) k / OnsetEnvelope::kValuesPerSecond - preRollSeconds) * captureRate);
+
+        if (start >= 0 && start + length <= numSamples && envelope[k] > bestValue)
+        {
+            bestValue = envelope[k];
+            bestStart = start;
+        }
+    }
+
+    return bestStart;
+}
+
+double ReferenceAligner::refineAt (const float* capture, int startSample, double captureRate, const Alignment& alignment,
+                                  juce::AudioFormatReader& reference)
+{
+    const int length = juce::roundToInt (kRefineSeconds * captureRate);
+    const int radius = juce::roundToInt (kRefineRadiusSeconds * captureRate);
+    const int numLags = radius * 2 + 1;
+    const int numReference = length + numLags - 1;
+
+    // reference 上对应的一段 (前后各多留 radius)，按漂移后的速度插值到 capture 的采样率
+    const double speed = 1.0 + alignment.drift;
+    const double startSeconds = alignment.offsetSeconds + ((double) startSample - (double) radius) / captureRate * speed;
+    const double step = speed * reference.sampleRate / captureRate;
+    const double firstPosition = startSeconds * reference.sampleRate;
+    const auto readStart = (juce::int64) std::floor (firstPosition);
+    const int readLength = (int) std::ceil (firstPosition - (double) readStart + (double) (numReference - 1) * step) + 2;
+
+    if (readStart < 0 || readStart + readLength > reference.lengthInSamples)
+        return -1.0;
+
+    readBuffer.setSize (2, readLength, false, false, true);
+
+    // 单声道文件会把唯一的声道同时读进 L / R
+    if (! reference.read (&readBuffer, 0, readLength, readStart, true, true))
+        return -1.0;
+
+    const float* left = readBuffer.getReadPointer (0);
+    const float* right = readBuffer.getReadPointer (1);
+
+    referenceExcerpt.resize ((size_t) numReference);
+    referenceExcerptEnergy.assign ((size_t) numReference + 1, 0.0);
+
+    for (int j = 0; j < numReference; ++j)
+    {
+        const double position = firstPosition - (double) readStart + (double) j * step;
+        const int i = (int) position;
+        const float fraction = (float) (position - (double) i);
+        const float a = 0.5f * (left[i] + right[i]);
+        const float b = 0.5f * (left[i + 1] + right[i + 1]);
+        const float value = a + fraction * (b - a);
+
+        referenceExcerpt[(size_t) j] = value;
+        referenceExcerptEnergy[(size_t) j + 1] = referenceExcerptEnergy[(size_t) j] + (double) (value * value);
+    }
+
+    const float* excerpt = capture + startSample;
+    const double captureEnergy = SpectralKernels::dot (excerpt, excerpt, length);
+
+    if (captureEnergy <= 0.0)
+        return -1.0;
+
+    auto score = [&] (int lag)
+    {
+        const double energy = captureEnergy * (referenceExcerptEnergy[(size_t) (lag + length)] - referenceExcerptEnergy[(size_t) lag]);
+        return energy > 0.0 ? (float) (SpectralKernels::dot (excerpt, referenceExcerpt.data() + lag, length) / std::sqrt (energy)) : kNoScore;
+    };
+
+    auto& scores = lagScores;
+    scores.resize ((size_t) numLags);
+    int bestLag = 0;
+
+    for (int lag = 0; lag < numLags; ++lag)
+    {
+        scores[(size_t) lag] = score (lag);
+
+        if (scores[(size_t) lag] > scores[(size_t) bestLag])
+            bestLag = lag;
+    }
+
+    // 峰值落在搜索范围边上：粗对齐错得比预想的多，不信这个点
+    if (scores[(size_t) bestLag] < kMinConfidence || bestLag == 0 || bestLag == numLags - 1)
+        return -1.0;
+
+    const double lag = bestLag + parabolicOffset (scores[(size_t) bestLag - 1], scores[(size_t) bestLag], scores[(size_t) bestLag + 1]);
+    return startSeconds + lag * speed / captureRate;
+}
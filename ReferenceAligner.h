@@ -0,0 +1,83 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include <memory>
+#include <vector>
+
+// capture 和导入的 reference 对齐：找出 capture 开头对应 reference 的哪个时刻 (以及可选的速度漂移)
+//   1. 粗对齐：两边的 OnsetEnvelope (10 ms 一格) 做 FFT 互相关，reference 的频谱在 setReference 时算好一次；
+//      每个 lag 按重叠部分的能量归一化 (NCC)，峰值抛物线插值到格以下
+//   2. 漂移：capture 前后两半各自在粗对齐附近再找一次，偏移之差 / 时间差 (只用来摆放第 3 步的片段)
+//   3. 采样级：两半里各取最强的音头附近 kRefineSeconds，和 reference 同一位置的原始音频
+//      在 ±kRefineRadiusSeconds 内逐 sample 做 NCC；两个点都找到时漂移也用这两个点算
+// 30 秒的片段对 5 分钟的 reference：一次 64k 点的 FFT 往返 + 两段几千万次乘加，几十毫秒。
+// 只在 worker 线程上用 (会分配)。
+class ReferenceAligner
+{
+public:
+    struct Alignment
+    {
+        bool found = false;
+        double offsetSeconds = 0.0;   // capture 开头对应的 reference 时间
+        double drift = 0.0;           // reference 时间 = offsetSeconds + capture 时间 x (1 + drift)
+        float confidence = 0.0f;      // 粗对齐的 NCC 峰值 (0..1)
+        bool sampleAccurate = false;  // 采样级细化成功了
+    };
+
+    static constexpr double kMaxExcerptSeconds = 60.0;
+    static constexpr float kMinConfidence = 0.3f;
+
+    // 包络 (OnsetEnvelope 的值)：去均值、算好频谱
+    void setReference (const float* envelope, int numValues);
+    void clearReference();
+    bool hasReference() const noexcept { return referenceLength > 0; }
+
+    // 粗对齐 + 漂移 (包络最长 kMaxExcerptSeconds)；capture 至少有一半和 reference 重叠才算
+    Alignment alignEnvelope (const float* envelope, int numValues);
+
+    // 采样级细化：capture 是 Mid (captureRate)，reference 从文件里按需读一小段
+    void refine (Alignment& alignment, const float* capture, int numSamples, double captureRate,
+                 const float* envelope, int numValues, juce::AudioFormatReader& reference);
+
+private:
+    static constexpr double kRefineSeconds = 0.5;
+    static constexpr double kRefineRadiusSeconds = 0.02;   // 粗对齐的误差 (约两格)
+    static constexpr double kMinDriftSpanSeconds = 5.0;    // 两个点至少隔这么远才用来算漂移
+    static constexpr double kMaxDrift = 0.02;
+    static constexpr int kDriftSearchValues = 50;          // 前后两半在粗对齐 ±0.5 秒内找
+
+    struct Match
+    {
+        bool found = false;
+        double lag = 0.0;
+        float confidence = 0.0f;
+    };
+
+    // 包络互相关：excerpt[i] 对上 reference[i + lag]，lag 在 [minLag, maxLag] 里找
+    Match findLag (const float* envelope, int numValues, int minLag, int maxLag);
+
+    // capture 从 startSample 起 kRefineSeconds 在 reference 里的精确时间 (秒)，没找到返回 < 0
+    double refineAt (const float* capture, int startSample, double captureRate, const Alignment& alignment,
+                     juce::AudioFormatReader& reference);
+
+    // 最强的音头 (包络 [first, last) 里的最大值)，换算成片段的起点 sample；放不下返回 -1
+    int pickExcerptStart (const float* envelope, int first, int last, int numSamples, double captureRate) const;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    int fftSize = 0;
+    int referenceLength = 0;
+    std::vector<float> referenceValues;      // 去均值
+    std::vector<double> referenceEnergy;     // referenceValues^2 的前缀和
+    std::vector<float> referenceSpectrum;    // 2 * fftSize
+    std::vector<float> correlation;          // 2 * fftSize
+    std::vector<float> excerptValues;
+    std::vector<double> excerptEnergy;
+
+    // 采样级细化的 scratch
+    juce::AudioBuffer<float> readBuffer;
+    std::vector<float> referenceExcerpt;
+    std::vector<double> referenceExcerptEnergy;
+    std::vector<float> lagScores;
+};
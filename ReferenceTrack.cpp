@@ -0,0 +1,105 @@
+#include "ReferenceTrack.h"
+
+#include <algorithm>
+
+ReferenceTrack::ReferenceTrack (double newDurationSeconds)
+    : durationSeconds (juce::jmax (0.0, newDurationSeconds)),
+      numFrames (juce::jmax (1, (int) std::ceil (durationSeconds / kHopSeconds)))
+{
+    profiles.resize ((size_t) numFrames);
+    spectra.assign ((size_t) numFrames * kPoints, 0);
+}
+
+void ReferenceTrack::addFrame (double endSeconds, const TimbreProfile& profile, const AnalysisSnapshot::SpectrumArray* levelsDb) noexcept
+{
+    const int hop = getFrameIndex (endSeconds);
+    jassert (hop >= currentHop);
+
+    if (hop != currentHop)
+    {
+        flushHop();
+        currentHop = hop;
+    }
+
+    const auto values = profile.toArray();
+    for (size_t d = 0; d < values.size(); ++d)
+        profileSums[d] += values[d];
+
+    ++profileCount;
+
+    if (levelsDb != nullptr)
+    {
+        for (size_t i = 0; i < levelSums.size(); ++i)
+            levelSums[i] += (*levelsDb)[i];
+
+        ++levelCount;
+    }
+}
+
+void ReferenceTrack::finalise() noexcept
+{
+    flushHop();
+
+    // 最后一帧之后的格 (文件末尾不够一帧的部分) 沿用最后一格
+    if (lastWrittenHop >= 0)
+        for (int frame = lastWrittenHop + 1; frame < numFrames; ++frame)
+            profiles[(size_t) frame] = profiles[(size_t) lastWrittenHop];
+
+    if (lastSpectrumHop >= 0)
+        for (int frame = lastSpectrumHop + 1; frame < numFrames; ++frame)
+            std::copy_n (spectra.begin() + lastSpectrumHop * kPoints, kPoints, spectra.begin() + frame * kPoints);
+
+    lastWrittenHop = lastSpectrumHop = numFrames - 1;
+}
+
+void ReferenceTrack::flushHop() noexcept
+{
+    if (currentHop < 0 || profileCount == 0)
+        return;
+
+    const double invCount = 1.0 / (double) profileCount;
+    TimbreProfile mean;
+    mean.bright = (float) (profileSums[0] * invCount);
+    mean.body   = (float) (profileSums[1] * invCount);
+    mean.bite   = (float) (profileSums[2] * invCount);
+    mean.air    = (float) (profileSums[3] * invCount);
+    mean.noise  = (float) (profileSums[4] * invCount);
+    mean.width  = (float) (profileSums[5] * invCount);
+    mean.motion = (float) (profileSums[6] * invCount);
+    mean.space  = (float) (profileSums[7] * invCount);
+
+    // 前面没有帧落进去的格 (开头凑不满一帧、或者 hop 比帧间隔还长) 用这一格补上
+    for (int frame = lastWrittenHop + 1; frame <= currentHop; ++frame)
+        profiles[(size_t) frame] = mean;
+
+    // dB 的平均 (log 谱)；开头低频段还没出帧的几格没有谱，等第一格有谱的时候一起补
+    if (levelCount > 0)
+    {
+        std::array<uint8_t, kPoints> quantised;
+
+        for (size_t i = 0; i < quantised.size(); ++i)
+        {
+            const float db = levelSums[i] / (float) levelCount;
+            quantised[i] = (uint8_t) juce::jlimit (0, 255, juce::roundToInt ((db - AnalysisSnapshot::kSpectrumFloorDb) / kStepDb));
+        }
+
+        for (int frame = lastSpectrumHop + 1; frame <= currentHop; ++frame)
+            std::copy (quantised.begin(), quantised.end(), spectra.begin() + frame * kPoints);
+
+        lastSpectrumHop = currentHop;
+    }
+
+    lastWrittenHop = currentHop;
+    profileSums.fill (0.0);
+    profileCount = 0;
+    levelSums.fill (0.0f);
+    levelCount = 0;
+}
+
+void ReferenceTrack::getSpectrum (int frame, AnalysisSnapshot::SpectrumArray& levelsDbOut) const noexcept
+{
+    const uint8_t* levels = spectra.data() + (size_t) frame * kPoints;
+
+    for (size_t i = 0; i < levelsDbOut.size(); ++i)
+        levelsDbOut[i] = AnalysisSnapshot::kSpectrumFloorDb + (float) levels[i] * kStepDb;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "AnalysisSnapshot.h"
+#include "TimbreProfile.h"
+
+// 导入的 reference 按时间索引的特征轨：每 kHopSeconds 一格，存这一格的 profile 和 1/24 倍频程 dB 谱。
+// 每一格是 "reference 在这个时刻放出来时，实时分析会显示什么"：分析帧按结束时间落格，
+// Motion / Bite / Width 用和实时分析一样的窗口 / 时间常数，所以能和 current 逐格直接比。
+// worker 上顺序写 (addFrame / finalise)，之后只读；音频线程按播放位置 O(1) 直接算下标，不搜索。
+// 谱按 0.5 dB 一格存成 uint8：6 分钟的歌 3600 格，一共不到 1 MB。
+class ReferenceTrack
+{
+public:
+    static constexpr double kHopSeconds = 0.1;
+
+    // worker：按时长一次分配好所有格
+    explicit ReferenceTrack (double durationSeconds);
+
+    // worker：一个分析帧 (endSeconds = 帧最后一个 sample 的时间)；levelsDb 为 nullptr 时这一帧不计入谱
+    // 帧必须按时间顺序来
+    void addFrame (double endSeconds, const TimbreProfile& profile, const AnalysisSnapshot::SpectrumArray* levelsDb) noexcept;
+
+    // worker：写完最后一格，没有帧落进去的格沿用相邻的格
+    void finalise() noexcept;
+
+    // ---- 只读 (finalise 之后，任何线程) ----
+    int getNumFrames() const noexcept { return numFrames; }
+    double getDurationSeconds() const noexcept { return durationSeconds; }
+
+    // 时间 -> 格，超出范围的夹到两端
+    int getFrameIndex (double seconds) const noexcept
+    {
+        return juce::jlimit (0, numFrames - 1, (int) std::floor (seconds / kHopSeconds));
+    }
+
+    const TimbreProfile& getProfile (int frame) const noexcept { return profiles[(size_t) frame]; }
+    void getSpectrum (int frame, AnalysisSnapshot::SpectrumArray& levelsDbOut) const noexcept;
+
+private:
+    static constexpr int kPoints = AnalysisSnapshot::kSpectrumPoints;
+    static constexpr float kStepDb = 0.5f;
+
+    // 当前这一格的累加写进 hop 和之前漏掉的格
+    void flushHop() noexcept;
+
+    const double durationSeconds;
+    const int numFrames;
+    std::vector<TimbreProfile> profiles;
+    std::vector<uint8_t> spectra;           // numFrames x kPoints，kSpectrumFloorDb 起 0.5 dB 一格 (整段没有谱时是底噪)
+
+    // 写的时候用
+    int currentHop = -1;
+    int lastWrittenHop = -1;
+    int lastSpectrumHop = -1;      // 谱单独记：开头几帧没有谱
+    std::array<double, 8> profileSums {};
+    int profileCount = 0;
+    std::array<float, kPoints> levelSums {};
+    int levelCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReferenceTrack)
+};
@@ -0,0 +1,890 @@
+#include "SpectralKernels.h"
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+ #define SPECTRAL_KERNELS_SSE 1
+ #if JUCE_MSVC
+  #define SPECTRAL_KERNELS_AVX2_TARGET
+  #define SPECTRAL_KERNELS_AVX2_NO_FMA_TARGET
+ #else
+  #define SPECTRAL_KERNELS_AVX2_TARGET __attribute__ ((target ("avx2,fma")))
+  // 不开 FMA：GCC 会把 mul + add 自动合成 FMA，结果就和标量版本差 1 ulp
+  #define SPECTRAL_KERNELS_AVX2_NO_FMA_TARGET __attribute__ ((target ("avx2")))
+ #endif
+#elif defined (__aarch64__) || defined (_M_ARM64)
+ // 只在 AArch64 上用 NEON：vdivq_f32 / vaddvq_f32 在 32 位 ARMv7 上没有，那边走标量
+ #include <arm_neon.h>
+ #define SPECTRAL_KERNELS_NEON 1
+#endif
+
+namespace SpectralKernels
+{
+namespace
+{
+    // ln(x) = e * ln2 + ln(m)，m in [1, 2)
+    // ln(m) = 2 atanh(t)，t = (m - 1) / (m + 1) in [0, 1/3]，展开到 t^9
+    constexpr float kLn2 = 0.693147180559945f;
+    constexpr float kC3 = 1.0f / 3.0f, kC5 = 1.0f / 5.0f, kC7 = 1.0f / 7.0f, kC9 = 1.0f / 9.0f;
+
+    inline float fastLogScalar (float x) noexcept
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+
+        const float e = (float) ((int32_t) (bits >> 23) - 127);
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+
+        const float t = (m - 1.0f) / (m + 1.0f);
+        const float t2 = t * t;
+        const float poly = 1.0f + t2 * (kC3 + t2 * (kC5 + t2 * (kC7 + t2 * kC9)));
+        return e * kLn2 + 2.0f * t * poly;
+    }
+
+    //==============================================================================
+    // 标量实现 (fallback，也用来处理向量版本的尾巴)
+    void deinterleaveScalar (const float* in, float* re, float* im, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            re[i] = in[2 * i];
+            im[i] = in[2 * i + 1];
+        }
+    }
+
+    void windowInterleaveScalar (const float* left, const float* right, const float* window, float* out, int num) noexcept
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            out[2 * i]     = left[i] * window[i];
+            out[2 * i + 1] = right[i] * window[i];
+        }
+    }
+
+    void magnitudeScalar (const float* in, float* mags, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+            mags[i] = std::sqrt (in[2 * i] * in[2 * i] + in[2 * i + 1] * in[2 * i + 1]);
+    }
+
+    void powerScalar (const float* in, float* power, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+            power[i] = in[2 * i] * in[2 * i] + in[2 * i + 1] * in[2 * i + 1];
+    }
+
+    float sumScalar (const float* data, int num) noexcept
+    {
+        float s = 0.0f;
+        for (int i = 0; i < num; ++i)
+            s += data[i];
+        return s;
+    }
+
+    float sumLogScalar (const float* data, float offset, int num) noexcept
+    {
+        float s = 0.0f;
+        for (int i = 0; i < num; ++i)
+            s += fastLogScalar (data[i] + offset);
+        return s;
+    }
+
+    float sumAbsDiffScalar (const float* a, const float* b, int num) noexcept
+    {
+        float s = 0.0f;
+        for (int i = 0; i < num; ++i)
+            s += std::abs (a[i] - b[i]);
+        return s;
+    }
+
+    float dotScalar (const float* a, const float* b, int num) noexcept
+    {
+        float s = 0.0f;
+        for (int i = 0; i < num; ++i)
+            s += a[i] * b[i];
+        return s;
+    }
+
+    void interpolate4Scalar (const float* coefficients, const float* input, int numTaps, int numFrames, float* output) noexcept
+    {
+        for (int n = 0; n < numFrames; ++n)
+        {
+            float acc[4] {};
+
+            for (int k = 0; k < numTaps; ++k)
+                for (int p = 0; p < 4; ++p)
+                    acc[p] += coefficients[4 * k + p] * input[n + k];
+
+            for (int p = 0; p < 4; ++p)
+                output[4 * n + p] = acc[p];
+        }
+    }
+
+    // 第 i 行 (SIMD 版本的尾部也用它)
+    inline float squaredDistanceAt (const float* const* columns, const float* point, int numDims, int i) noexcept
+    {
+        float s = 0.0f;
+        for (int d = 0; d < numDims; ++d)
+        {
+            const float diff = columns[d][i] - point[d];
+            s += diff * diff;
+        }
+        return s;
+    }
+
+    void squaredDistancesScalar (const float* const* columns, const float* point, int numDims, float* distances, int num) noexcept
+    {
+        for (int i = 0; i < num; ++i)
+            distances[i] = squaredDistanceAt (columns, point, numDims, i);
+    }
+
+    void biquadCascade4Scalar (const float* const* channels, const float* coefficients, float* state, double* squares, int num) noexcept
+    {
+        const float* a = coefficients;       // 第一级
+        const float* h = coefficients + 5;   // 第二级
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const float* input = channels[lane];
+            float s1a = state[lane], s1b = state[4 + lane];
+            float s2a = state[8 + lane], s2b = state[12 + lane];
+            double acc = 0.0;
+
+            for (int i = 0; i < num; ++i)
+            {
+                const float x = input[i];
+
+                const float y1 = a[0] * x + s1a;
+                s1a = a[1] * x - a[3] * y1 + s1b;
+                s1b = a[2] * x - a[4] * y1;
+
+                const float y2 = h[0] * y1 + s2a;
+                s2a = h[1] * y1 - h[3] * y2 + s2b;
+                s2b = h[2] * y1 - h[4] * y2;
+
+                acc += (double) (y2 * y2);
+            }
+
+            state[lane] = s1a; state[4 + lane] = s1b;
+            state[8 + lane] = s2a; state[12 + lane] = s2b;
+            squares[lane] = acc;
+        }
+    }
+
+   #if SPECTRAL_KERNELS_SSE
+    //==============================================================================
+    // SSE2 (x86-64 的基线)
+    inline float horizontalSum (__m128 v) noexcept
+    {
+        __m128 shuf = _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 3, 0, 1));
+        __m128 sums = _mm_add_ps (v, shuf);
+        shuf = _mm_movehl_ps (shuf, sums);
+        return _mm_cvtss_f32 (_mm_add_ss (sums, shuf));
+    }
+
+    inline __m128 fastLogSSE (__m128 x) noexcept
+    {
+        const __m128i bits = _mm_castps_si128 (x);
+        const __m128 e = _mm_cvtepi32_ps (_mm_sub_epi32 (_mm_srli_epi32 (bits, 23), _mm_set1_epi32 (127)));
+        const __m128 one = _mm_set1_ps (1.0f);
+        const __m128 m = _mm_or_ps (_mm_and_ps (x, _mm_castsi128_ps (_mm_set1_epi32 (0x007fffff))), one);
+
+        const __m128 t = _mm_div_ps (_mm_sub_ps (m, one), _mm_add_ps (m, one));
+        const __m128 t2 = _mm_mul_ps (t, t);
+        __m128 poly = _mm_add_ps (_mm_set1_ps (kC7), _mm_mul_ps (t2, _mm_set1_ps (kC9)));
+        poly = _mm_add_ps (_mm_set1_ps (kC5), _mm_mul_ps (t2, poly));
+        poly = _mm_add_ps (_mm_set1_ps (kC3), _mm_mul_ps (t2, poly));
+        poly = _mm_add_ps (one, _mm_mul_ps (t2, poly));
+
+        return _mm_add_ps (_mm_mul_ps (e, _mm_set1_ps (kLn2)),
+                           _mm_mul_ps (_mm_add_ps (t, t), poly));
+    }
+
+    void deinterleaveSSE (const float* in, float* re, float* im, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= numBins; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps (in + 2 * i);
+            const __m128 b = _mm_loadu_ps (in + 2 * i + 4);
+            _mm_storeu_ps (re + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+            _mm_storeu_ps (im + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+        }
+        deinterleaveScalar (in + 2 * i, re + i, im + i, numBins - i);
+    }
+
+    void windowInterleaveSSE (const float* left, const float* right, const float* window, float* out, int num) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+        {
+            const __m128 w = _mm_loadu_ps (window + i);
+            const __m128 l = _mm_mul_ps (_mm_loadu_ps (left + i), w);
+            const __m128 r = _mm_mul_ps (_mm_loadu_ps (right + i), w);
+            _mm_storeu_ps (out + 2 * i,     _mm_unpacklo_ps (l, r));
+            _mm_storeu_ps (out + 2 * i + 4, _mm_unpackhi_ps (l, r));
+        }
+        windowInterleaveScalar (left + i, right + i, window + i, out + 2 * i, num - i);
+    }
+
+    void powerSSE (const float* in, float* power, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= numBins; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps (in + 2 * i);
+            const __m128 b = _mm_loadu_ps (in + 2 * i + 4);
+            const __m128 re = _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+            const __m128 im = _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+            _mm_storeu_ps (power + i, _mm_add_ps (_mm_mul_ps (re, re), _mm_mul_ps (im, im)));
+        }
+        powerScalar (in + 2 * i, power + i, numBins - i);
+    }
+
+    void magnitudeSSE (const float* in, float* mags, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= numBins; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps (in + 2 * i);
+            const __m128 b = _mm_loadu_ps (in + 2 * i + 4);
+            const __m128 re = _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+            const __m128 im = _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+            _mm_storeu_ps (mags + i, _mm_sqrt_ps (_mm_add_ps (_mm_mul_ps (re, re), _mm_mul_ps (im, im))));
+        }
+        magnitudeScalar (in + 2 * i, mags + i, numBins - i);
+    }
+
+    float sumSSE (const float* data, int num) noexcept
+    {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= num; i += 8)
+        {
+            acc0 = _mm_add_ps (acc0, _mm_loadu_ps (data + i));
+            acc1 = _mm_add_ps (acc1, _mm_loadu_ps (data + i + 4));
+        }
+        return horizontalSum (_mm_add_ps (acc0, acc1)) + sumScalar (data + i, num - i);
+    }
+
+    float sumLogSSE (const float* data, float offset, int num) noexcept
+    {
+        const __m128 off = _mm_set1_ps (offset);
+        __m128 acc = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+            acc = _mm_add_ps (acc, fastLogSSE (_mm_add_ps (_mm_loadu_ps (data + i), off)));
+        return horizontalSum (acc) + sumLogScalar (data + i, offset, num - i);
+    }
+
+    float sumAbsDiffSSE (const float* a, const float* b, int num) noexcept
+    {
+        const __m128 absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+        __m128 acc = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+            acc = _mm_add_ps (acc, _mm_and_ps (absMask, _mm_sub_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i))));
+        return horizontalSum (acc) + sumAbsDiffScalar (a + i, b + i, num - i);
+    }
+
+    float dotSSE (const float* a, const float* b, int num) noexcept
+    {
+        __m128 acc = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+            acc = _mm_add_ps (acc, _mm_mul_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+        return horizontalSum (acc) + dotScalar (a + i, b + i, num - i);
+    }
+
+    // 4 个相位正好一个寄存器：每个 tap 一次乘加出 4 个输出，两帧交替跑，藏住加法延迟
+    // (AVX2 也用这个版本：8 宽要把两帧的输入拼进一个 ymm，省下的乘加抵不过拼接)
+    void interpolate4SSE (const float* coefficients, const float* input, int numTaps, int numFrames, float* output) noexcept
+    {
+        int n = 0;
+        for (; n + 2 <= numFrames; n += 2)
+        {
+            __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const __m128 c = _mm_loadu_ps (coefficients + 4 * k);
+                acc0 = _mm_add_ps (acc0, _mm_mul_ps (c, _mm_set1_ps (input[n + k])));
+                acc1 = _mm_add_ps (acc1, _mm_mul_ps (c, _mm_set1_ps (input[n + 1 + k])));
+            }
+
+            _mm_storeu_ps (output + 4 * n, acc0);
+            _mm_storeu_ps (output + 4 * n + 4, acc1);
+        }
+
+        interpolate4Scalar (coefficients, input + n, numTaps, numFrames - n, output + 4 * n);
+    }
+
+    void squaredDistancesSSE (const float* const* columns, const float* point, int numDims, float* distances, int num) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+        {
+            __m128 acc = _mm_setzero_ps();
+
+            for (int d = 0; d < numDims; ++d)
+            {
+                const __m128 diff = _mm_sub_ps (_mm_loadu_ps (columns[d] + i), _mm_set1_ps (point[d]));
+                acc = _mm_add_ps (acc, _mm_mul_ps (diff, diff));
+            }
+
+            _mm_storeu_ps (distances + i, acc);
+        }
+
+        for (; i < num; ++i)
+            distances[i] = squaredDistanceAt (columns, point, numDims, i);
+    }
+
+    // 运算顺序和标量版本一样 (不合成 FMA)，结果逐位相同；平方和每个 lane 用 double 累加
+    // (AVX2 也用这个版本：8 个声道的布局很少见，立体声 / 5.1 一个 xmm 就装得下)
+    void biquadCascade4SSE (const float* const* channels, const float* coefficients, float* state, double* squares, int num) noexcept
+    {
+        const __m128 ab0 = _mm_set1_ps (coefficients[0]), ab1 = _mm_set1_ps (coefficients[1]), ab2 = _mm_set1_ps (coefficients[2]);
+        const __m128 aa1 = _mm_set1_ps (coefficients[3]), aa2 = _mm_set1_ps (coefficients[4]);
+        const __m128 hb0 = _mm_set1_ps (coefficients[5]), hb1 = _mm_set1_ps (coefficients[6]), hb2 = _mm_set1_ps (coefficients[7]);
+        const __m128 ha1 = _mm_set1_ps (coefficients[8]), ha2 = _mm_set1_ps (coefficients[9]);
+
+        __m128 s1a = _mm_loadu_ps (state), s1b = _mm_loadu_ps (state + 4);
+        __m128 s2a = _mm_loadu_ps (state + 8), s2b = _mm_loadu_ps (state + 12);
+        __m128d accLo = _mm_setzero_pd(), accHi = _mm_setzero_pd();
+
+        // x 是同一时刻 4 个声道的 sample
+        auto step = [&] (__m128 x)
+        {
+            const __m128 y1 = _mm_add_ps (_mm_mul_ps (ab0, x), s1a);
+            s1a = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (ab1, x), _mm_mul_ps (aa1, y1)), s1b);
+            s1b = _mm_sub_ps (_mm_mul_ps (ab2, x), _mm_mul_ps (aa2, y1));
+
+            const __m128 y2 = _mm_add_ps (_mm_mul_ps (hb0, y1), s2a);
+            s2a = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (hb1, y1), _mm_mul_ps (ha1, y2)), s2b);
+            s2b = _mm_sub_ps (_mm_mul_ps (hb2, y1), _mm_mul_ps (ha2, y2));
+
+            const __m128 sq = _mm_mul_ps (y2, y2);
+            accLo = _mm_add_pd (accLo, _mm_cvtps_pd (sq));
+            accHi = _mm_add_pd (accHi, _mm_cvtps_pd (_mm_movehl_ps (sq, sq)));
+        };
+
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+        {
+            // 每个声道读 4 个 sample，转置成 4 个时刻
+            __m128 x0 = _mm_loadu_ps (channels[0] + i), x1 = _mm_loadu_ps (channels[1] + i);
+            __m128 x2 = _mm_loadu_ps (channels[2] + i), x3 = _mm_loadu_ps (channels[3] + i);
+            _MM_TRANSPOSE4_PS (x0, x1, x2, x3);
+
+            step (x0);
+            step (x1);
+            step (x2);
+            step (x3);
+        }
+
+        for (; i < num; ++i)
+            step (_mm_setr_ps (channels[0][i], channels[1][i], channels[2][i], channels[3][i]));
+
+        _mm_storeu_ps (state, s1a);
+        _mm_storeu_ps (state + 4, s1b);
+        _mm_storeu_ps (state + 8, s2a);
+        _mm_storeu_ps (state + 12, s2b);
+        _mm_storeu_pd (squares, accLo);
+        _mm_storeu_pd (squares + 2, accHi);
+    }
+
+    //==============================================================================
+    // AVX2 + FMA (运行时检测到才用)
+    // 尾部交给 SSE 版本之前必须 vzeroupper：GCC 对 target 属性的函数不一定自动插
+    // (GCC 12 -O2 下 sum / deinterleave / power / sumAbsDiff 都是 ymm 脏着直接 call / jmp 过去)，
+    // 之后非 VEX 的 SSE 指令每次调用都要付 AVX/SSE 切换的代价
+    SPECTRAL_KERNELS_AVX2_TARGET
+    inline float horizontalSumAVX (__m256 v) noexcept
+    {
+        return horizontalSum (_mm_add_ps (_mm256_castps256_ps128 (v), _mm256_extractf128_ps (v, 1)));
+    }
+
+    // 8 个复数 bin -> re / im (顺序正确)
+    SPECTRAL_KERNELS_AVX2_NO_FMA_TARGET
+    inline void splitAVX (const float* in, __m256& re, __m256& im) noexcept
+    {
+        const __m256 a = _mm256_loadu_ps (in);
+        const __m256 b = _mm256_loadu_ps (in + 8);
+        // lane 内交错取出后是 [0 1 4 5 | 2 3 6 7]，再按 64-bit 重排
+        re = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (_mm256_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0))),
+                                                      _MM_SHUFFLE (3, 1, 2, 0)));
+        im = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (_mm256_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1))),
+                                                      _MM_SHUFFLE (3, 1, 2, 0)));
+    }
+
+    SPECTRAL_KERNELS_AVX2_TARGET
+    inline __m256 fastLogAVX (__m256 x) noexcept
+    {
+        const __m256i bits = _mm256_castps_si256 (x);
+        const __m256 e = _mm256_cvtepi32_ps (_mm256_sub_epi32 (_mm256_srli_epi32 (bits, 23), _mm256_set1_epi32 (127)));
+        const __m256 one = _mm256_set1_ps (1.0f);
+        const __m256 m = _mm256_or_ps (_mm256_and_ps (x, _mm256_castsi256_ps (_mm256_set1_epi32 (0x007fffff))), one);
+
+        const __m256 t = _mm256_div_ps (_mm256_sub_ps (m, one), _mm256_add_ps (m, one));
+        const __m256 t2 = _mm256_mul_ps (t, t);
+        __m256 poly = _mm256_fmadd_ps (t2, _mm256_set1_ps (kC9), _mm256_set1_ps (kC7));
+        poly = _mm256_fmadd_ps (t2, poly, _mm256_set1_ps (kC5));
+        poly = _mm256_fmadd_ps (t2, poly, _mm256_set1_ps (kC3));
+        poly = _mm256_fmadd_ps (t2, poly, one);
+
+        return _mm256_fmadd_ps (e, _mm256_set1_ps (kLn2), _mm256_mul_ps (_mm256_add_ps (t, t), poly));
+    }
+
+    SPECTRAL_KERNELS_AVX2_TARGET
+    void deinterleaveAVX2 (const float* in, float* re, float* im, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 8 <= numBins; i += 8)
+        {
+            __m256 r, m;
+            splitAVX (in + 2 * i, r, m);
+            _mm256_storeu_ps (re + i, r);
+            _mm256_storeu_ps (im + i, m);
+        }
+        _mm256_zeroupper();
+        deinterleaveSSE (in + 2 * i, re + i, im + i, numBins - i);
+    }
+
+    SPECTRAL_KERNELS_AVX2_TARGET
+    void windowInterleaveAVX2 (const float* left, const float* right, const float* window, float* out, int num) noexcept
+    {
+        int i = 0;
+        for (; i + 8 <= num; i += 8)
+        {
+            const __m256 w = _mm256_loadu_ps (window + i);
+            const __m256 l = _mm256_mul_ps (_mm256_loadu_ps (left + i), w);
+            const __m256 r = _mm256_mul_ps (_mm256_loadu_ps (right + i), w);
+            // unpack 在 128-bit lane 内交错：[l0 r0 l1 r1 | l4 r4 l5 r5] 和 [l2 r2 l3 r3 | l6 r6 l7 r7]，再按 lane 拼回顺序
+            const __m256 lo = _mm256_unpacklo_ps (l, r);
+            const __m256 hi = _mm256_unpackhi_ps (l, r);
+            _mm256_storeu_ps (out + 2 * i,     _mm256_permute2f128_ps (lo, hi, 0x20));
+            _mm256_storeu_ps (out + 2 * i + 8, _mm256_permute2f128_ps (lo, hi, 0x31));
+        }
+        _mm256_zeroupper();
+        windowInterleaveSSE (left + i, right + i, window + i, out + 2 * i, num - i);
+    }
+
+    SPECTRAL_KERNELS_AVX2_NO_FMA_TARGET
+    void powerAVX2 (const float* in, float* power, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 8 <= numBins; i += 8)
+        {
+            __m256 re, im;
+            splitAVX (in + 2 * i, re, im);
+            // 不用 FMA：和标量 / SSE 版本逐位一样
+            _mm256_storeu_ps (power + i, _mm256_add_ps (_mm256_mul_ps (re, re), _mm256_mul_ps (im, im)));
+        }
+        _mm256_zeroupper();
+        powerSSE (in + 2 * i, power + i, numBins - i);
+    }
+
+    SPECTRAL_KERNELS_AVX2_NO_FMA_TARGET
+    void magnitudeAVX2 (const float* in, float* mags, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 8 <= numBins; i += 8)
+        {
+            __m256 re, im;
+            splitAVX (in + 2 * i, re, im);
+            _mm256_storeu_ps (mags + i, _mm256_sqrt_ps (_mm256_add_ps (_mm256_mul_ps (re, re), _mm256_mul_ps (im, im))));
+        }
+        _mm256_zeroupper();
+        magnitudeSSE (in + 2 * i, mags + i, numBins - i);
+    }
+
+    SPECTRAL_KERNELS_AVX2_TARGET
+    float sumAVX2 (const float* data, int num) noexcept
+    {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 16 <= num; i += 16)
+        {
+            acc0 = _mm256_add_ps (acc0, _mm256_loadu_ps (data + i));
+            acc1 = _mm256_add_ps (acc1, _mm256_loadu_ps (data + i + 8));
+        }
+        const float head = horizontalSumAVX (_mm256_add_ps (acc0, acc1));
+        _mm256_zeroupper();
+        return head + sumSSE (data + i, num - i);
+    }
+
+    SPECTRAL_KERNELS_AVX2_TARGET
+    float sumLogAVX2 (const float* data, float offset, int num) noexcept
+    {
+        const __m256 off = _mm256_set1_ps (offset);
+        __m256 acc = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= num; i += 8)
+            acc = _mm256_add_ps (acc, fastLogAVX (_mm256_add_ps (_mm256_loadu_ps (data + i), off)));
+        const float head = horizontalSumAVX (acc);
+        _mm256_zeroupper();
+        return head + sumLogSSE (data + i, offset, num - i);
+    }
+
+    SPECTRAL_KERNELS_AVX2_TARGET
+    float sumAbsDiffAVX2 (const float* a, const float* b, int num) noexcept
+    {
+        const __m256 absMask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+        __m256 acc = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= num; i += 8)
+            acc = _mm256_add_ps (acc, _mm256_and_ps (absMask, _mm256_sub_ps (_mm256_loadu_ps (a + i), _mm256_loadu_ps (b + i))));
+        const float head = horizontalSumAVX (acc);
+        _mm256_zeroupper();
+        return head + sumAbsDiffSSE (a + i, b + i, num - i);
+    }
+
+    SPECTRAL_KERNELS_AVX2_TARGET
+    float dotAVX2 (const float* a, const float* b, int num) noexcept
+    {
+        __m256 acc = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= num; i += 8)
+            acc = _mm256_fmadd_ps (_mm256_loadu_ps (a + i), _mm256_loadu_ps (b + i), acc);
+        const float head = horizontalSumAVX (acc);
+        _mm256_zeroupper();
+        return head + dotSSE (a + i, b + i, num - i);
+    }
+
+    // 一次 16 行 (两个累加器)，每列的 16 个值连续读
+    SPECTRAL_KERNELS_AVX2_TARGET
+    void squaredDistancesAVX2 (const float* const* columns, const float* point, int numDims, float* distances, int num) noexcept
+    {
+        int i = 0;
+        for (; i + 16 <= num; i += 16)
+        {
+            __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+
+            for (int d = 0; d < numDims; ++d)
+            {
+                const __m256 p = _mm256_set1_ps (point[d]);
+                const __m256 diff0 = _mm256_sub_ps (_mm256_loadu_ps (columns[d] + i), p);
+                const __m256 diff1 = _mm256_sub_ps (_mm256_loadu_ps (columns[d] + i + 8), p);
+                acc0 = _mm256_fmadd_ps (diff0, diff0, acc0);
+                acc1 = _mm256_fmadd_ps (diff1, diff1, acc1);
+            }
+
+            _mm256_storeu_ps (distances + i, acc0);
+            _mm256_storeu_ps (distances + i + 8, acc1);
+        }
+        _mm256_zeroupper();
+
+        for (; i < num; ++i)
+            distances[i] = squaredDistanceAt (columns, point, numDims, i);
+    }
+   #endif
+
+   #if SPECTRAL_KERNELS_NEON
+    //==============================================================================
+    // NEON (arm64 的基线)
+    inline float32x4_t fastLogNEON (float32x4_t x) noexcept
+    {
+        const uint32x4_t bits = vreinterpretq_u32_f32 (x);
+        const float32x4_t e = vcvtq_f32_s32 (vsubq_s32 (vreinterpretq_s32_u32 (vshrq_n_u32 (bits, 23)), vdupq_n_s32 (127)));
+        const float32x4_t one = vdupq_n_f32 (1.0f);
+        const float32x4_t m = vreinterpretq_f32_u32 (vorrq_u32 (vandq_u32 (bits, vdupq_n_u32 (0x007fffffu)), vdupq_n_u32 (0x3f800000u)));
+
+        const float32x4_t t = vdivq_f32 (vsubq_f32 (m, one), vaddq_f32 (m, one));
+        const float32x4_t t2 = vmulq_f32 (t, t);
+        float32x4_t poly = vmlaq_f32 (vdupq_n_f32 (kC7), t2, vdupq_n_f32 (kC9));
+        poly = vmlaq_f32 (vdupq_n_f32 (kC5), t2, poly);
+        poly = vmlaq_f32 (vdupq_n_f32 (kC3), t2, poly);
+        poly = vmlaq_f32 (one, t2, poly);
+
+        return vmlaq_f32 (vmulq_f32 (vaddq_f32 (t, t), poly), e, vdupq_n_f32 (kLn2));
+    }
+
+    void deinterleaveNEON (const float* in, float* re, float* im, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= numBins; i += 4)
+        {
+            const float32x4x2_t v = vld2q_f32 (in + 2 * i);
+            vst1q_f32 (re + i, v.val[0]);
+            vst1q_f32 (im + i, v.val[1]);
+        }
+        deinterleaveScalar (in + 2 * i, re + i, im + i, numBins - i);
+    }
+
+    void windowInterleaveNEON (const float* left, const float* right, const float* window, float* out, int num) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+        {
+            const float32x4_t w = vld1q_f32 (window + i);
+            float32x4x2_t v;
+            v.val[0] = vmulq_f32 (vld1q_f32 (left + i), w);
+            v.val[1] = vmulq_f32 (vld1q_f32 (right + i), w);
+            vst2q_f32 (out + 2 * i, v);
+        }
+        windowInterleaveScalar (left + i, right + i, window + i, out + 2 * i, num - i);
+    }
+
+    void powerNEON (const float* in, float* power, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= numBins; i += 4)
+        {
+            const float32x4x2_t v = vld2q_f32 (in + 2 * i);
+            vst1q_f32 (power + i, vmlaq_f32 (vmulq_f32 (v.val[0], v.val[0]), v.val[1], v.val[1]));
+        }
+        powerScalar (in + 2 * i, power + i, numBins - i);
+    }
+
+    void magnitudeNEON (const float* in, float* mags, int numBins) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= numBins; i += 4)
+        {
+            const float32x4x2_t v = vld2q_f32 (in + 2 * i);
+            vst1q_f32 (mags + i, vsqrtq_f32 (vmlaq_f32 (vmulq_f32 (v.val[0], v.val[0]), v.val[1], v.val[1])));
+        }
+        magnitudeScalar (in + 2 * i, mags + i, numBins - i);
+    }
+
+    float sumNEON (const float* data, int num) noexcept
+    {
+        float32x4_t acc = vdupq_n_f32 (0.0f);
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+            acc = vaddq_f32 (acc, vld1q_f32 (data + i));
+        return vaddvq_f32 (acc) + sumScalar (data + i, num - i);
+    }
+
+    float sumLogNEON (const float* data, float offset, int num) noexcept
+    {
+        const float32x4_t off = vdupq_n_f32 (offset);
+        float32x4_t acc = vdupq_n_f32 (0.0f);
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+            acc = vaddq_f32 (acc, fastLogNEON (vaddq_f32 (vld1q_f32 (data + i), off)));
+        return vaddvq_f32 (acc) + sumLogScalar (data + i, offset, num - i);
+    }
+
+    float sumAbsDiffNEON (const float* a, const float* b, int num) noexcept
+    {
+        float32x4_t acc = vdupq_n_f32 (0.0f);
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+            acc = vaddq_f32 (acc, vabdq_f32 (vld1q_f32 (a + i), vld1q_f32 (b + i)));
+        return vaddvq_f32 (acc) + sumAbsDiffScalar (a + i, b + i, num - i);
+    }
+
+    float dotNEON (const float* a, const float* b, int num) noexcept
+    {
+        float32x4_t acc = vdupq_n_f32 (0.0f);
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+            acc = vmlaq_f32 (acc, vld1q_f32 (a + i), vld1q_f32 (b + i));
+        return vaddvq_f32 (acc) + dotScalar (a + i, b + i, num - i);
+    }
+
+    void interpolate4NEON (const float* coefficients, const float* input, int numTaps, int numFrames, float* output) noexcept
+    {
+        int n = 0;
+        for (; n + 2 <= numFrames; n += 2)
+        {
+            float32x4_t acc0 = vdupq_n_f32 (0.0f), acc1 = vdupq_n_f32 (0.0f);
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const float32x4_t c = vld1q_f32 (coefficients + 4 * k);
+                acc0 = vmlaq_n_f32 (acc0, c, input[n + k]);
+                acc1 = vmlaq_n_f32 (acc1, c, input[n + 1 + k]);
+            }
+
+            vst1q_f32 (output + 4 * n, acc0);
+            vst1q_f32 (output + 4 * n + 4, acc1);
+        }
+
+        interpolate4Scalar (coefficients, input + n, numTaps, numFrames - n, output + 4 * n);
+    }
+
+    void squaredDistancesNEON (const float* const* columns, const float* point, int numDims, float* distances, int num) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= num; i += 4)
+        {
+            float32x4_t acc = vdupq_n_f32 (0.0f);
+
+            for (int d = 0; d < numDims; ++d)
+            {
+                const float32x4_t diff = vsubq_f32 (vld1q_f32 (columns[d] + i), vdupq_n_f32 (point[d]));
+                acc = vmlaq_f32 (acc, diff, diff);
+            }
+
+            vst1q_f32 (distances + i, acc);
+        }
+
+        for (; i < num; ++i)
+            distances[i] = squaredDistanceAt (columns, point, numDims, i);
+    }
+
+    // 同一时刻 4 个声道直接拼成一个向量：递推本身的延迟远大于这 4 次读
+    void biquadCascade4NEON (const float* const* channels, const float* coefficients, float* state, double* squares, int num) noexcept
+    {
+        const float32x4_t ab0 = vdupq_n_f32 (coefficients[0]), ab1 = vdupq_n_f32 (coefficients[1]), ab2 = vdupq_n_f32 (coefficients[2]);
+        const float32x4_t aa1 = vdupq_n_f32 (coefficients[3]), aa2 = vdupq_n_f32 (coefficients[4]);
+        const float32x4_t hb0 = vdupq_n_f32 (coefficients[5]), hb1 = vdupq_n_f32 (coefficients[6]), hb2 = vdupq_n_f32 (coefficients[7]);
+        const float32x4_t ha1 = vdupq_n_f32 (coefficients[8]), ha2 = vdupq_n_f32 (coefficients[9]);
+
+        float32x4_t s1a = vld1q_f32 (state), s1b = vld1q_f32 (state + 4);
+        float32x4_t s2a = vld1q_f32 (state + 8), s2b = vld1q_f32 (state + 12);
+        float64x2_t accLo = vdupq_n_f64 (0.0), accHi = vdupq_n_f64 (0.0);
+
+        for (int i = 0; i < num; ++i)
+        {
+            const float frame[4] = { channels[0][i], channels[1][i], channels[2][i], channels[3][i] };
+            const float32x4_t x = vld1q_f32 (frame);
+
+            const float32x4_t y1 = vaddq_f32 (vmulq_f32 (ab0, x), s1a);
+            s1a = vaddq_f32 (vsubq_f32 (vmulq_f32 (ab1, x), vmulq_f32 (aa1, y1)), s1b);
+            s1b = vsubq_f32 (vmulq_f32 (ab2, x), vmulq_f32 (aa2, y1));
+
+            const float32x4_t y2 = vaddq_f32 (vmulq_f32 (hb0, y1), s2a);
+            s2a = vaddq_f32 (vsubq_f32 (vmulq_f32 (hb1, y1), vmulq_f32 (ha1, y2)), s2b);
+            s2b = vsubq_f32 (vmulq_f32 (hb2, y1), vmulq_f32 (ha2, y2));
+
+            const float32x4_t sq = vmulq_f32 (y2, y2);
+            accLo = vaddq_f64 (accLo, vcvt_f64_f32 (vget_low_f32 (sq)));
+            accHi = vaddq_f64 (accHi, vcvt_high_f64_f32 (sq));
+        }
+
+        vst1q_f32 (state, s1a);
+        vst1q_f32 (state + 4, s1b);
+        vst1q_f32 (state + 8, s2a);
+        vst1q_f32 (state + 12, s2b);
+        vst1q_f64 (squares, accLo);
+        vst1q_f64 (squares + 2, accHi);
+    }
+   #endif
+
+    //==============================================================================
+    struct AvailableTables
+    {
+        std::array<KernelTable, 3> tables;
+        int num = 0;
+    };
+
+    // 本机能跑的每一套，从慢到快：标量总在第一个
+    AvailableTables findAvailableTables() noexcept
+    {
+        AvailableTables available;
+        auto& t = available.tables;
+        t[(size_t) available.num++] = { "Scalar", deinterleaveScalar, windowInterleaveScalar, magnitudeScalar, powerScalar, sumScalar, sumLogScalar, sumAbsDiffScalar, dotScalar, interpolate4Scalar, squaredDistancesScalar, biquadCascade4Scalar };
+
+       #if SPECTRAL_KERNELS_SSE
+        t[(size_t) available.num++] = { "SSE2", deinterleaveSSE, windowInterleaveSSE, magnitudeSSE, powerSSE, sumSSE, sumLogSSE, sumAbsDiffSSE, dotSSE, interpolate4SSE, squaredDistancesSSE, biquadCascade4SSE };
+
+        if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+            t[(size_t) available.num++] = { "AVX2", deinterleaveAVX2, windowInterleaveAVX2, magnitudeAVX2, powerAVX2, sumAVX2, sumLogAVX2, sumAbsDiffAVX2, dotAVX2, interpolate4SSE, squaredDistancesAVX2, biquadCascade4SSE };
+       #elif SPECTRAL_KERNELS_NEON
+        t[(size_t) available.num++] = { "NEON", deinterleaveNEON, windowInterleaveNEON, magnitudeNEON, powerNEON, sumNEON, sumLogNEON, sumAbsDiffNEON, dotNEON, interpolate4NEON, squaredDistancesNEON, biquadCascade4NEON };
+       #endif
+
+        return available;
+    }
+
+    // 加载时选一次 (最快的一套)，之后音频线程只读函数指针
+    const AvailableTables available = findAvailableTables();
+    const KernelTable kernels = available.tables[(size_t) available.num - 1];
+}
+
+void deinterleave (const float* interleaved, float* re, float* im, int numBins) noexcept
+{
+    kernels.deinterleave (interleaved, re, im, numBins);
+}
+
+void windowInterleave (const float* left, const float* right, const float* window, float* out, int num) noexcept
+{
+    kernels.windowInterleave (left, right, window, out, num);
+}
+
+void magnitude (const float* interleaved, float* mags, int numBins) noexcept
+{
+    kernels.magnitude (interleaved, mags, numBins);
+}
+
+void power (const float* interleaved, float* power, int numBins) noexcept
+{
+    kernels.power (interleaved, power, numBins);
+}
+
+float sum (const float* data, int num) noexcept
+{
+    return kernels.sum (data, num);
+}
+
+float sumLog (const float* data, float offset, int num) noexcept
+{
+    return kernels.sumLog (data, offset, num);
+}
+
+float sumAbsDiff (const float* a, const float* b, int num) noexcept
+{
+    return kernels.sumAbsDiff (a, b, num);
+}
+
+float dot (const float* a, const float* b, int num) noexcept
+{
+    return kernels.dot (a, b, num);
+}
+
+void interpolate4 (const float* coefficients, const float* input, int numTaps, int numFrames, float* output) noexcept
+{
+    kernels.interpolate4 (coefficients, input, numTaps, numFrames, output);
+}
+
+void squaredDistances (const float* const* columns, const float* point, int numDims, float* distances, int num) noexcept
+{
+    kernels.squaredDistances (columns, point, numDims, distances, num);
+}
+
+void biquadCascade4 (const float* const* channels, const float* coefficients, float* state, double* squares, int num) noexcept
+{
+    kernels.biquadCascade4 (channels, coefficients, state, squares, num);
+}
+
+void prefixSum (const float* data, double* cumulative, int num) noexcept
+{
+    // 前缀和本身是串行依赖，标量循环就够了 (每帧 ~1k 次加法)
+    double running = 0.0;
+    cumulative[0] = 0.0;
+
+    for (int i = 0; i < num; ++i)
+    {
+        running += (double) data[i];
+        cumulative[i + 1] = running;
+    }
+}
+
+const char* getActiveInstructionSet() noexcept
+{
+    return kernels.name;
+}
+
+int getNumKernelTables() noexcept
+{
+    return available.num;
+}
+
+const KernelTable& getKernelTable (int index) noexcept
+{
+    jassert (juce::isPositiveAndBelow (index, available.num));
+    return available.tables[(size_t) index];
+}
+}
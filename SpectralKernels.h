@@ -0,0 +1,76 @@
+#pragma once
+
+// 分析热循环共用的向量化 kernel
+// SSE2 / AVX2 (运行时检测) / NEON (AArch64)，都不支持时退回标量实现。
+// 所有 "interleaved" 输入都是 JUCE performRealOnlyForwardTransform 的 re/im 交错格式，
+// numBins 指复数 bin 的个数。
+namespace SpectralKernels
+{
+    // interleaved -> 分开的 re[] / im[]
+    void deinterleave (const float* interleaved, float* re, float* im, int numBins) noexcept;
+
+    // 两路乘同一个窗后交错成复数：out[2 i] = left[i] * window[i]，out[2 i + 1] = right[i] * window[i]
+    void windowInterleave (const float* left, const float* right, const float* window, float* out, int num) noexcept;
+
+    // |X| = sqrt (re^2 + im^2)
+    void magnitude (const float* interleaved, float* mags, int numBins) noexcept;
+
+    // |X|^2
+    void power (const float* interleaved, float* power, int numBins) noexcept;
+
+    // sum (data[i])
+    float sum (const float* data, int num) noexcept;
+
+    // sum (ln (data[i] + offset))，用快速 log 近似 (绝对误差 < 2e-6 / 项)
+    // data[i] + offset 必须 > 0 且不是 denormal
+    float sumLog (const float* data, float offset, int num) noexcept;
+
+    // sum (|a[i] - b[i]|)
+    float sumAbsDiff (const float* a, const float* b, int num) noexcept;
+
+    // sum (a[i] * b[i])
+    float dot (const float* a, const float* b, int num) noexcept;
+
+    // 4 相多相插值 (4x 过采样)：output[4 n + p] = sum_k coefficients[4 k + p] * input[n + k]
+    // coefficients 按 tap 排 (每个 tap 的 4 个相位连续)，input 至少 numFrames + numTaps - 1 个
+    void interpolate4 (const float* coefficients, const float* input, int numTaps, int numFrames, float* output) noexcept;
+
+    // SoA 表 (每维一列) 里每一行到 point 的欧氏距离平方：distances[i] = sum_d (columns[d][i] - point[d])^2
+    // 一次扫完所有维，每列只读一遍
+    void squaredDistances (const float* const* columns, const float* point, int numDims, float* distances, int num) noexcept;
+
+    // 4 个声道并排跑两级 TDF-II biquad 串联，每个声道一个 lane (递推在时间上是串行的，只能在声道间并行)：
+    // channels 是 4 个输入 (凑不满时可以重复指向同一个声道，多出来的 lane 结果不用就是)，
+    // coefficients 是两级各 {b0, b1, b2, a1, a2}，state 是 16 个 float：第一级 s1[4]、s2[4]，第二级 s1[4]、s2[4]，
+    // squares[lane] = 这一路输出的平方和 (double 累加)
+    void biquadCascade4 (const float* const* channels, const float* coefficients, float* state, double* squares, int num) noexcept;
+
+    // cumulative[0] = 0, cumulative[i + 1] = cumulative[i] + data[i]
+    // 之后任意区间 [lo, hi] 的和 = cumulative[hi + 1] - cumulative[lo]，O(1)
+    // 用 double 累加，避免高频小能量在大的总和里被抵消掉
+    void prefixSum (const float* data, double* cumulative, int num) noexcept;
+
+    // 当前选中的指令集 ("AVX2", "SSE2", "NEON", "Scalar")
+    const char* getActiveInstructionSet() noexcept;
+
+    // 一套实现的函数表 (参数和上面同名函数一样)
+    struct KernelTable
+    {
+        const char* name;
+        void (*deinterleave) (const float*, float*, float*, int) noexcept;
+        void (*windowInterleave) (const float*, const float*, const float*, float*, int) noexcept;
+        void (*magnitude) (const float*, float*, int) noexcept;
+        void (*power) (const float*, float*, int) noexcept;
+        float (*sum) (const float*, int) noexcept;
+        float (*sumLog) (const float*, float, int) noexcept;
+        float (*sumAbsDiff) (const float*, const float*, int) noexcept;
+        float (*dot) (const float*, const float*, int) noexcept;
+        void (*interpolate4) (const float*, const float*, int, int, float*) noexcept;
+        void (*squaredDistances) (const float* const*, const float*, int, float*, int) noexcept;
+        void (*biquadCascade4) (const float* const*, const float*, float*, double*, int) noexcept;
+    };
+
+    // 测试 / benchmark 用：本机能跑的每一套，下标 0 是标量，最后一个是上面的函数实际用的
+    int getNumKernelTables() noexcept;
+    const KernelTable& getKernelTable (int index) noexcept;
+}
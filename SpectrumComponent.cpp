@@ -3,26 +3,52 @@
 
 SpectrumComponent::SpectrumComponent()
 {
-    currentSpectrum.fill (0.0f);
-    targetSpectrum.fill (0.0f);
+    currentSpectrum.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    currentPeaks.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    targetSpectrum.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    targetLow.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    targetMedian.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    targetHigh.fill (AnalysisSnapshot::kSpectrumFloorDb);
+    
+    // 显示点的频率是固定的，paint 时只查表
+    for (int i = 0; i < AnalysisSnapshot::kSpectrumPoints; ++i)
+        pointPositions[(size_t) i] = frequencyToX (AnalysisSnapshot::getSpectrumPointHz (i), 1.0f);
 }
 
-void SpectrumComponent::setSpectrumData (const std::array<float, 512>& data)
+void SpectrumComponent::setSpectrumData (const AnalysisSnapshot::SpectrumArray& levels, const AnalysisSnapshot::SpectrumArray& peaks)
 {
-    currentSpectrum = data;
+    currentSpectrum = levels;
+    currentPeaks = peaks;
     repaint();
 }
 
-void SpectrumComponent::setTargetSpectrumData (const std::array<float, 512>& data)
+void SpectrumComponent::setTargetSpectrumData (const AnalysisSnapshot::SpectrumArray& data)
 {
     targetSpectrum = data;
     hasTarget = true;
     repaint();
 }
 
+void SpectrumComponent::setTargetPercentiles (const AnalysisSnapshot::SpectrumArray& low, const AnalysisSnapshot::SpectrumArray& median,
+                                              const AnalysisSnapshot::SpectrumArray& high)
+{
+    targetLow = low;
+    targetMedian = median;
+    targetHigh = high;
+    
+    if (showPercentiles)
+        repaint();
+}
+
+void SpectrumComponent::setShowPercentiles (bool show)
+{
+    showPercentiles = show;
+    repaint();
+}
+
 void SpectrumComponent::clearTarget()
 {
-    targetSpectrum.fill (0.0f);
+    targetSpectrum.fill (AnalysisSnapshot::kSpectrumFloorDb);
     hasTarget = false;
     repaint();
 }
@@ -33,6 +59,23 @@ void SpectrumComponent::setShowTarget (bool show)
     repaint();
 }
 
+void SpectrumComponent::setBandData (const AnalysisSnapshot::BandArray& current, const AnalysisSnapshot::BandArray& target,
+                                     const AnalysisSnapshot::BandArray& centreHz)
+{
+    currentBands = current;
+    targetBands = target;
+    bandCentreHz = centreHz;
+    
+    if (showBands)
+        repaint();
+}
+
+void SpectrumComponent::setShowBands (bool show)
+{
+    showBands = show;
+    repaint();
+}
+
 void SpectrumComponent::paint (juce::Graphics& g)
 {
     auto bounds = getLocalBounds().toFloat();
@@ -51,12 +94,25 @@ void SpectrumComponent::paint (juce::Graphics& g)
     // 绘制 Target 频谱 (如果有)
     if (hasTarget && showTarget)
     {
+        if (showPercentiles)
+            drawPercentiles (g, graphBounds, targetColour);
+        
         drawSpectrum (g, graphBounds, targetSpectrum, targetColour, true);
     }
     
-    // 绘制 Current 频谱
+    // 绘制 Current 频谱 (peak-hold 画在下面)
+    drawPeaks (g, graphBounds, currentPeaks, currentColour);
     drawSpectrum (g, graphBounds, currentSpectrum, currentColour, false);
     
+    // ERB 包络
+    if (showBands)
+    {
+        if (hasTarget && showTarget)
+            drawBands (g, graphBounds, targetBands, targetColour.brighter (0.4f));
+        
+        drawBands (g, graphBounds, currentBands, currentColour.brighter (0.4f));
+    }
+    
     // 绘制频率标签
     drawFrequencyLabels (g, graphBounds);
     
@@ -115,47 +171,32 @@ void SpectrumComponent::drawGrid (juce::Graphics& g, juce::Rectangle<float> boun
     g.drawRect (bounds, 1.0f);
 }
 
-void SpectrumComponent::drawSpectrum (juce::Graphics& g, juce::Rectangle<float> bounds,
-                                       const std::array<float, 512>& data, juce::Colour colour, bool filled)
+juce::Path SpectrumComponent::createSpectrumPath (juce::Rectangle<float> bounds, const AnalysisSnapshot::SpectrumArray& data) const
 {
+    // 点已经是 log 间隔的 dB，X 查表，Y 只做一次线性映射
     juce::Path path;
     
-    const float minFreq = 20.0f;
-    const float maxFreq = 20000.0f;
-    const float sampleRate = 44100.0f;
-    const int numBins = 512;
-    
-    bool pathStarted = false;
-    
-    for (int i = 1; i < numBins; ++i)
+    for (size_t i = 0; i < data.size(); ++i)
     {
-        // 计算这个 bin 对应的频率
-        float freq = (float) i * sampleRate / (float) (numBins * 2);
-        
-        if (freq < minFreq || freq > maxFreq)
-            continue;
-        
-        // X 坐标 (对数刻度)
-        float x = bounds.getX() + frequencyToX (freq, bounds.getWidth());
-        
-        // Y 坐标 (分贝刻度)
-        float magnitude = data[(size_t) i];
-        float db = magnitude > 0.0f ? 20.0f * std::log10 (magnitude) : -60.0f;
-        db = juce::jlimit (-60.0f, 0.0f, db);
+        float x = bounds.getX() + pointPositions[i] * bounds.getWidth();
+        float db = juce::jlimit (-60.0f, 0.0f, data[i]);
         float y = juce::jmap (db, 0.0f, -60.0f, bounds.getY(), bounds.getBottom());
         
-        if (!pathStarted)
-        {
+        if (i == 0)
             path.startNewSubPath (x, y);
-            pathStarted = true;
-        }
         else
-        {
             path.lineTo (x, y);
-        }
     }
     
-    if (filled && pathStarted)
+    return path;
+}
+
+void SpectrumComponent::drawSpectrum (juce::Graphics& g, juce::Rectangle<float> bounds,
+                                       const AnalysisSnapshot::SpectrumArray& data, juce::Colour colour, bool filled)
+{
+    const auto path = createSpectrumPath (bounds, data);
+    
+    if (filled)
     {
         // 闭合路径填充
         juce::Path fillPath (path);
@@ -172,6 +213,72 @@ void SpectrumComponent::drawSpectrum (juce::Graphics& g, juce::Rectangle<float>
     g.strokePath (path, juce::PathStrokeType (filled ? 1.5f : 2.0f));
 }
 
+void SpectrumComponent::drawPeaks (juce::Graphics& g, juce::Rectangle<float> bounds,
+                                   const AnalysisSnapshot::SpectrumArray& data, juce::Colour colour)
+{
+    g.setColour (colour.withAlpha (0.35f));
+    g.strokePath (createSpectrumPath (bounds, data), juce::PathStrokeType (1.0f));
+}
+
+void SpectrumComponent::drawPercentiles (juce::Graphics& g, juce::Rectangle<float> bounds, juce::Colour colour)
+{
+    // 10..90 百分位之间的阴影：沿 high 走过去，再沿 low 走回来
+    auto band = createSpectrumPath (bounds, targetHigh);
+    
+    for (int i = AnalysisSnapshot::kSpectrumPoints - 1; i >= 0; --i)
+    {
+        float x = bounds.getX() + pointPositions[(size_t) i] * bounds.getWidth();
+        float db = juce::jlimit (-60.0f, 0.0f, targetLow[(size_t) i]);
+        band.lineTo (x, juce::jmap (db, 0.0f, -60.0f, bounds.getY(), bounds.getBottom()));
+    }
+    
+    band.closeSubPath();
+    g.setColour (colour.withAlpha (0.12f));
+    g.fillPath (band);
+    
+    // 中位数
+    juce::Path dashed;
+    const float dashes[] = { 4.0f, 3.0f };
+    juce::PathStrokeType (1.0f).createDashedStroke (dashed, createSpectrumPath (bounds, targetMedian), dashes, 2);
+    g.setColour (colour.withAlpha (0.7f));
+    g.fillPath (dashed);
+}
+
+void SpectrumComponent::drawBands (juce::Graphics& g, juce::Rectangle<float> bounds,
+                                   const AnalysisSnapshot::BandArray& bands, juce::Colour colour)
+{
+    juce::Path path;
+    bool pathStarted = false;
+    
+    for (size_t b = 0; b < bands.size(); ++b)
+    {
+        const float freq = bandCentreHz[b];
+        
+        if (freq < 20.0f || freq > 20000.0f)
+            continue;
+        
+        float x = bounds.getX() + frequencyToX (freq, bounds.getWidth());
+        
+        // 和显示谱同样的 dBFS 刻度
+        float db = bands[b] > 0.0f ? 20.0f * std::log10 (bands[b] / AnalysisSnapshot::kSpectrumFullScale) : -60.0f;
+        db = juce::jlimit (-60.0f, 0.0f, db);
+        float y = juce::jmap (db, 0.0f, -60.0f, bounds.getY(), bounds.getBottom());
+        
+        if (! pathStarted)
+        {
+            path.startNewSubPath (x, y);
+            pathStarted = true;
+        }
+        else
+        {
+            path.lineTo (x, y);
+        }
+    }
+    
+    g.setColour (colour);
+    g.strokePath (path, juce::PathStrokeType (2.5f, juce::PathStrokeType::curved));
+}
+
 void SpectrumComponent::drawFrequencyLabels (juce::Graphics& g, juce::Rectangle<float> bounds)
 {
     g.setColour (juce::Colours::grey);
@@ -4,6 +4,8 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <array>
 
+#include "AnalysisSnapshot.h"
+
 class SpectrumComponent : public juce::Component
 {
 public:
@@ -13,22 +15,41 @@ public:
     void paint (juce::Graphics& g) override;
     void resized() override;
 
-    // 设置频谱数据 (FFT 结果，通常是 512 或 1024 个 bin)
-    void setSpectrumData (const std::array<float, 512>& data);
-    void setTargetSpectrumData (const std::array<float, 512>& data);
+    // 设置频谱数据 (processor 算好的 1/24 倍频程 dB 显示谱，见 AnalysisSnapshot::kSpectrumPoints)
+    void setSpectrumData (const AnalysisSnapshot::SpectrumArray& levels, const AnalysisSnapshot::SpectrumArray& peaks);
+    void setTargetSpectrumData (const AnalysisSnapshot::SpectrumArray& data);
+    
+    // target 逐帧电平的 10 / 50 / 90 百分位：画成 10..90 的阴影带 + 中位数虚线
+    void setTargetPercentiles (const AnalysisSnapshot::SpectrumArray& low, const AnalysisSnapshot::SpectrumArray& median,
+                               const AnalysisSnapshot::SpectrumArray& high);
+    void setShowPercentiles (bool show);
     
     // 清除 target
     void clearTarget();
     
     // 设置是否显示 target
     void setShowTarget (bool show);
+    
+    // ERB 滤波器组包络 (平滑的感知频谱)，画在逐 bin 频谱上面
+    void setBandData (const AnalysisSnapshot::BandArray& current, const AnalysisSnapshot::BandArray& target,
+                      const AnalysisSnapshot::BandArray& centreHz);
+    void setShowBands (bool show);
 
 private:
-    std::array<float, 512> currentSpectrum {};
-    std::array<float, 512> targetSpectrum {};
+    AnalysisSnapshot::SpectrumArray currentSpectrum {};
+    AnalysisSnapshot::SpectrumArray currentPeaks {};
+    AnalysisSnapshot::SpectrumArray targetSpectrum {};
+    AnalysisSnapshot::SpectrumArray targetLow {}, targetMedian {}, targetHigh {};
+    bool showPercentiles = false;
+    AnalysisSnapshot::SpectrumArray pointPositions {};   // 每个显示点的 X (0..1)，构造时算好
     bool hasTarget = false;
     bool showTarget = true;
     
+    AnalysisSnapshot::BandArray currentBands {};
+    AnalysisSnapshot::BandArray targetBands {};
+    AnalysisSnapshot::BandArray bandCentreHz {};
+    bool showBands = false;
+    
     // 颜色
     juce::Colour currentColour { juce::Colours::cyan };
     juce::Colour targetColour { juce::Colours::orange };
@@ -36,8 +57,14 @@ private:
     
     // 绘制辅助函数
     void drawGrid (juce::Graphics& g, juce::Rectangle<float> bounds);
+    juce::Path createSpectrumPath (juce::Rectangle<float> bounds, const AnalysisSnapshot::SpectrumArray& data) const;
     void drawSpectrum (juce::Graphics& g, juce::Rectangle<float> bounds,
-                       const std::array<float, 512>& data, juce::Colour colour, bool filled);
+                       const AnalysisSnapshot::SpectrumArray& data, juce::Colour colour, bool filled);
+    void drawPeaks (juce::Graphics& g, juce::Rectangle<float> bounds,
+                    const AnalysisSnapshot::SpectrumArray& data, juce::Colour colour);
+    void drawPercentiles (juce::Graphics& g, juce::Rectangle<float> bounds, juce::Colour colour);
+    void drawBands (juce::Graphics& g, juce::Rectangle<float> bounds,
+                    const AnalysisSnapshot::BandArray& bands, juce::Colour colour);
     void drawFrequencyLabels (juce::Graphics& g, juce::Rectangle<float> bounds);
     void drawDecibelLabels (juce::Graphics& g, juce::Rectangle<float> bounds);
     
@@ -22,12 +22,61 @@ public:
                 spectrum.setShowTarget (showTargetButton.getToggleState());
             };
             
+            addAndMakeVisible (showBandsButton);
+            showBandsButton.setButtonText ("ERB Bands");
+            showBandsButton.onClick = [this]
+            {
+                spectrum.setShowBands (showBandsButton.getToggleState());
+            };
+            
+            // target 逐帧电平的 10..90 百分位范围 + 中位数
+            addAndMakeVisible (showPercentilesButton);
+            showPercentilesButton.setButtonText ("Percentiles");
+            showPercentilesButton.onClick = [this]
+            {
+                spectrum.setShowPercentiles (showPercentilesButton.getToggleState());
+            };
+            
             addAndMakeVisible (captureButton);
             captureButton.setButtonText ("Capture Target");
             captureButton.onClick = [this]
             {
                 processor.beginCaptureSeconds (2.0);
             };
+            
+            // 分析分辨率：FFT 点数 / overlap / 窗
+            const auto config = processor.getAnalysisConfig();
+            
+            for (int order = AnalysisConfig::kMinFftOrder; order <= AnalysisConfig::kMaxFftOrder; ++order)
+                fftSizeBox.addItem (juce::String (1 << order) + " pts", order);
+            
+            overlapBox.addItem ("50%", 1);
+            overlapBox.addItem ("75%", 2);
+            overlapBox.addItem ("87.5%", 3);
+            
+            windowBox.addItem ("Hann", (int) AnalysisConfig::Window::Hann + 1);
+            windowBox.addItem ("Blackman-Harris", (int) AnalysisConfig::Window::BlackmanHarris + 1);
+            windowBox.addItem ("Kaiser", (int) AnalysisConfig::Window::Kaiser + 1);
+            
+            fftSizeBox.setSelectedId (config.fftOrder, juce::dontSendNotification);
+            overlapBox.setSelectedId (config.overlap >= 0.85f ? 3 : (config.overlap >= 0.7f ? 2 : 1), juce::dontSendNotification);
+            windowBox.setSelectedId ((int) config.window + 1, juce::dontSendNotification);
+            
+            addAndMakeVisible (canonicalRateButton);
+            canonicalRateButton.setButtonText ("Analyse at 48k");
+            canonicalRateButton.setToggleState (config.resampleToCanonicalRate, juce::dontSendNotification);
+            canonicalRateButton.onClick = [this] { applyAnalysisConfig(); };
+            
+            // target 按响度差缩放后再叠在实时频谱上，只比较形状
+            addAndMakeVisible (matchLoudnessButton);
+            matchLoudnessButton.setButtonText ("Match Loudness");
+            matchLoudnessButton.onClick = [this] { lastVersion = 0; };
+            
+            for (auto* box : { &fftSizeBox, &overlapBox, &windowBox })
+            {
+                addAndMakeVisible (*box);
+                box->onChange = [this] { applyAnalysisConfig(); };
+            }
         }
         
         startTimerHz (30);  // 30 FPS 更新
@@ -49,10 +98,27 @@ public:
         
         if (isAdvanced)
         {
-            auto topBar = area.removeFromTop (35);
+            // 第一行：capture 和显示开关；第二行：分析设置
+            auto topBar = area.removeFromTop (30);
             captureButton.setBounds (topBar.removeFromLeft (120));
             topBar.removeFromLeft (10);
             showTargetButton.setBounds (topBar.removeFromLeft (120));
+            topBar.removeFromLeft (10);
+            showBandsButton.setBounds (topBar.removeFromLeft (100));
+            topBar.removeFromLeft (10);
+            showPercentilesButton.setBounds (topBar.removeFromLeft (110));
+            topBar.removeFromLeft (10);
+            matchLoudnessButton.setBounds (topBar.removeFromLeft (130));
+            
+            area.removeFromTop (5);
+            auto settingsBar = area.removeFromTop (30);
+            fftSizeBox.setBounds (settingsBar.removeFromLeft (100));
+            settingsBar.removeFromLeft (10);
+            overlapBox.setBounds (settingsBar.removeFromLeft (80));
+            settingsBar.removeFromLeft (10);
+            windowBox.setBounds (settingsBar.removeFromLeft (140));
+            settingsBar.removeFromLeft (10);
+            canonicalRateButton.setBounds (settingsBar.removeFromLeft (120));
             area.removeFromTop (10);
         }
         
@@ -61,25 +127,73 @@ public:
     
     void timerCallback() override
     {
-        // 获取频谱数据并更新
-        auto spectrumData = processor.getSpectrumData();
-        spectrum.setSpectrumData (spectrumData);
+        // 获取频谱数据并更新 (同一份 snapshot，没有新数据就不重绘)
+        const auto snapshot = processor.getSnapshot();
+        if (snapshot.version == lastVersion)
+            return;
+        
+        lastVersion = snapshot.version;
+        spectrum.setSpectrumData (snapshot.spectrum, snapshot.spectrumPeaks);
+        
+        auto targetSpectrum = snapshot.targetSpectrum;
+        auto targetLow = snapshot.targetSpectrumLow;
+        auto targetMedian = snapshot.targetSpectrumMedian;
+        auto targetHigh = snapshot.targetSpectrumHigh;
+        auto targetBands = snapshot.targetBands;
+        
+        if (matchLoudnessButton.getToggleState() && snapshot.targetReady)
+        {
+            // target 的 integrated 响度对齐到当前的 short-term 响度 (任何一边还没读数就不动)
+            const auto& current = snapshot.currentLoudness;
+            const auto& target = snapshot.targetLoudness;
+            
+            if (current.shortTermLufs > LoudnessMeter::kSilenceLufs && target.integratedLufs > LoudnessMeter::kSilenceLufs)
+            {
+                // 显示谱已经是 dB，直接平移；ERB band 还是 magnitude
+                const float offsetDb = current.shortTermLufs - target.integratedLufs;
+                for (auto* data : { &targetSpectrum, &targetLow, &targetMedian, &targetHigh })
+                    juce::FloatVectorOperations::add (data->data(), offsetDb, (int) data->size());
+                
+                juce::FloatVectorOperations::multiply (targetBands.data(), juce::Decibels::decibelsToGain (offsetDb), (int) targetBands.size());
+            }
+        }
         
-        if (processor.hasTarget())
+        spectrum.setBandData (snapshot.currentBands, targetBands, snapshot.bandCentreHz);
+        
+        if (snapshot.targetReady)
         {
-            auto targetData = processor.getTargetSpectrumData();
-            spectrum.setTargetSpectrumData (targetData);
+            spectrum.setTargetSpectrumData (targetSpectrum);
+            spectrum.setTargetPercentiles (targetLow, targetMedian, targetHigh);
         }
     }
     
     SpectrumComponent spectrum;
     
 private:
+    void applyAnalysisConfig()
+    {
+        static constexpr float kOverlaps[] = { 0.5f, 0.75f, 0.875f };
+        
+        AnalysisConfig config;
+        config.fftOrder = fftSizeBox.getSelectedId();
+        config.overlap = kOverlaps[juce::jlimit (1, 3, overlapBox.getSelectedId()) - 1];
+        config.window = (AnalysisConfig::Window) (windowBox.getSelectedId() - 1);
+        config.resampleToCanonicalRate = canonicalRateButton.getToggleState();
+        
+        processor.setAnalysisConfig (config);
+    }
+    
     AudioPluginAudioProcessor& processor;
     bool isAdvanced;
+    uint32_t lastVersion = 0;
     
     juce::ToggleButton showTargetButton;
+    juce::ToggleButton showBandsButton;
+    juce::ToggleButton showPercentilesButton;
+    juce::ToggleButton canonicalRateButton;
+    juce::ToggleButton matchLoudnessButton;
     juce::TextButton captureButton;
+    juce::ComboBox fftSizeBox, overlapBox, windowBox;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ContentComponent)
 };
@@ -92,7 +206,7 @@ SpectrumWindow::SpectrumWindow (const juce::String& name, AudioPluginAudioProces
     content = std::make_unique<ContentComponent> (processor, isAdvanced);
     setContentOwned (content.release(), true);
     
-    setSize (800, isAdvanced ? 500 : 450);
+    setSize (isAdvanced ? 960 : 800, isAdvanced ? 500 : 450);
     setResizable (true, true);
     setUsingNativeTitleBar (true);
     
@@ -109,7 +223,7 @@ void SpectrumWindow::closeButtonPressed()
     setVisible (false);
 }
 
-void SpectrumWindow::updateSpectrum (const std::array<float, 512>& current, const std::array<float, 512>& target)
+void SpectrumWindow::updateSpectrum (const AnalysisSnapshot::SpectrumArray& current, const AnalysisSnapshot::SpectrumArray& target)
 {
     // 如果需要外部更新，可以用这个方法
 }
@@ -2,6 +2,7 @@
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "SpectrumComponent.h"
+#include "AnalysisSnapshot.h"
 
 // 前向声明
 class AudioPluginAudioProcessor;
@@ -15,7 +16,7 @@ public:
     void closeButtonPressed() override;
     
     // 更新频谱数据
-    void updateSpectrum (const std::array<float, 512>& current, const std::array<float, 512>& target);
+    void updateSpectrum (const AnalysisSnapshot::SpectrumArray& current, const AnalysisSnapshot::SpectrumArray& target);
 
 private:
     class ContentComponent;
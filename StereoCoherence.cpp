@@ -0,0 +1,83 @@
+#include "StereoCoherence.h"
+
+void StereoCoherence::prepare (const std::array<FeatureExtractor::BandRange, kNumBands>& newBands,
+                               double framesPerSecond, double timeConstantSeconds)
+{
+    bandRanges = newBands;
+
+    // 泄漏积分 S = decay * S + 新帧；只看比值，所以不需要 (1 - decay) 归一化
+    decay = timeConstantSeconds > 0.0 && framesPerSecond > 0.0
+                ? std::exp (-1.0 / (timeConstantSeconds * framesPerSecond))
+                : 1.0;
+
+    reset();
+}
+
+void StereoCoherence::reset()
+{
+    bands.fill ({});
+    broadband = {};
+}
+
+void StereoCoherence::processFrame (const float* left, const float* right) noexcept
+{
+    broadband.ll *= decay;
+    broadband.rr *= decay;
+    broadband.lrRe *= decay;
+    broadband.lrIm *= decay;
+
+    for (size_t b = 0; b < (size_t) kNumBands; ++b)
+    {
+        // 一个 band 内的和用 float 累加就够了 (最多几千个 bin)，跨帧的平滑用 double
+        float ll = 0.0f, rr = 0.0f, lrRe = 0.0f, lrIm = 0.0f;
+
+        for (int k = bandRanges[b].startBin; k <= bandRanges[b].endBin; ++k)
+        {
+            const float lRe = left[2 * k],  lIm = left[2 * k + 1];
+            const float rRe = right[2 * k], rIm = right[2 * k + 1];
+
+            ll   += lRe * lRe + lIm * lIm;
+            rr   += rRe * rRe + rIm * rIm;
+            lrRe += lRe * rRe + lIm * rIm;     // L * conj (R)
+            lrIm += lIm * rRe - lRe * rIm;
+        }
+
+        auto& s = bands[b];
+        s.ll   = s.ll   * decay + ll;
+        s.rr   = s.rr   * decay + rr;
+        s.lrRe = s.lrRe * decay + lrRe;
+        s.lrIm = s.lrIm * decay + lrIm;
+
+        broadband.ll += ll;
+        broadband.rr += rr;
+        broadband.lrRe += lrRe;
+        broadband.lrIm += lrIm;
+    }
+}
+
+void StereoCoherence::getCorrelations (BandArray& out) const noexcept
+{
+    for (size_t b = 0; b < (size_t) kNumBands; ++b)
+        out[b] = correlationOf (bands[b]);
+}
+
+void StereoCoherence::getCoherences (BandArray& out) const noexcept
+{
+    for (size_t b = 0; b < (size_t) kNumBands; ++b)
+        out[b] = coherenceOf (bands[b]);
+}
+
+float StereoCoherence::correlationOf (const CrossSpectrum& s) noexcept
+{
+    const double denom = std::sqrt (s.ll * s.rr);
+
+    // 一边没信号：当成 mono (完全相关)
+    return denom > 1e-20 ? (float) juce::jlimit (-1.0, 1.0, s.lrRe / denom) : 1.0f;
+}
+
+float StereoCoherence::coherenceOf (const CrossSpectrum& s) noexcept
+{
+    const double denom = s.ll * s.rr;
+
+    return denom > 1e-40 ? (float) juce::jlimit (0.0, 1.0, (s.lrRe * s.lrRe + s.lrIm * s.lrIm) / denom) : 1.0f;
+}
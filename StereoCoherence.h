@@ -0,0 +1,56 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+
+#include "AnalysisSnapshot.h"
+#include "FeatureExtractor.h"
+
+// L/R 互谱 -> 每个频段的相关系数和相干度
+// 每帧对每个 band 累加 |L|^2、|R|^2 和 L * conj (R)，再按时间常数做指数平滑，
+// 直接复用 STFT 已经算好的 L / R 频谱，每个 bin 只多 6 次乘加。
+//   correlation = Re (Slr) / sqrt (Sll * Srr)      (-1 .. 1，反相为负)
+//   coherence   = |Slr|^2 / (Sll * Srr)            (0 .. 1，和相位差无关)
+class StereoCoherence
+{
+public:
+    static constexpr int kNumBands = AnalysisSnapshot::kEnvelopeBands;
+    using BandArray = AnalysisSnapshot::EnvelopeArray;
+
+    // 非音频线程 (不分配，worker 每次整段分析前也会调用)
+    // timeConstantSeconds <= 0：不衰减，所有帧等权累加 (整段 capture 用)
+    void prepare (const std::array<FeatureExtractor::BandRange, kNumBands>& bands,
+                  double framesPerSecond, double timeConstantSeconds);
+    void reset();
+
+    // 每帧：left / right 是 bin 0..nyquist 的 interleaved re/im
+    void processFrame (const float* left, const float* right) noexcept;
+
+    void getCorrelations (BandArray& out) const noexcept;
+    void getCoherences (BandArray& out) const noexcept;
+
+    // 所有 band 合在一起的相关系数，映射成 TimbreProfile::width
+    float getBroadbandCorrelation() const noexcept { return correlationOf (broadband); }
+    float getWidth() const noexcept                { return correlationToWidth (getBroadbandCorrelation()); }
+
+    // 相关 1 (mono) -> 0.25，0 (不相关) -> 0.75，反相 -> 1
+    static float correlationToWidth (float correlation) noexcept
+    {
+        return juce::jlimit (0.0f, 1.0f, (1.0f - correlation) * 0.5f + 0.25f);
+    }
+
+private:
+    struct CrossSpectrum
+    {
+        double ll = 0.0, rr = 0.0, lrRe = 0.0, lrIm = 0.0;
+    };
+
+    static float correlationOf (const CrossSpectrum& s) noexcept;
+    static float coherenceOf (const CrossSpectrum& s) noexcept;
+
+    std::array<FeatureExtractor::BandRange, kNumBands> bandRanges {};
+    std::array<CrossSpectrum, kNumBands> bands {};
+    CrossSpectrum broadband;
+    double decay = 1.0;
+};
@@ -0,0 +1,96 @@
+#include "StftFramer.h"
+#include "SpectralKernels.h"
+
+void StftFramer::prepare (const AnalysisConfig& config, int numChannels)
+{
+    fftSize = config.getFftSize();
+    hopSize = config.getHopSize();
+
+    jassert (fftSize > 0 && hopSize > 0 && hopSize <= fftSize);
+
+    ring.assign ((size_t) fftSize, 0.0f);
+    ringRight.assign (numChannels > 1 ? (size_t) fftSize : 0, 0.0f);
+    windowTable.assign ((size_t) fftSize, 0.0f);
+    config.fillWindowTable (windowTable.data());
+
+    reset();
+}
+
+void StftFramer::reset()
+{
+    std::fill (ring.begin(), ring.end(), 0.0f);
+    std::fill (ringRight.begin(), ringRight.end(), 0.0f);
+    writeIndex = 0;
+
+    // 第一帧要等满一个 fftSize
+    samplesUntilNextFrame = fftSize;
+}
+
+void StftFramer::writeToRing (const float* input, int numSamples) noexcept
+{
+    // numSamples <= fftSize，最多绕回一次
+    const int first = juce::jmin (numSamples, fftSize - writeIndex);
+
+    juce::FloatVectorOperations::copy (ring.data() + writeIndex, input, first);
+
+    if (numSamples > first)
+        juce::FloatVectorOperations::copy (ring.data(), input + first, numSamples - first);
+
+    writeIndex = (writeIndex + numSamples) % fftSize;
+}
+
+void StftFramer::writeToRing (const float* left, const float* right, int numSamples) noexcept
+{
+    const int first = juce::jmin (numSamples, fftSize - writeIndex);
+
+    juce::FloatVectorOperations::copy (ring.data() + writeIndex, left, first);
+    juce::FloatVectorOperations::copy (ringRight.data() + writeIndex, right, first);
+
+    if (numSamples > first)
+    {
+        juce::FloatVectorOperations::copy (ring.data(), left + first, numSamples - first);
+        juce::FloatVectorOperations::copy (ringRight.data(), right + first, numSamples - first);
+    }
+
+    writeIndex = (writeIndex + numSamples) % fftSize;
+}
+
+void StftFramer::windowFrameInto (float* frameOut) const noexcept
+{
+    // ring 从 writeIndex 开始是最老的 sample，分两段直接乘窗写出
+    const int first = fftSize - writeIndex;
+
+    juce::FloatVectorOperations::multiply (frameOut, ring.data() + writeIndex, windowTable.data(), first);
+
+    if (writeIndex > 0)
+        juce::FloatVectorOperations::multiply (frameOut + first, ring.data(), windowTable.data() + first, writeIndex);
+}
+
+void StftFramer::windowPairInto (float* frameOut) const noexcept
+{
+    // 和 windowFrameInto 一样分两段，从最老的 sample 开始，L/R 乘窗后交错写成复数
+    const int first = fftSize - writeIndex;
+
+    SpectralKernels::windowInterleave (ring.data() + writeIndex, ringRight.data() + writeIndex, windowTable.data(), frameOut, first);
+
+    if (writeIndex > 0)
+        SpectralKernels::windowInterleave (ring.data(), ringRight.data(), windowTable.data() + first, frameOut + 2 * first, writeIndex);
+}
+
+void StftFramer::splitPackedSpectrum (const float* z, int fftSize, float* leftOut, float* rightOut) noexcept
+{
+    const int nyquistBin = fftSize / 2;
+
+    for (int k = 0; k <= nyquistBin; ++k)
+    {
+        const int mirror = (fftSize - k) & (fftSize - 1);
+
+        const float zr = z[2 * k],      zi = z[2 * k + 1];
+        const float mr = z[2 * mirror], mi = z[2 * mirror + 1];
+
+        leftOut[2 * k]      = 0.5f * (zr + mr);
+        leftOut[2 * k + 1]  = 0.5f * (zi - mi);
+        rightOut[2 * k]     = 0.5f * (zi + mi);
+        rightOut[2 * k + 1] = 0.5f * (mr - zr);
+    }
+}
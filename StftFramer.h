@@ -0,0 +1,93 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <vector>
+
+#include "AnalysisConfig.h"
+
+// Block 级 STFT 分帧器
+// 整块 host buffer 写进循环 buffer，读指针跟着写指针走，不需要 memmove。
+// 每凑够一个 hop 就从 ring 直接加窗 (向量化乘法) 到 FFT 输入，
+// 一个 block 里有多个 hop (比如离线渲染 4096 samples) 时每一帧都会发出。
+// 双声道模式把 L/R 两路同步分帧，加窗后打包成一个复数帧 (re = L, im = R)，
+// 两路实信号只需要做一次复数 FFT。
+class StftFramer
+{
+public:
+    // 非音频线程调用：按配置分配 ring 和 window table (numChannels = 1 或 2)
+    void prepare (const AnalysisConfig& config, int numChannels = 1);
+    void reset();
+
+    int getFftSize() const noexcept { return fftSize; }
+    int getHopSize() const noexcept { return hopSize; }
+
+    // 音频线程：frameOut 至少 fftSize 个 float (JUCE real FFT 需要 2 * fftSize)
+    // 每出一帧，加窗后的数据写进 frameOut，然后调用 onFrame()
+    template <typename FrameCallback>
+    void process (const float* input, int numSamples, float* frameOut, FrameCallback&& onFrame)
+    {
+        while (numSamples > 0)
+        {
+            const int toWrite = juce::jmin (numSamples, samplesUntilNextFrame);
+
+            writeToRing (input, toWrite);
+            input += toWrite;
+            numSamples -= toWrite;
+            samplesUntilNextFrame -= toWrite;
+
+            if (samplesUntilNextFrame == 0)
+            {
+                windowFrameInto (frameOut);
+                onFrame();
+                samplesUntilNextFrame = hopSize;
+            }
+        }
+    }
+
+    // 音频线程 (双声道模式)：frameOut 至少 2 * fftSize 个 float，
+    // 每出一帧写入 interleaved 的 { L[i] * w[i], R[i] * w[i] }，可以直接当 Complex<float> 做 FFT
+    template <typename FrameCallback>
+    void processPair (const float* left, const float* right, int numSamples, float* frameOut, FrameCallback&& onFrame)
+    {
+        jassert (! ringRight.empty());
+
+        while (numSamples > 0)
+        {
+            const int toWrite = juce::jmin (numSamples, samplesUntilNextFrame);
+
+            writeToRing (left, right, toWrite);
+            left += toWrite;
+            right += toWrite;
+            numSamples -= toWrite;
+            samplesUntilNextFrame -= toWrite;
+
+            if (samplesUntilNextFrame == 0)
+            {
+                windowPairInto (frameOut);
+                onFrame();
+                samplesUntilNextFrame = hopSize;
+            }
+        }
+    }
+
+    // 双声道帧做完复数 FFT 之后，按共轭对称拆回两路实信号的频谱：
+    //   L[k] = (Z[k] + Z[N-k]*) / 2,   R[k] = (Z[k] - Z[N-k]*) / 2i
+    // 输出 bin 0..fftSize/2 的 interleaved re/im，和 real-only FFT 的布局一样
+    static void splitPackedSpectrum (const float* packedSpectrum, int fftSize, float* leftOut, float* rightOut) noexcept;
+
+private:
+    void writeToRing (const float* input, int numSamples) noexcept;
+    void writeToRing (const float* left, const float* right, int numSamples) noexcept;
+    void windowFrameInto (float* frameOut) const noexcept;
+    void windowPairInto (float* frameOut) const noexcept;
+
+    int fftSize = 0;
+    int hopSize = 0;
+
+    std::vector<float> ring;          // 最近 fftSize 个 sample (双声道模式下是 L)
+    std::vector<float> ringRight;     // 双声道模式的 R，单声道时为空
+    std::vector<float> windowTable;
+    int writeIndex = 0;               // 同时也是最老 sample 的位置
+    int samplesUntilNextFrame = 0;
+};
@@ -0,0 +1,321 @@
+#include "TargetAnalyser.h"
+#include "AnalysisPlan.h"
+#include "SpectralKernels.h"
+
+TargetAnalyser::TargetAnalyser() = default;
+
+void TargetAnalyser::prepare (const AnalysisConfig& newConfig, double sampleRate)
+{
+    const auto config = newConfig.withValidatedRanges();
+    analysisRate = config.getAnalysisSampleRate (sampleRate);
+    hopSize = config.getHopSize();
+    const double framesPerSecond = analysisRate / (double) hopSize;
+
+    fftSize = config.getFftSize();
+    nyquistBin = fftSize / 2;
+
+    if (fft == nullptr || fft->getSize() != fftSize)
+        fft = std::make_unique<juce::dsp::FFT> (config.fftOrder);
+
+    framer.prepare (config, 2);
+    packedFrame.assign ((size_t) fftSize * 2, 0.0f);
+    packedSpectrum.assign ((size_t) fftSize * 2, 0.0f);
+    leftBins.assign ((size_t) (nyquistBin + 1) * 2, 0.0f);
+    rightBins.assign ((size_t) (nyquistBin + 1) * 2, 0.0f);
+    midBins.assign ((size_t) (nyquistBin + 1) * 2, 0.0f);
+    currentMags.assign ((size_t) nyquistBin + 1, 0.0f);
+    currentPower.assign ((size_t) nyquistBin + 1, 0.0f);
+    cumulativePower.assign ((size_t) nyquistBin + 2, 0.0);
+
+    for (size_t ch = 0; ch < resamplers.size(); ++ch)
+    {
+        resamplers[ch].prepare (sampleRate, analysisRate);
+        resampleBuffers[ch].assign ((size_t) resamplers[ch].getMaxOutputSamples (kResampleBlockSize), 0.0f);
+    }
+
+    // 频率 bin 边界 (和 FeatureExtractor 一样的频段)
+    auto freqToBin = [&] (float hz)
+    {
+        return (int) std::round (hz * (float) fftSize / (float) analysisRate);
+    };
+
+    brightStartBin = freqToBin (4000.0f);
+    bodyStartBin   = freqToBin (100.0f);
+    bodyEndBin     = freqToBin (500.0f);
+    biteStartBin   = freqToBin (1000.0f);
+    biteEndBin     = freqToBin (4000.0f);
+    airStartBin    = freqToBin (8000.0f);
+
+    // 整段的互谱等权累加 (不衰减)；衰减时间和实时分析一样逐帧测
+    FeatureExtractor::buildLogBands (fftSize, analysisRate, logBands.data(), AnalysisSnapshot::kEnvelopeBands);
+    coherence.prepare (logBands, framesPerSecond, 0.0);
+    onsets.prepare (nyquistBin, fftSize, framesPerSecond, 0.0);
+    decay.prepare (framesPerSecond);
+    trackCoherence.prepare (logBands, framesPerSecond, AnalysisPlan::kWidthTimeConstantSeconds);
+    trackOnsets.prepare (nyquistBin, fftSize, framesPerSecond, AnalysisPlan::kOnsetWindowSeconds);
+    loudness.prepare (sampleRate, juce::AudioChannelSet::stereo());
+
+    // 频谱和实时分析走同一个多速率网格 / 点映射 / ERB 滤波器组
+    multirate.prepare (config, analysisRate);
+    lowBandMid.assign ((size_t) kResampleBlockSize, 0.0f);
+    pointMapping.prepare (multirate.getFrequencies(), multirate.getNumBins(), config.getEquivalentNoiseBins(), framesPerSecond);
+    filterbank.prepare (multirate.getFrequencies(), multirate.getNumBins(), analysisRate);
+    powerSums.assign ((size_t) multirate.getNumBins(), 0.0);
+    levelHistogram.assign ((size_t) AnalysisSnapshot::kSpectrumPoints * kHistogramBins, 0);
+
+    reset (true);
+}
+
+void TargetAnalyser::reset (bool newHasStereoImage)
+{
+    hasStereoImage = newHasStereoImage;
+
+    framer.reset();
+
+    for (auto& r : resamplers)
+        r.reset();
+
+    multirate.reset();
+    coherence.reset();
+    onsets.reset();
+    decay.reset();
+    loudness.reset();
+    trackOnsets.reset();
+    trackCoherence.reset();
+    track = nullptr;
+
+    totalBright = totalBody = totalBite = totalAir = totalNoise = 0.0;
+    frameCount = 0;
+
+    std::fill (powerSums.begin(), powerSums.end(), 0.0);
+    std::fill (levelHistogram.begin(), levelHistogram.end(), 0u);
+    spectrumFrameCount = 0;
+}
+
+void TargetAnalyser::process (const float* left, const float* right, int numSamples) noexcept
+{
+    // mono 输入时 L/R 是同一路，只算一次 (BS.1770 里 mono 就是单声道)
+    const float* raw[2] = { left, right };
+    loudness.process (raw, hasStereoImage ? 2 : 1, numSamples);
+
+    if (resamplers[0].isPassThrough())
+    {
+        processPair (left, right, numSamples);
+        return;
+    }
+
+    // 先转到分析采样率，特征和实时分析在同一个采样率上算
+    for (int offset = 0; offset < numSamples; offset += kResampleBlockSize)
+    {
+        const int n = juce::jmin (kResampleBlockSize, numSamples - offset);
+        const int numResampled = resamplers[0].process (left + offset, n, resampleBuffers[0].data());
+        resamplers[1].process (right + offset, n, resampleBuffers[1].data());
+
+        processPair (resampleBuffers[0].data(), resampleBuffers[1].data(), numResampled);
+    }
+}
+
+void TargetAnalyser::processPair (const float* left, const float* right, int numSamples) noexcept
+{
+    // 和 AnalysisPlan 一样：时域 Mid 先推进低频段，再推主分帧器
+    for (int offset = 0; offset < numSamples; offset += kResampleBlockSize)
+    {
+        const int n = juce::jmin (kResampleBlockSize, numSamples - offset);
+
+        if (multirate.isActive())
+        {
+            juce::FloatVectorOperations::add (lowBandMid.data(), left + offset, right + offset, n);
+            juce::FloatVectorOperations::multiply (lowBandMid.data(), 0.5f, n);
+            multirate.process (lowBandMid.data(), n);
+        }
+
+        framer.processPair (left + offset, right + offset, n, packedFrame.data(), [this] { processFrame(); });
+    }
+}
+
+float TargetAnalyser::getBandEnergy (int startBin, int endBin) const noexcept
+{
+    startBin = juce::jmax (1, startBin);
+    endBin = juce::jmin (nyquistBin, endBin);
+
+    return endBin >= startBin ? (float) (cumulativePower[(size_t) endBin + 1] - cumulativePower[(size_t) startBin]) : 0.0f;
+}
+
+void TargetAnalyser::processFrame() noexcept
+{
+    const float epsilon = 1e-10f;
+
+    // L/R 打包成一个复数帧，一次复数 FFT 出两路频谱
+    fft->perform (reinterpret_cast<const juce::dsp::Complex<float>*> (packedFrame.data()),
+                  reinterpret_cast<juce::dsp::Complex<float>*> (packedSpectrum.data()), false);
+
+    StftFramer::splitPackedSpectrum (packedSpectrum.data(), fftSize, leftBins.data(), rightBins.data());
+    coherence.processFrame (leftBins.data(), rightBins.data());
+
+    // 后面的特征都在 Mid = (L + R) / 2 上算
+    const int numFloats = (nyquistBin + 1) * 2;
+    juce::FloatVectorOperations::add (midBins.data(), leftBins.data(), rightBins.data(), numFloats);
+    juce::FloatVectorOperations::multiply (midBins.data(), 0.5f, numFloats);
+
+    SpectralKernels::magnitude (midBins.data() + 2, currentMags.data() + 1, nyquistBin);
+    SpectralKernels::power (midBins.data() + 2, currentPower.data() + 1, nyquistBin);
+
+    // 每帧一次前缀和，之后每个频段都是 O(1) 的差 (bin 0 恒为 0)
+    SpectralKernels::prefixSum (currentPower.data(), cumulativePower.data(), nyquistBin + 1);
+
+    const float totalEnergy = getBandEnergy (1, nyquistBin);
+    float bright = 0.0f, body = 0.0f, bite = 0.0f, air = 0.0f;
+
+    if (totalEnergy > epsilon)
+    {
+        bright = getBandEnergy (brightStartBin, nyquistBin) / totalEnergy;
+        body   = getBandEnergy (bodyStartBin, bodyEndBin) / totalEnergy;
+        bite   = getBandEnergy (biteStartBin, biteEndBin) / totalEnergy;
+        air    = getBandEnergy (airStartBin, nyquistBin) / totalEnergy;
+
+        totalBright += bright;
+        totalBody   += body;
+        totalBite   += bite;
+        totalAir    += air;
+    }
+
+    AnalysisSnapshot::EnvelopeArray logBandEnergies;
+    for (size_t b = 0; b < logBands.size(); ++b)
+        logBandEnergies[b] = getBandEnergy (logBands[b].startBin, logBands[b].endBin);
+
+    decay.processFrame (logBandEnergies.data());
+
+    // Noise: 频谱平坦度
+    const float sumLog = SpectralKernels::sumLog (currentMags.data() + 1, epsilon, nyquistBin);
+    const float sumLinear = SpectralKernels::sum (currentMags.data() + 1, nyquistBin) + epsilon * (float) nyquistBin;
+    const float geometricMean = std::exp (sumLog / (float) nyquistBin);
+    const float arithmeticMean = sumLinear / (float) nyquistBin;
+    const float noise = (arithmeticMean > epsilon) ? (geometricMean / arithmeticMean) : 0.0f;
+    totalNoise += noise;
+
+    // Motion / Bite: 音头检测和实时分析同一套，整段统计
+    onsets.processFrame (currentMags.data() + 1);
+
+    multirate.merge (currentPower.data());
+    accumulateSpectrum();
+
+    if (track != nullptr)
+        addTrackFrame (bright, body, bite, air, noise);
+
+    ++frameCount;
+}
+
+void TargetAnalyser::addTrackFrame (float bright, float body, float bite, float air, float noise) noexcept
+{
+    // 和 AnalysisPlan 实时算的 profile 一样的缩放 / 窗口，只是这里每帧单独算
+    trackOnsets.processFrame (currentMags.data() + 1);
+    trackCoherence.processFrame (leftBins.data(), rightBins.data());
+
+    TimbreProfile p;
+    p.bright = juce::jlimit (0.0f, 1.0f, bright * 3.0f);
+    p.body   = juce::jlimit (0.0f, 1.0f, body * 5.0f);
+    p.bite   = juce::jlimit (0.0f, 1.0f, bite * 4.0f) * trackOnsets.getBiteWeight();
+    p.air    = juce::jlimit (0.0f, 1.0f, air * 8.0f);
+    p.noise  = juce::jlimit (0.0f, 1.0f, noise * 2.0f);
+    p.motion = trackOnsets.getMotion();
+    p.width  = hasStereoImage ? trackCoherence.getWidth() : 0.5f;
+    p.space  = decay.hasEstimate() ? decay.getSpace()
+                                   : juce::jlimit (0.0f, 1.0f, p.air * 0.5f + (1.0f - p.motion) * 0.3f + 0.1f);
+
+    // 分帧器攒满 fftSize 个 sample 出第一帧，之后每 hop 一帧；按帧结束的时刻落格
+    const double endSeconds = (double) (fftSize + (juce::int64) frameCount * hopSize) / analysisRate;
+
+    // 低频段还没出帧时合并谱不完整，这一帧不计入谱 (frameLevels 是 accumulateSpectrum 刚算的)
+    track->addFrame (endSeconds, p, multirate.hasLowBandFrame() ? &frameLevels : nullptr);
+}
+
+void TargetAnalyser::accumulateSpectrum() noexcept
+{
+    if (! multirate.hasLowBandFrame())
+        return;
+
+    // Welch：逐 bin 的功率直接求和，getResult 时除以帧数
+    const float* merged = multirate.getPowerSpectrum();
+
+    for (size_t k = 0; k < powerSums.size(); ++k)
+        powerSums[k] += merged[k];
+
+    // 每个点这一帧的电平进直方图 (超出范围的算到两端)
+    pointMapping.computeLevels (merged, frameLevels);
+
+    for (size_t i = 0; i < frameLevels.size(); ++i)
+    {
+        const int bin = juce::jlimit (0, kHistogramBins - 1,
+                                      (int) ((frameLevels[i] - AnalysisSnapshot::kSpectrumFloorDb) / kHistogramStepDb));
+        ++levelHistogram[i * kHistogramBins + (size_t) bin];
+    }
+
+    ++spectrumFrameCount;
+}
+
+float TargetAnalyser::getPercentile (size_t point, float fraction) const noexcept
+{
+    const uint32_t* histogram = levelHistogram.data() + point * kHistogramBins;
+    const auto threshold = (uint32_t) std::ceil (fraction * (float) spectrumFrameCount);
+    uint32_t count = 0;
+
+    for (int bin = 0; bin < kHistogramBins; ++bin)
+    {
+        count += histogram[bin];
+
+        if (count >= juce::jmax (1u, threshold))
+            return AnalysisSnapshot::kSpectrumFloorDb + ((float) bin + 0.5f) * kHistogramStepDb;
+    }
+
+    return AnalysisSnapshot::kSpectrumFloorDb;
+}
+
+TargetAnalyser::Result TargetAnalyser::getResult() const
+{
+    Result result;
+    result.loudness = loudness.getReading();
+    result.numOnsets = onsets.getOnsetTimes (result.onsetTimes);
+    result.onsetDensity = onsets.getOnsetDensity();
+
+    for (auto* spectrum : { &result.spectrum, &result.spectrumLow, &result.spectrumMedian, &result.spectrumHigh })
+        spectrum->fill (AnalysisSnapshot::kSpectrumFloorDb);
+
+    if (spectrumFrameCount > 0)
+    {
+        // 平均功率谱 -> 和实时显示同样的点 / ERB band
+        std::vector<float> meanPower (powerSums.size());
+
+        for (size_t k = 0; k < powerSums.size(); ++k)
+            meanPower[k] = (float) (powerSums[k] / (double) spectrumFrameCount);
+
+        pointMapping.computeLevels (meanPower.data(), result.spectrum);
+        filterbank.process (meanPower.data(), result.bands);
+
+        for (size_t i = 0; i < (size_t) AnalysisSnapshot::kSpectrumPoints; ++i)
+        {
+            result.spectrumLow[i]    = getPercentile (i, 0.1f);
+            result.spectrumMedian[i] = getPercentile (i, 0.5f);
+            result.spectrumHigh[i]   = getPercentile (i, 0.9f);
+        }
+    }
+
+    if (frameCount == 0)
+        return result;
+
+    auto& p = result.profile;
+    const double invCount = 1.0 / (double) frameCount;
+
+    p.bright = juce::jlimit (0.0f, 1.0f, (float) (totalBright * invCount) * 3.0f);
+    p.body   = juce::jlimit (0.0f, 1.0f, (float) (totalBody * invCount) * 5.0f);
+    p.bite   = juce::jlimit (0.0f, 1.0f, (float) (totalBite * invCount) * 4.0f) * onsets.getBiteWeight();
+    p.air    = juce::jlimit (0.0f, 1.0f, (float) (totalAir * invCount) * 8.0f);
+    p.noise  = juce::jlimit (0.0f, 1.0f, (float) (totalNoise * invCount) * 2.0f);
+    p.motion = onsets.getMotion();
+    p.width  = hasStereoImage ? coherence.getWidth() : 0.5f;
+
+    // 测到了衰减就用测量值；整段里没有可用的衰减 (比如一直很密) 时退回原来的估算
+    p.space  = decay.hasEstimate() ? decay.getSpace()
+                                   : juce::jlimit (0.0f, 1.0f, p.air * 0.5f + (1.0f - p.motion) * 0.3f);
+
+    return result;
+}
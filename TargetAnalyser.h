@@ -0,0 +1,134 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "AnalysisConfig.h"
+#include "AnalysisSnapshot.h"
+#include "DecayAnalyser.h"
+#include "DisplaySpectrum.h"
+#include "ErbFilterbank.h"
+#include "FeatureExtractor.h"
+#include "LoudnessMeter.h"
+#include "MultirateSpectrum.h"
+#include "OnsetDetector.h"
+#include "PolyphaseResampler.h"
+#include "ReferenceTrack.h"
+#include "StereoCoherence.h"
+#include "StftFramer.h"
+#include "TimbreProfile.h"
+
+// 流式的 target 分析：capture 的 L/R 来一段算一段，每帧只往累加器里加，不保存音频
+//   - 音色特征：每帧的频段能量比例 / 平坦度求和，getResult 时取平均
+//   - Width：整段等权累加的 L/R 互谱 (StereoCoherence，不衰减)
+//   - Motion / Bite：OnsetDetector 整段统计；Space：DecayAnalyser 逐帧测
+//   - 响度：LoudnessMeter 在原始采样率的 L/R 上测 (不受重采样影响)
+//   - 频谱：和实时分析一样的多速率合并谱，逐 bin 累加功率 (Welch 平均)；每帧的 1/24 倍频程 dB
+//     再按点进 0.5 dB 一格的直方图，最后读出 10 / 50 / 90 百分位 (安静段 / 典型 / 响的段落)
+// 内存只和 FFT 点数有关，录 2 秒和录 5 分钟一样大；最后一段数据进来之后 getResult 马上就有结果。
+// 导入文件时可以另外挂一条 ReferenceTrack：每帧再按实时分析的时间尺度算一份 profile，按时间落格。
+class TargetAnalyser
+{
+public:
+    // 一次分析的结果：音色 + 整段响度 + 音头
+    struct Result
+    {
+        TimbreProfile profile;
+        LoudnessMeter::Reading loudness;
+        AnalysisSnapshot::OnsetArray onsetTimes {};   // 秒，从开头算 (最多最后 kMaxOnsets 个)
+        int numOnsets = 0;
+        float onsetDensity = 0.0f;                    // 个/秒
+
+        // 长时平均谱 (dBFS，和显示谱同样的点) 和每个点逐帧电平的 10 / 50 / 90 百分位
+        AnalysisSnapshot::SpectrumArray spectrum {};
+        AnalysisSnapshot::SpectrumArray spectrumLow {}, spectrumMedian {}, spectrumHigh {};
+        AnalysisSnapshot::BandArray bands {};         // 平均谱上的 ERB band (RMS magnitude)
+    };
+
+    TargetAnalyser();
+
+    // 非音频线程：按分析配置和输入采样率分配 FFT / 分帧器 / 重采样器
+    void prepare (const AnalysisConfig& config, double sampleRate);
+
+    // 开始新的一段 (不分配)：mono 输入时 width 固定 0.5，响度只算一个声道
+    void reset (bool hasStereoImage);
+
+    // 任意长度的一段 L/R (输入采样率)，不分配
+    void process (const float* left, const float* right, int numSamples) noexcept;
+
+    // 这一段每帧的 profile / 谱同时写进 track (nullptr = 不写)；reset 之后、process 之前设
+    // track 归调用方所有，写完由调用方 finalise
+    void setTrack (ReferenceTrack* newTrack) noexcept { track = newTrack; }
+
+    // 已经分析了多少帧 (0 = 还凑不满一帧，结果全是 0)
+    int getNumFrames() const noexcept { return frameCount; }
+
+    Result getResult() const;
+
+private:
+    static constexpr int kResampleBlockSize = 512;
+    static constexpr float kHistogramStepDb = 0.5f;
+    static constexpr int kHistogramBins = 240;     // kSpectrumFloorDb .. +20 dBFS
+
+    void processPair (const float* left, const float* right, int numSamples) noexcept;
+    void processFrame() noexcept;
+    void accumulateSpectrum() noexcept;
+    float getBandEnergy (int startBin, int endBin) const noexcept;
+    float getPercentile (size_t point, float fraction) const noexcept;
+    void addTrackFrame (float bright, float body, float bite, float air, float noise) noexcept;
+
+    int fftSize = 0;
+    int hopSize = 0;
+    double analysisRate = 44100.0;
+    int nyquistBin = 0;
+    bool hasStereoImage = true;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    StftFramer framer;
+    std::vector<float> packedFrame;      // 加窗后的 L + iR
+    std::vector<float> packedSpectrum;
+    std::vector<float> leftBins, rightBins;
+    std::vector<float> midBins;
+    std::vector<float> currentMags;
+    std::vector<float> currentPower;
+    std::vector<double> cumulativePower;
+
+    std::array<PolyphaseResampler, 2> resamplers;   // 输入采样率 -> 分析采样率，相同时直通
+    std::array<std::vector<float>, 2> resampleBuffers;
+
+    MultirateSpectrum multirate;
+    std::vector<float> lowBandMid;       // kResampleBlockSize 个 sample 的时域 Mid
+    DisplaySpectrum pointMapping;        // 只用它的点映射 (computeLevels)
+    ErbFilterbank filterbank;
+
+    int brightStartBin = 0;
+    int bodyStartBin = 0, bodyEndBin = 0;
+    int biteStartBin = 0, biteEndBin = 0;
+    int airStartBin = 0;
+    std::array<FeatureExtractor::BandRange, AnalysisSnapshot::kEnvelopeBands> logBands;
+
+    StereoCoherence coherence;
+    OnsetDetector onsets;
+    DecayAnalyser decay;
+    LoudnessMeter loudness;
+
+    // 逐帧累加
+    double totalBright = 0.0, totalBody = 0.0, totalBite = 0.0, totalAir = 0.0, totalNoise = 0.0;
+    int frameCount = 0;
+
+    // 频谱统计从低频段出第一帧开始 (在那之前合并谱的低频段是 0)
+    std::vector<double> powerSums;                 // 合并谱网格，逐 bin
+    std::vector<uint32_t> levelHistogram;          // kSpectrumPoints x kHistogramBins
+    AnalysisSnapshot::SpectrumArray frameLevels {};
+    int spectrumFrameCount = 0;
+
+    // ReferenceTrack 用：和实时分析一样的滑动窗口 / 平滑，给出 "这个时刻" 的 Motion / Bite / Width
+    ReferenceTrack* track = nullptr;
+    OnsetDetector trackOnsets;
+    StereoCoherence trackCoherence;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TargetAnalyser)
+};
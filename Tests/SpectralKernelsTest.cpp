@@ -0,0 +1,255 @@
+// SpectralKernels 的精度测试：本机能跑的每一套实现都和标量版本比，误差在 SpectralKernels.h 写的范围内。
+// 返回 0 = 全部通过 (ctest 用)
+#include "../SpectralKernels.h"
+
+#include <juce_core/juce_core.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    // 覆盖所有尾部长度 (0..3 / 0..7 / 0..15) 和一个整帧
+    const int kLengths[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 1025 };
+
+    int failures = 0;
+
+    void check (bool ok, const char* table, const char* kernel, int length, double error, double bound)
+    {
+        if (ok)
+            return;
+
+        ++failures;
+        std::printf ("FAIL %s %s n=%d: error %.3g > %.3g\n", table, kernel, length, error, bound);
+    }
+
+    // 谱的幅度跨几十 dB，和真实的 FFT 输出差不多
+    std::vector<float> makeSignal (juce::Random& random, int num, float minLevel = 1.0e-4f)
+    {
+        std::vector<float> v ((size_t) num);
+        for (auto& x : v)
+        {
+            const float level = minLevel * std::pow (1.0f / minLevel, random.nextFloat());
+            x = random.nextBool() ? level : -level;
+        }
+        return v;
+    }
+
+    // 求和类 kernel 的顺序不一样：误差按 sum |项| 的相对值算
+    void testReductions (const SpectralKernels::KernelTable& scalar, const SpectralKernels::KernelTable& t, juce::Random& random)
+    {
+        constexpr double kRelative = 1.0e-6;
+
+        for (int n : kLengths)
+        {
+            // 故意不对齐
+            const auto a = makeSignal (random, n + 1);
+            const auto b = makeSignal (random, n + 1);
+            const float* pa = a.data() + 1;
+            const float* pb = b.data() + 1;
+
+            double absSum = 0.0, absDot = 0.0, absDiff = 0.0;
+            for (int i = 0; i < n; ++i)
+            {
+                absSum += std::abs (pa[i]);
+                absDot += std::abs ((double) pa[i] * pb[i]);
+                absDiff += std::abs ((double) pa[i] - pb[i]);
+            }
+
+            const double eSum = std::abs ((double) t.sum (pa, n) - scalar.sum (pa, n));
+            check (eSum <= kRelative * absSum, t.name, "sum", n, eSum, kRelative * absSum);
+
+            const double eDot = std::abs ((double) t.dot (pa, pb, n) - scalar.dot (pa, pb, n));
+            check (eDot <= kRelative * absDot, t.name, "dot", n, eDot, kRelative * absDot);
+
+            const double eDiff = std::abs ((double) t.sumAbsDiff (pa, pb, n) - scalar.sumAbsDiff (pa, pb, n));
+            check (eDiff <= kRelative * absDiff, t.name, "sumAbsDiff", n, eDiff, kRelative * absDiff);
+        }
+    }
+
+    // magnitude / power：每个 bin 相对误差 1e-7 (一次 FMA 的舍入差之内)
+    void testSpectrum (const SpectralKernels::KernelTable& scalar, const SpectralKernels::KernelTable& t, juce::Random& random)
+    {
+        constexpr double kRelative = 1.0e-7;
+
+        for (int n : kLengths)
+        {
+            const auto in = makeSignal (random, 2 * n);
+            std::vector<float> expected ((size_t) n), actual ((size_t) n), re ((size_t) n), im ((size_t) n);
+
+            scalar.magnitude (in.data(), expected.data(), n);
+            t.magnitude (in.data(), actual.data(), n);
+            for (int i = 0; i < n; ++i)
+            {
+                const double e = std::abs ((double) actual[(size_t) i] - expected[(size_t) i]);
+                check (e <= kRelative * expected[(size_t) i], t.name, "magnitude", n, e, kRelative * expected[(size_t) i]);
+            }
+
+            scalar.power (in.data(), expected.data(), n);
+            t.power (in.data(), actual.data(), n);
+            for (int i = 0; i < n; ++i)
+            {
+                const double e = std::abs ((double) actual[(size_t) i] - expected[(size_t) i]);
+                check (e <= kRelative * expected[(size_t) i], t.name, "power", n, e, kRelative * expected[(size_t) i]);
+            }
+
+            // 只是搬数据：必须完全一样
+            t.deinterleave (in.data(), re.data(), im.data(), n);
+            for (int i = 0; i < n; ++i)
+                check (re[(size_t) i] == in[(size_t) (2 * i)] && im[(size_t) i] == in[(size_t) (2 * i + 1)],
+                       t.name, "deinterleave", n, 1.0, 0.0);
+
+            // 每个输出只有一次乘法：也必须完全一样
+            const auto window = makeSignal (random, n);
+            std::vector<float> packed ((size_t) (2 * n));
+            t.windowInterleave (re.data(), im.data(), window.data(), packed.data(), n);
+            for (int i = 0; i < n; ++i)
+                check (packed[(size_t) (2 * i)] == re[(size_t) i] * window[(size_t) i]
+                           && packed[(size_t) (2 * i + 1)] == im[(size_t) i] * window[(size_t) i],
+                       t.name, "windowInterleave", n, 1.0, 0.0);
+        }
+    }
+
+    // sumLog：和 double 的 std::log 比 (标量版本本身也是近似)，每项 2e-6
+    void testSumLog (const SpectralKernels::KernelTable& t, juce::Random& random)
+    {
+        constexpr double kPerTerm = 2.0e-6;
+
+        for (int n : kLengths)
+        {
+            auto data = makeSignal (random, n, 1.0e-12f);
+            for (auto& x : data)
+                x = std::abs (x) * 1.0e4f;
+
+            const float offset = 1.0e-10f;
+            double exact = 0.0;
+            for (float x : data)
+                exact += std::log ((double) (x + offset));
+
+            const double e = std::abs ((double) t.sumLog (data.data(), offset, n) - exact);
+            // 结果本身是 float 累加：再给 float 求和的舍入留余量
+            const double bound = kPerTerm * n + 1.0e-6 * std::abs (exact);
+            check (e <= bound, t.name, "sumLog", n, e, bound);
+        }
+    }
+
+    void testInterpolate4 (const SpectralKernels::KernelTable& scalar, const SpectralKernels::KernelTable& t, juce::Random& random)
+    {
+        constexpr int kTaps = 12;
+        const auto coefficients = makeSignal (random, 4 * kTaps);
+
+        for (int n : kLengths)
+        {
+            const auto input = makeSignal (random, n + kTaps - 1);
+            std::vector<float> expected ((size_t) (4 * n)), actual ((size_t) (4 * n));
+
+            scalar.interpolate4 (coefficients.data(), input.data(), kTaps, n, expected.data());
+            t.interpolate4 (coefficients.data(), input.data(), kTaps, n, actual.data());
+
+            for (int i = 0; i < 4 * n; ++i)
+            {
+                double absTerms = 0.0;
+                for (int k = 0; k < kTaps; ++k)
+                    absTerms += std::abs ((double) coefficients[(size_t) (4 * k + i % 4)] * input[(size_t) (i / 4 + k)]);
+
+                const double e = std::abs ((double) actual[(size_t) i] - expected[(size_t) i]);
+                check (e <= 1.0e-6 * absTerms, t.name, "interpolate4", n, e, 1.0e-6 * absTerms);
+            }
+        }
+    }
+
+    void testSquaredDistances (const SpectralKernels::KernelTable& scalar, const SpectralKernels::KernelTable& t, juce::Random& random)
+    {
+        constexpr int kDims = 8;
+
+        for (int n : kLengths)
+        {
+            std::vector<std::vector<float>> columns (kDims);
+            std::vector<const float*> pointers;
+            for (auto& c : columns)
+            {
+                c.resize ((size_t) n);
+                for (auto& x : c)
+                    x = random.nextFloat();
+                pointers.push_back (c.data());
+            }
+
+            float point[kDims];
+            for (auto& x : point)
+                x = random.nextFloat();
+
+            std::vector<float> expected ((size_t) n), actual ((size_t) n);
+            scalar.squaredDistances (pointers.data(), point, kDims, expected.data(), n);
+            t.squaredDistances (pointers.data(), point, kDims, actual.data(), n);
+
+            for (int i = 0; i < n; ++i)
+            {
+                const double e = std::abs ((double) actual[(size_t) i] - expected[(size_t) i]);
+                check (e <= 1.0e-6 * expected[(size_t) i] + 1.0e-12, t.name, "squaredDistances", n, e, 1.0e-6 * expected[(size_t) i]);
+            }
+        }
+    }
+
+    // BS.1770 的 48 kHz K-weighting 系数；4 个 lane 各自和标量版本比 (x86 上运算顺序一样，应该逐位相同，
+    // 别的平台编译器可能合成 FMA，IIR 会把舍入差放大，给 1e-5 的相对误差)
+    void testBiquadCascade4 (const SpectralKernels::KernelTable& scalar, const SpectralKernels::KernelTable& t, juce::Random& random)
+    {
+        const float coefficients[10] = { 1.53512486f, -2.69169619f, 1.19839281f, -1.69065929f, 0.73248077f,
+                                         1.0f, -2.0f, 1.0f, -1.99004745f, 0.99007225f };
+
+        for (int n : kLengths)
+        {
+            std::vector<std::vector<float>> channels (4);
+            std::vector<const float*> pointers;
+            for (auto& c : channels)
+            {
+                c = makeSignal (random, n + 1);
+                pointers.push_back (c.data() + 1);
+            }
+
+            // 非零的初始状态：接着上一个 block 跑
+            float expectedState[16], actualState[16];
+            for (int i = 0; i < 16; ++i)
+                expectedState[i] = actualState[i] = random.nextFloat() - 0.5f;
+
+            double expected[4], actual[4];
+            scalar.biquadCascade4 (pointers.data(), coefficients, expectedState, expected, n);
+            t.biquadCascade4 (pointers.data(), coefficients, actualState, actual, n);
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                const double e = std::abs (actual[lane] - expected[lane]);
+                check (e <= 1.0e-5 * expected[lane] + 1.0e-12, t.name, "biquadCascade4", n, e, 1.0e-5 * expected[lane]);
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                const double e = std::abs ((double) actualState[i] - expectedState[i]);
+                check (e <= 1.0e-5 * std::abs (expectedState[i]) + 1.0e-9, t.name, "biquadCascade4 state", n, e, 1.0e-5 * std::abs (expectedState[i]));
+            }
+        }
+    }
+}
+
+int main()
+{
+    juce::Random random (1234);
+    const auto& scalar = SpectralKernels::getKernelTable (0);
+
+    for (int i = 0; i < SpectralKernels::getNumKernelTables(); ++i)
+    {
+        const auto& t = SpectralKernels::getKernelTable (i);
+        std::printf ("%s\n", t.name);
+
+        testReductions (scalar, t, random);
+        testSpectrum (scalar, t, random);
+        testSumLog (t, random);
+        testInterpolate4 (scalar, t, random);
+        testSquaredDistances (scalar, t, random);
+        testBiquadCascade4 (scalar, t, random);
+    }
+
+    std::printf ("active: %s, %d failure(s)\n", SpectralKernels::getActiveInstructionSet(), failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+
+//Timbre Compare MVP
+//8个对新手友好的维度 (0..1)
+struct TimbreProfile
+{
+    float bright = 0.0f;  // 亮度
+    float body   = 0.0f;  // 厚度(低中频)
+    float bite   = 0.0f;  // 锐度(存在感)
+    float air    = 0.0f;  // 空气感
+    float noise  = 0.0f;  // 颗粒/噪声
+    float width  = 0.0f;  // 宽度(立体声)
+    float motion = 0.0f;  // 起伏/抖动
+    float space  = 0.0f;  // 空间感(尾巴)
+
+    std::array<float, 8> toArray() const
+    {
+        return { bright, body, bite, air, noise, width, motion, space};
+    }
+};
+
+enum class TimbreDim : int
+{
+    Bright = 0, Body, Bite, Air, Noise, Width, Motion, Space
+};
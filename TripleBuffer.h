@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// 无锁 triple buffer：一个写线程、一个读线程，互不等待。
+// 写：填 getWriteBuffer()，然后 publish()
+// 读：fetch() 拿到最新发布的那一份 (没有新数据时保持上一份)，再读 getReadBuffer()
+// 读到的永远是某一次 publish 的完整内容，不会撕裂。
+template <typename T>
+class TripleBuffer
+{
+public:
+    T& getWriteBuffer() noexcept { return buffers[(size_t) writeIndex]; }
+
+    void publish() noexcept
+    {
+        writeIndex = middle.exchange (writeIndex | kNewDataBit, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // 有新数据时返回 true
+    bool fetch() noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & kNewDataBit) == 0)
+            return false;
+
+        readIndex = middle.exchange (readIndex, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const noexcept { return buffers[(size_t) readIndex]; }
+
+private:
+    static constexpr int kIndexMask  = 0x3;
+    static constexpr int kNewDataBit = 0x4;
+
+    std::array<T, 3> buffers {};
+    int writeIndex = 0;                 // 写线程私有
+    int readIndex  = 1;                 // 读线程私有
+    std::atomic<int> middle { 2 };      // 中间交换位 + 新数据标记
+};